@@ -0,0 +1,128 @@
+// Loaders for the recorded inputs in bench/corpus
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_corpus.h"
+
+std::vector<std::string> readCorpusLines(const char* name)
+{
+    std::string path = std::string(BENCH_CORPUS_DIR) + "/" + name;
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file)
+    {
+        perror(path.c_str());
+        exit(1);
+    }
+    std::vector<std::string> lines;
+    char line[512];
+    while (fgets(line, sizeof(line), file))
+    {
+        size_t len = strcspn(line, "\r\n");
+        if (len > 0 && line[0] != '#')
+        {
+            lines.push_back(std::string(line, len));
+        }
+    }
+    fclose(file);
+    return lines;
+}
+
+std::vector<uint8_t> parseHex(const std::string& hex)
+{
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2)
+    {
+        bytes.push_back((uint8_t)strtoul(hex.substr(i, 2).c_str(), nullptr, 16));
+    }
+    return bytes;
+}
+
+std::vector<CorpusCanFrame> readCanTrace(const char* name)
+{
+    std::vector<CorpusCanFrame> frames;
+    for (const std::string& line : readCorpusLines(name))
+    {
+        unsigned long long seconds, micros;
+        char id[16], data[32] = "";
+        if (sscanf(line.c_str(), "(%llu.%llu) %*s %15[0-9A-Fa-f]#%31[0-9A-Fa-f]", &seconds, &micros, id, data) < 3)
+        {
+            continue;
+        }
+        CorpusCanFrame frame;
+        frame.timeUs = seconds * 1000000 + micros;
+        frame.packetId = strtoul(id, nullptr, 16);
+        std::vector<uint8_t> bytes = parseHex(data);
+        frame.len = bytes.size() < 8 ? bytes.size() : 8;
+        memcpy(frame.data, bytes.data(), frame.len);
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+// Degrees and minutes (ddmm.mmmm) to 1e-7 degrees
+static int32_t toFixed(const char* value, const char* hemisphere)
+{
+    double raw = atof(value);
+    double degrees = floor(raw / 100) + fmod(raw, 100) / 60;
+    if (*hemisphere == 'S' || *hemisphere == 'W')
+    {
+        degrees = -degrees;
+    }
+    return (int32_t)lround(degrees * 1e7);
+}
+
+// Comma separated fields of a sentence, without the checksum
+static std::vector<std::string> splitSentence(const std::string& sentence)
+{
+    std::vector<std::string> fields;
+    std::string body = sentence.substr(1, sentence.find('*') - 1);
+    size_t start = 0;
+    for (;;)
+    {
+        size_t end = body.find(',', start);
+        fields.push_back(body.substr(start, end - start));
+        if (end == std::string::npos)
+        {
+            return fields;
+        }
+        start = end + 1;
+    }
+}
+
+std::vector<CorpusGpsFix> readNmeaFixes(const char* name)
+{
+    std::vector<CorpusGpsFix> fixes;
+    CorpusGpsFix fix = CorpusGpsFix();
+    for (const std::string& line : readCorpusLines(name))
+    {
+        std::vector<std::string> f = splitSentence(line);
+        if (f[0] == "GPGGA" && f.size() >= 10)
+        {
+            fix.fixQuality = atoi(f[6].c_str());
+            fix.satellites = atoi(f[7].c_str());
+            fix.hdop = atof(f[8].c_str());
+            fix.altitude = atof(f[9].c_str());
+        }
+        else if (f[0] == "GPRMC" && f.size() >= 10)
+        {
+            const char* time = f[1].c_str();
+            fix.hour = (time[0] - '0') * 10 + time[1] - '0';
+            fix.minute = (time[2] - '0') * 10 + time[3] - '0';
+            double seconds = atof(time + 4);
+            fix.seconds = (uint8_t)seconds;
+            fix.milliseconds = (uint16_t)lround((seconds - fix.seconds) * 1000);
+            fix.latitude = toFixed(f[3].c_str(), f[4].c_str());
+            fix.longitude = toFixed(f[5].c_str(), f[6].c_str());
+            fix.speed = atof(f[7].c_str());
+            fix.angle = atof(f[8].c_str());
+            const char* date = f[9].c_str();
+            fix.day = (date[0] - '0') * 10 + date[1] - '0';
+            fix.month = (date[2] - '0') * 10 + date[3] - '0';
+            fix.year = (date[4] - '0') * 10 + date[5] - '0';
+            fixes.push_back(fix);
+        }
+    }
+    return fixes;
+}
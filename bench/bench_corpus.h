@@ -0,0 +1,53 @@
+// Loaders for the recorded inputs in bench/corpus, shared by the benchmarks
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Directory of the corpus files, the build points it at the checkout
+#ifndef BENCH_CORPUS_DIR
+#define BENCH_CORPUS_DIR "bench/corpus"
+#endif
+
+struct CorpusCanFrame
+{
+    uint64_t timeUs;
+    uint32_t packetId;
+    uint8_t len;
+    uint8_t data[8];
+};
+
+// A fix as the GPS device reads it from Adafruit_GPS after parsing a GGA and
+// RMC pair
+struct CorpusGpsFix
+{
+    uint8_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t seconds;
+    uint16_t milliseconds;
+    int32_t latitude;
+    int32_t longitude;
+    float altitude;
+    float speed;
+    float angle;
+    float hdop;
+    uint8_t fixQuality;
+    uint8_t satellites;
+};
+
+// Non-empty lines of a corpus file without its # comments, exits if missing
+std::vector<std::string> readCorpusLines(const char* name);
+
+// Bytes of a hex string
+std::vector<uint8_t> parseHex(const std::string& hex);
+
+// Frames of a candump -L log
+std::vector<CorpusCanFrame> readCanTrace(const char* name);
+
+// Fixes of GGA and RMC sentence pairs
+std::vector<CorpusGpsFix> readNmeaFixes(const char* name);
@@ -0,0 +1,42 @@
+// Entry point of the host benchmarks. Results also go to a JSON file
+// (bench_results.json unless --benchmark_out is given), compare two runs
+// with Google Benchmark's tools/compare.py.
+//
+// Build: g++ -std=c++14 -O2 -Ihost/nrf52 -Ihost/common
+//            -DBENCH_CORPUS_DIR='"bench/corpus"' -o bench_racechrono
+//            bench/*.cpp host/nrf52/host_nrf52.cpp host/common/host_clock.cpp
+//            examples/canbus-gps-device/main/PacketIdInfo.cpp
+//            -lbenchmark -pthread
+//
+// or as part of the CMake host build
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+int main(int argc, char** argv)
+{
+    std::vector<char*> args(argv, argv + argc);
+    bool hasOut = false;
+    for (int i = 1; i < argc; i++)
+    {
+        hasOut = hasOut || strncmp(argv[i], "--benchmark_out=", 16) == 0;
+    }
+    static char out[] = "--benchmark_out=bench_results.json";
+    static char format[] = "--benchmark_out_format=json";
+    if (!hasOut)
+    {
+        args.push_back(out);
+        args.push_back(format);
+    }
+    int count = args.size();
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Host benchmarks for the GPS device's packet id lookup and throttling,
+// replaying the recorded CAN trace
+
+#include <benchmark/benchmark.h>
+#include <host_clock.hpp>
+#include "bench_corpus.h"
+#include "../examples/canbus-gps-device/main/PacketIdInfo.h"
+
+static const std::vector<CorpusCanFrame>& canTrace()
+{
+    static std::vector<CorpusCanFrame> frames = readCanTrace("can_trace.log");
+    return frames;
+}
+
+// Lookup of ids already known, as after the first second of a session
+static void BM_PacketIdInfoLookup(benchmark::State& state)
+{
+    const std::vector<CorpusCanFrame>& frames = canTrace();
+    PacketIdInfo info;
+    for (const CorpusCanFrame& frame : frames)
+    {
+        info.findItem(frame.packetId, true);
+    }
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(info.findItem(frames[i].packetId, false));
+        i = i + 1 < frames.size() ? i + 1 : 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PacketIdInfoLookup);
+
+// Lookup and throttling decision per frame, with "allow all" at 100 ms as
+// the app sets it up. Runs on virtual time at the trace's timestamps, so the
+// decisions are the ones the device would make, whatever the host's speed
+static void BM_PacketIdInfoThrottle(benchmark::State& state)
+{
+    const std::vector<CorpusCanFrame>& frames = canTrace();
+    PacketIdInfo info;
+    info.setDefaultNotifyInterval(100);
+    host_clock::use_virtual_time();
+    int64_t offsetUs = 0;
+    size_t i = 0;
+    size_t notified = 0;
+    for (auto _ : state)
+    {
+        host_clock::advance_to_us(offsetUs + (int64_t)(frames[i].timeUs - frames[0].timeUs));
+        PacketIdInfoItem* item = info.findItem(frames[i].packetId, true);
+        item->markReceived();
+        if (item->shouldNotify())
+        {
+            item->markNotified();
+            notified++;
+        }
+        if (++i == frames.size())
+        {
+            // Loop the trace as if it continued
+            offsetUs = host_clock::now_us() + 1000;
+            i = 0;
+        }
+    }
+    host_clock::use_real_time();
+    benchmark::DoNotOptimize(notified);
+    state.SetItemsProcessed(state.iterations());
+    state.counters["notified"] = benchmark::Counter((double)notified / state.iterations());
+}
+BENCHMARK(BM_PacketIdInfoThrottle);
+
+// Building the table from scratch, as after every filter change
+static void BM_PacketIdInfoFirstSeen(benchmark::State& state)
+{
+    const std::vector<CorpusCanFrame>& frames = canTrace();
+    PacketIdInfo info;
+    for (auto _ : state)
+    {
+        info.reset();
+        for (const CorpusCanFrame& frame : frames)
+        {
+            benchmark::DoNotOptimize(info.findItem(frame.packetId, true));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * frames.size());
+    state.counters["ids"] = info.getItemCount();
+}
+BENCHMARK(BM_PacketIdInfoFirstSeen);
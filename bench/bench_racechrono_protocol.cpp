@@ -0,0 +1,146 @@
+// Host benchmarks for the shared RaceChrono DIY protocol codec, fed from the
+// recorded corpora
+
+#include <string>
+#include <benchmark/benchmark.h>
+#include "bench_corpus.h"
+#include "../lib/racechrono_protocol.hpp"
+
+using namespace RaceChronoProtocol;
+
+// Every frame of the CAN trace into a notification
+static void BM_EncodeCanFrame(benchmark::State& state)
+{
+    std::vector<CorpusCanFrame> frames = readCanTrace("can_trace.log");
+    uint8_t out[CAN_FRAME_MAX];
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const CorpusCanFrame& frame = frames[i];
+        benchmark::DoNotOptimize(encode_can_frame(out, frame.packetId, frame.data, frame.len));
+        benchmark::DoNotOptimize(out);
+        i = i + 1 < frames.size() ? i + 1 : 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EncodeCanFrame);
+
+// The filter writes of a session
+static void BM_DecodeCanFilter(benchmark::State& state)
+{
+    std::vector<std::vector<uint8_t>> writes;
+    for (const std::string& line : readCorpusLines("filter_commands.txt"))
+    {
+        writes.push_back(parseHex(line));
+    }
+    CanFilterCommand command;
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(decode_can_filter(writes[i].data(), writes[i].size(), command));
+        benchmark::DoNotOptimize(command);
+        i = i + 1 < writes.size() ? i + 1 : 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeCanFilter);
+
+// Monitor value notifications of 1-4 values
+static void BM_DecodeMonitorValues(benchmark::State& state)
+{
+    std::vector<std::vector<uint8_t>> writes;
+    size_t valueCount = 0;
+    for (const std::string& line : readCorpusLines("monitor_notify.txt"))
+    {
+        writes.push_back(parseHex(line));
+        valueCount += monitor_value_count(writes.back().size());
+    }
+    int32_t values[256] = { 0 };
+    for (auto _ : state)
+    {
+        for (const std::vector<uint8_t>& write : writes)
+        {
+            size_t count = monitor_value_count(write.size());
+            for (size_t i = 0; i < count; i++)
+            {
+                values[monitor_value_id(write.data(), i)] = monitor_value_raw(write.data(), i);
+            }
+        }
+        benchmark::DoNotOptimize(values);
+    }
+    state.SetItemsProcessed(state.iterations() * valueCount);
+}
+BENCHMARK(BM_DecodeMonitorValues);
+
+// Every equation of a dashboard into config chunks
+static void BM_EncodeConfigChunks(benchmark::State& state)
+{
+    std::vector<std::string> equations = readCorpusLines("equations.txt");
+    size_t bytes = 0;
+    for (const std::string& equation : equations)
+    {
+        bytes += equation.size();
+    }
+    uint8_t out[CONFIG_CHUNK_MAX];
+    for (auto _ : state)
+    {
+        for (size_t id = 0; id < equations.size(); id++)
+        {
+            const std::string& equation = equations[id];
+            size_t chunks = config_chunk_count(MONITOR_ADD, equation.size());
+            for (size_t chunk = 0; chunk < chunks; chunk++)
+            {
+                benchmark::DoNotOptimize(encode_config_chunk(out, MONITOR_ADD, id, equation.data(), equation.size(), chunk));
+                benchmark::DoNotOptimize(out);
+            }
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_EncodeConfigChunks);
+
+// GPS main and time payloads from parsed fixes, the GPS device's work after
+// Adafruit_GPS has parsed the sentences
+static void BM_EncodeGpsFix(benchmark::State& state)
+{
+    std::vector<CorpusGpsFix> fixes = readNmeaFixes("nmea.txt");
+    uint8_t main[GPS_MAIN_LEN];
+    uint8_t time[GPS_TIME_LEN];
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const CorpusGpsFix& gps = fixes[i];
+        GpsFix fix;
+        fix.sync_bits = 1;
+        fix.time_since_hour = gps_time_since_hour(gps.minute, gps.seconds, gps.milliseconds);
+        fix.fix_quality = gps.fixQuality;
+        fix.satellites = gps.satellites;
+        fix.latitude = gps.latitude;
+        fix.longitude = gps.longitude;
+        fix.altitude = gps_altitude(gps.altitude);
+        fix.speed = gps_speed(gps.speed);
+        fix.bearing = round_positive(gps.angle * 100.0f);
+        fix.hdop = round_positive(gps.hdop * 10.0f);
+        fix.vdop = GPS_DOP_UNKNOWN;
+        benchmark::DoNotOptimize(encode_gps_main(main, fix));
+        benchmark::DoNotOptimize(encode_gps_time(time, 1, gps_date_and_hour(gps.year, gps.month, gps.day, gps.hour)));
+        benchmark::DoNotOptimize(main);
+        benchmark::DoNotOptimize(time);
+        i = i + 1 < fixes.size() ? i + 1 : 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EncodeGpsFix);
+
+// Sentence to fix, a stand-in for Adafruit_GPS::parse() which is not part of
+// this tree, to see how the rest of the GPS path compares to parsing
+static void BM_ParseNmeaCorpus(benchmark::State& state)
+{
+    size_t sentences = readCorpusLines("nmea.txt").size();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(readNmeaFixes("nmea.txt"));
+    }
+    state.SetItemsProcessed(state.iterations() * sentences);
+}
+BENCHMARK(BM_ParseNmeaCorpus)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,161 @@
+/*
+ * AirtimePlanner.cpp
+ */
+#include "AirtimePlanner.h"
+
+AirtimePlanner::AirtimePlanner(PacketIdInfo* packetIdInfo) {
+    mPacketIdInfo = packetIdInfo;
+    mPriorityCount = 0;
+    mPreviousPlanMs = millis();
+    mCapacityPerSecond = 0;
+    mDemandPerSecond = 0;
+    mShareRate = 0;
+    mConnectionIntervalMs = 0;
+    mNotificationsPerEvent = 0;
+}
+
+AirtimePlanner::~AirtimePlanner() {
+}
+
+void AirtimePlanner::setLinkCapacity(uint16_t connectionIntervalMs, uint8_t notificationsPerEvent) {
+    if (connectionIntervalMs == mConnectionIntervalMs && notificationsPerEvent == mNotificationsPerEvent) {
+        return;
+    }
+    mConnectionIntervalMs = connectionIntervalMs;
+    mNotificationsPerEvent = notificationsPerEvent;
+    if (connectionIntervalMs > 0) {
+        mCapacityPerSecond = (notificationsPerEvent * 1000.f / connectionIntervalMs) * HEADROOM_PERCENT / 100.f;
+    } else {
+        mCapacityPerSecond = 0;
+    }
+    plan();
+}
+
+bool AirtimePlanner::setPriority(uint32_t packetId, uint8_t weight) {
+    for (int i = 0; i < mPriorityCount; i++) {
+        if (mPriorityIds[i] == packetId) {
+            mPriorityWeights[i] = weight;
+            return true;
+        }
+    }
+    if (mPriorityCount >= PLANNER_PRIORITIES_MAX) {
+        return false;
+    }
+    mPriorityIds[mPriorityCount] = packetId;
+    mPriorityWeights[mPriorityCount] = weight;
+    mPriorityCount++;
+    return true;
+}
+
+uint8_t AirtimePlanner::getPriority(uint32_t packetId) {
+    for (int i = 0; i < mPriorityCount; i++) {
+        if (mPriorityIds[i] == packetId) {
+            return max((uint8_t)1, mPriorityWeights[i]);
+        }
+    }
+    return 1;
+}
+
+float AirtimePlanner::getAllowedRate(PacketIdInfoItem* item, float shareRate) {
+    float rate = item->getObservedRate();
+    if (item->isExplicit()) {
+        // Requested by the app, the interval is not ours to change
+        uint16_t intervalMs = item->getNotifyInterval();
+        return intervalMs > 0 ? min(rate, 1000.f / intervalMs) : rate;
+    }
+    return shareRate > 0 ? min(rate, getPriority(item->getPacketId()) * shareRate) : rate;
+}
+
+void AirtimePlanner::loop() {
+    if (millis() - mPreviousPlanMs >= PLAN_PERIOD_MS) {
+        plan();
+    }
+}
+
+void AirtimePlanner::plan() {
+    uint32_t ms = millis();
+    uint32_t elapsedMs = ms - mPreviousPlanMs;
+    mPreviousPlanMs = ms;
+
+    // Measure rates, and what is left for default packet ids after the explicit ones
+    float demand = 0;
+    float remaining = mCapacityPerSecond;
+    for (uint32_t hashValue = 0; hashValue < MAP_HASH_SIZE; hashValue++) {
+        for (PacketIdInfoItem* item = mPacketIdInfo->getChain(hashValue); item; item = item->getNextItem()) {
+            item->updateObservedRate(elapsedMs);
+            demand += item->getObservedRate();
+            if (item->isExplicit()) {
+                remaining -= getAllowedRate(item, 0);
+            }
+        }
+    }
+    mDemandPerSecond = demand;
+
+    // Weighted max-min fair share: packet ids below their share keep their full rate,
+    // the rest split what remains by weight. Repeat until the share settles.
+    float shareRate = 0;
+    if (demand > mCapacityPerSecond && mCapacityPerSecond > 0) {
+        for (int pass = 0; pass < 16; pass++) {
+            float satisfiedRate = 0;
+            uint32_t weightSum = 0;
+            for (uint32_t hashValue = 0; hashValue < MAP_HASH_SIZE; hashValue++) {
+                for (PacketIdInfoItem* item = mPacketIdInfo->getChain(hashValue); item; item = item->getNextItem()) {
+                    if (item->isExplicit()) {
+                        continue;
+                    }
+                    uint8_t weight = getPriority(item->getPacketId());
+                    if (shareRate > 0 && item->getObservedRate() <= weight * shareRate) {
+                        satisfiedRate += item->getObservedRate();
+                    } else {
+                        weightSum += weight;
+                    }
+                }
+            }
+            if (weightSum == 0) {
+                break;
+            }
+            float nextShareRate = max(0.1f, (remaining - satisfiedRate) / weightSum);
+            if (nextShareRate <= shareRate) {
+                break;
+            }
+            shareRate = nextShareRate;
+        }
+    }
+    mShareRate = shareRate;
+
+    // Apply planned intervals, never faster than the app asked for
+    uint16_t defaultIntervalMs = mPacketIdInfo->getDefaultNotifyInterval();
+    for (uint32_t hashValue = 0; hashValue < MAP_HASH_SIZE; hashValue++) {
+        for (PacketIdInfoItem* item = mPacketIdInfo->getChain(hashValue); item; item = item->getNextItem()) {
+            if (item->isExplicit()) {
+                continue;
+            }
+            uint16_t intervalMs = defaultIntervalMs;
+            float allowedRate = getAllowedRate(item, shareRate);
+            if (allowedRate > 0 && allowedRate < item->getObservedRate()) {
+                intervalMs = max((float)intervalMs, ceilf(1000.f / allowedRate));
+            }
+            item->setNotifyInterval(intervalMs);
+        }
+    }
+}
+
+void AirtimePlanner::printPlan(Print& out) {
+    out.print("Plan capacity/s ");
+    out.print(mCapacityPerSecond);
+    out.print(" demand/s ");
+    out.print(mDemandPerSecond);
+    out.print(" share/s ");
+    out.println(mShareRate);
+    for (uint32_t hashValue = 0; hashValue < MAP_HASH_SIZE; hashValue++) {
+        for (PacketIdInfoItem* item = mPacketIdInfo->getChain(hashValue); item; item = item->getNextItem()) {
+            out.print("  PID ");
+            out.print(item->getPacketId());
+            out.print(" rate/s ");
+            out.print(item->getObservedRate());
+            out.print(" interval ms ");
+            out.print(item->getNotifyInterval());
+            out.println(item->isExplicit() ? " (app)" : "");
+        }
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * AirtimePlanner.h
+ */
+
+#ifndef AIRTIMEPLANNER_H_
+#define AIRTIMEPLANNER_H_
+#ifdef __cplusplus
+
+#include <Arduino.h>
+#include "PacketIdInfo.h"
+
+static const uint8_t PLANNER_PRIORITIES_MAX = 16;
+
+class AirtimePlanner {
+public:
+    AirtimePlanner(PacketIdInfo* packetIdInfo);
+    virtual ~AirtimePlanner();
+
+    // Set link capacity, re-plans if it changed
+    void setLinkCapacity(uint16_t connectionIntervalMs, uint8_t notificationsPerEvent);
+
+    // Set packet id weight, higher weight gets a larger share when the link is saturated (default 1)
+    bool setPriority(uint32_t packetId, uint8_t weight);
+
+    // Measure frame rates and apply planned intervals, call from loop()
+    void loop();
+
+    // Measure frame rates since the previous plan and apply new intervals
+    void plan();
+
+    // Print the current plan
+    void printPlan(Print& out);
+
+    // Get sustainable notifications per second for CAN
+    float getCapacityPerSecond() { return mCapacityPerSecond; }
+
+    // Get observed frames per second over all packet ids
+    float getDemandPerSecond() { return mDemandPerSecond; }
+
+    // Get rate per unit of weight given to throttled packet ids (0 = nothing throttled)
+    float getShareRate() { return mShareRate; }
+
+private:
+    // Get weight for packet id
+    uint8_t getPriority(uint32_t packetId);
+
+    // Get rate a packet id uses when given its share of the link
+    float getAllowedRate(PacketIdInfoItem* item, float shareRate);
+
+private:
+    static const uint16_t PLAN_PERIOD_MS = 2000;
+    static const uint8_t HEADROOM_PERCENT = 80;
+
+    PacketIdInfo* mPacketIdInfo;
+    uint32_t mPriorityIds[PLANNER_PRIORITIES_MAX];
+    uint8_t mPriorityWeights[PLANNER_PRIORITIES_MAX];
+    uint8_t mPriorityCount;
+    uint32_t mPreviousPlanMs;
+    float mCapacityPerSecond;
+    float mDemandPerSecond;
+    float mShareRate;
+    uint16_t mConnectionIntervalMs;
+    uint8_t mNotificationsPerEvent;
+};
+
+#endif
+#endif
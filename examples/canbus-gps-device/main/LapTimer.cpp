@@ -0,0 +1,219 @@
+/*
+ * LapTimer.cpp
+ */
+#include <math.h>
+#include "LapTimer.h"
+
+// Meters per 1e-7 degrees of latitude
+static const float METERS_PER_UNIT = 0.0111319f;
+
+LapTimer::LapTimer() {
+    reset();
+}
+
+LapTimer::~LapTimer() {
+}
+
+void LapTimer::reset() {
+    mHasLine = false;
+    mLineX = 0;
+    mLineY = 0;
+    mLineDx = 0;
+    mLineDy = 0;
+    mOriginLatitude = 0;
+    mOriginLongitude = 0;
+    mMetersPerLongitude = METERS_PER_UNIT;
+    mDirection = 0;
+    mHasFix = false;
+    mPreviousMs = 0;
+    mPreviousX = 0;
+    mPreviousY = 0;
+    mTiming = false;
+    mStartMs = 0;
+    mDistanceM = 0;
+    mElapsedMs = 0;
+    mHasDelta = false;
+    mDeltaMs = 0;
+    mLastLapMs = 0;
+    mBestLapMs = 0;
+    mLapCount = 0;
+    mCurrent = mPointsA;
+    mReference = mPointsB;
+    mCurrentCount = 0;
+    mReferenceCount = 0;
+    mReferenceDistanceM = 0;
+}
+
+void LapTimer::setLine(int32_t latitude1, int32_t longitude1, int32_t latitude2, int32_t longitude2) {
+    reset();
+
+    // Flat projection around the line center, good to a few cm over a track
+    mOriginLatitude = latitude1 / 2 + latitude2 / 2;
+    mOriginLongitude = longitude1 / 2 + longitude2 / 2;
+    mMetersPerLongitude = METERS_PER_UNIT * cosf(mOriginLatitude * 1e-7f * (float)M_PI / 180.f);
+    float x2, y2;
+    project(latitude1, longitude1, mLineX, mLineY);
+    project(latitude2, longitude2, x2, y2);
+    mLineDx = x2 - mLineX;
+    mLineDy = y2 - mLineY;
+    mHasLine = mLineDx != 0 || mLineDy != 0;
+}
+
+void LapTimer::project(int32_t latitude, int32_t longitude, float& x, float& y) {
+    // Subtract in integers first so floats only hold the small offsets
+    x = (float)(longitude - mOriginLongitude) * mMetersPerLongitude;
+    y = (float)(latitude - mOriginLatitude) * METERS_PER_UNIT;
+}
+
+float LapTimer::getCrossing(float x0, float y0, float x1, float y1) {
+    // Side of the line for both ends of the step, zero counts as the positive side
+    float side0 = mLineDx * (y0 - mLineY) - mLineDy * (x0 - mLineX);
+    float side1 = mLineDx * (y1 - mLineY) - mLineDy * (x1 - mLineX);
+    int8_t direction = side1 >= 0 ? 1 : -1;
+    if ((side0 >= 0 ? 1 : -1) == direction) {
+        return -1;
+    }
+
+    // Laps only count in the direction the first crossing went
+    if (mDirection != 0 && direction != mDirection) {
+        return -1;
+    }
+
+    // The crossing must be between the line end points
+    float t = side0 / (side0 - side1);
+    float crossX = x0 + t * (x1 - x0) - mLineX;
+    float crossY = y0 + t * (y1 - y0) - mLineY;
+    float along = (crossX * mLineDx + crossY * mLineDy) / (mLineDx * mLineDx + mLineDy * mLineDy);
+    if (along < 0 || along > 1) {
+        return -1;
+    }
+    mDirection = direction;
+    return t;
+}
+
+bool LapTimer::update(uint32_t timeMs, int32_t latitude, int32_t longitude) {
+    if (!mHasLine) {
+        return false;
+    }
+    float x, y;
+    project(latitude, longitude, x, y);
+
+    // Stop timing over a gap, the distance driven in it is unknown
+    if (!mHasFix || timeMs - mPreviousMs > FIX_GAP_MAX_MS) {
+        mHasFix = true;
+        mTiming = false;
+        mHasDelta = false;
+        mPreviousMs = timeMs;
+        mPreviousX = x;
+        mPreviousY = y;
+        return false;
+    }
+
+    // Several sentences carry the same fix
+    if (timeMs == mPreviousMs) {
+        return false;
+    }
+
+    // Interpolate the crossing within the step between fixes
+    bool completed = false;
+    float stepM = sqrtf((x - mPreviousX) * (x - mPreviousX) + (y - mPreviousY) * (y - mPreviousY));
+    float fromM = mDistanceM;
+    float fromMs = (float)(int32_t)(mPreviousMs - mStartMs);
+    float t = getCrossing(mPreviousX, mPreviousY, x, y);
+    if (t >= 0) {
+        uint32_t crossingMs = mPreviousMs + (uint32_t)lroundf(t * (timeMs - mPreviousMs));
+        if (!mTiming) {
+            startLap(crossingMs);
+        } else if (crossingMs - mStartMs >= LAP_MIN_MS) {
+            uint32_t lapMs = crossingMs - mStartMs;
+            float lapM = mDistanceM + t * stepM;
+            recordPoints(fromM, fromMs, lapM, lapMs);
+            completeLap(lapMs, lapM);
+            startLap(crossingMs);
+            completed = true;
+        } else {
+            t = -1;
+        }
+        if (t >= 0) {
+            fromM = 0;
+            fromMs = 0;
+            mDistanceM = (1 - t) * stepM;
+        }
+    }
+    if (t < 0) {
+        mDistanceM += stepM;
+    }
+
+    // Delta against the reference at the same distance, constant work per fix
+    if (mTiming) {
+        mElapsedMs = timeMs - mStartMs;
+        recordPoints(fromM, fromMs, mDistanceM, mElapsedMs);
+        float referenceMs;
+        mHasDelta = getReferenceMs(mDistanceM, referenceMs);
+        if (mHasDelta) {
+            mDeltaMs = (int32_t)lroundf(mElapsedMs - referenceMs);
+        }
+    }
+    mPreviousMs = timeMs;
+    mPreviousX = x;
+    mPreviousY = y;
+    return completed;
+}
+
+void LapTimer::recordPoints(float fromM, float fromMs, float toM, float toMs) {
+    while (mCurrentCount < LAP_POINTS_MAX) {
+        float pointM = (float)mCurrentCount * LAP_SPACING_M;
+        if (pointM > toM) {
+            break;
+        }
+        float fraction = toM > fromM ? (pointM - fromM) / (toM - fromM) : 1;
+        mCurrent[mCurrentCount] = (uint32_t)lroundf(fromMs + fraction * (toMs - fromMs));
+        mCurrentCount++;
+    }
+}
+
+void LapTimer::completeLap(uint32_t lapMs, float distanceM) {
+    mLastLapMs = lapMs;
+    mLapCount++;
+    if (mBestLapMs == 0 || lapMs < mBestLapMs) {
+        uint32_t* points = mReference;
+        mReference = mCurrent;
+        mCurrent = points;
+        mReferenceCount = mCurrentCount;
+        mReferenceDistanceM = distanceM;
+        mBestLapMs = lapMs;
+    }
+}
+
+void LapTimer::startLap(uint32_t startMs) {
+    mTiming = true;
+    mStartMs = startMs;
+    mDistanceM = 0;
+    mCurrentCount = 0;
+    mCurrent[mCurrentCount++] = 0;
+}
+
+bool LapTimer::getReferenceMs(float distanceM, float& referenceMs) {
+    if (mReferenceCount == 0 || distanceM > mReferenceDistanceM) {
+        return false;
+    }
+
+    // Past the last sample point the lap end closes the interval
+    uint16_t index = (uint16_t)(distanceM / LAP_SPACING_M);
+    float pointM = (float)index * LAP_SPACING_M;
+    float fromMs, toMs, toM;
+    if (index + 1 < mReferenceCount) {
+        fromMs = mReference[index];
+        toMs = mReference[index + 1];
+        toM = pointM + LAP_SPACING_M;
+    } else {
+        index = mReferenceCount - 1;
+        pointM = (float)index * LAP_SPACING_M;
+        fromMs = mReference[index];
+        toMs = mBestLapMs;
+        toM = mReferenceDistanceM;
+    }
+    float fraction = toM > pointM ? (distanceM - pointM) / (toM - pointM) : 0;
+    referenceMs = fromMs + fraction * (toMs - fromMs);
+    return true;
+}
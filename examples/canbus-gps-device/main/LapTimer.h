@@ -0,0 +1,115 @@
+/*
+ * LapTimer.h
+ */
+
+#ifndef LAPTIMER_H_
+#define LAPTIMER_H_
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+// Reference lap is sampled every LAP_SPACING_M meters, long enough for a 10 km lap
+static const uint16_t LAP_POINTS_MAX = 2048;
+static const uint8_t LAP_SPACING_M = 5;
+
+class LapTimer {
+public:
+    LapTimer();
+    virtual ~LapTimer();
+
+    // Forget the line, the reference lap and the current lap
+    void reset();
+
+    // Set start/finish line from its end points, latitude and longitude in 1e-7 degrees
+    void setLine(int32_t latitude1, int32_t longitude1, int32_t latitude2, int32_t longitude2);
+
+    // Feed a GPS fix with a monotonic time, returns true when a lap was completed
+    bool update(uint32_t timeMs, int32_t latitude, int32_t longitude);
+
+    // Get whether a lap is being timed, i.e. the line was crossed since the last gap
+    bool isTiming() { return mTiming; }
+
+    // Get whether there is a reference lap to compare against
+    bool hasReference() { return mReferenceCount > 0; }
+
+    // Get whether the delta is valid for the current position
+    bool hasDelta() { return mHasDelta; }
+
+    // Get elapsed time of the current lap at the last fix
+    uint32_t getElapsedMs() { return mElapsedMs; }
+
+    // Get distance driven on the current lap at the last fix
+    float getDistanceM() { return mDistanceM; }
+
+    // Get current lap time minus the reference lap time at the same distance
+    int32_t getDeltaMs() { return mDeltaMs; }
+
+    // Get time of the last completed lap (0 = none)
+    uint32_t getLastLapMs() { return mLastLapMs; }
+
+    // Get time of the best lap, which is the reference lap (0 = none)
+    uint32_t getBestLapMs() { return mBestLapMs; }
+
+    // Get number of completed laps
+    uint16_t getLapCount() { return mLapCount; }
+
+private:
+    // Project a fix to meters east and north of the line center
+    void project(int32_t latitude, int32_t longitude, float& x, float& y);
+
+    // Get fraction of the step from (x0, y0) to (x1, y1) where it crosses the line, or -1
+    float getCrossing(float x0, float y0, float x1, float y1);
+
+    // Record the times the current lap passed the sample points between two positions
+    void recordPoints(float fromM, float fromMs, float toM, float toMs);
+
+    // Finish the current lap, it becomes the reference if it is the best one
+    void completeLap(uint32_t lapMs, float distanceM);
+
+    // Start timing a new lap at a crossing
+    void startLap(uint32_t startMs);
+
+    // Get reference lap time at a distance, interpolated between sample points
+    bool getReferenceMs(float distanceM, float& referenceMs);
+
+private:
+    static const uint32_t LAP_MIN_MS = 10000;
+    static const uint32_t FIX_GAP_MAX_MS = 2000;
+
+    bool mHasLine;
+    float mLineX;
+    float mLineY;
+    float mLineDx;
+    float mLineDy;
+    int32_t mOriginLatitude;
+    int32_t mOriginLongitude;
+    float mMetersPerLongitude;
+    int8_t mDirection;
+
+    bool mHasFix;
+    uint32_t mPreviousMs;
+    float mPreviousX;
+    float mPreviousY;
+
+    bool mTiming;
+    uint32_t mStartMs;
+    float mDistanceM;
+    uint32_t mElapsedMs;
+    bool mHasDelta;
+    int32_t mDeltaMs;
+    uint32_t mLastLapMs;
+    uint32_t mBestLapMs;
+    uint16_t mLapCount;
+
+    // Sample point times since lap start, the current and the reference lap swap on a new best
+    uint32_t mPointsA[LAP_POINTS_MAX];
+    uint32_t mPointsB[LAP_POINTS_MAX];
+    uint32_t* mCurrent;
+    uint32_t* mReference;
+    uint16_t mCurrentCount;
+    uint16_t mReferenceCount;
+    float mReferenceDistanceM;
+};
+
+#endif
+#endif
@@ -0,0 +1,101 @@
+/*
+ * MemoryStats.h
+ */
+
+#ifndef MEMORYSTATS_H_
+#define MEMORYSTATS_H_
+#ifdef __cplusplus
+
+#include <Arduino.h>
+
+//
+// Enable to count allocations made on hot paths. Replaces the global
+// operator new, so new, String and the standard containers are counted but
+// malloc() is not.
+//
+//#define MEMORY_STATS_COUNT_ALLOCATIONS
+
+//
+// Enable to halt on the first allocation made on a hot path, for debug builds
+// together with MEMORY_STATS_COUNT_ALLOCATIONS
+//
+//#define MEMORY_STATS_ALLOC_TRAP
+
+static const uint8_t MEMORY_STATS_TASKS_MAX = 4;
+static const uint32_t MEMORY_STATS_SAMPLE_MS = 1000;
+
+// Code that runs for every frame and should never allocate
+enum HotPath : uint8_t {
+    HOT_PATH_CAN_FRAME,     // Received CAN-Bus frame, logged and notified
+    HOT_PATH_DISPLAY_FRAME, // Remote display redraw
+    HOT_PATH_COUNT,
+    HOT_PATH_NONE = HOT_PATH_COUNT
+};
+
+// Marks the code between construction and destruction as a hot path. Only
+// allocations made on the task that entered it are counted.
+class HotPathScope {
+public:
+    HotPathScope(HotPath path);
+    ~HotPathScope();
+
+    HotPathScope(const HotPathScope&) = delete;
+    HotPathScope& operator=(const HotPathScope&) = delete;
+
+private:
+    HotPath mPrevious;
+    TaskHandle_t mPreviousTask;
+};
+
+class MemoryStats {
+public:
+    MemoryStats();
+    virtual ~MemoryStats();
+
+    // Watch a task's stack, nullptr for the calling task. Returns false when
+    // the table is full.
+    bool watchTask(TaskHandle_t task = nullptr);
+
+    // Sample the heap once a second, call from loop()
+    void loop();
+
+    // Get heap bytes not in use
+    uint32_t getHeapFree();
+
+    // Get lowest free heap seen by loop()
+    uint32_t getHeapMinFree() { return mHeapMinFree; }
+
+    // Get largest block malloc() can return now, found by probing
+    uint32_t getLargestFreeBlock();
+
+    // Get watched tasks
+    uint8_t getTaskCount() { return mTaskCount; }
+    const char* getTaskName(uint8_t index) { return pcTaskGetName(mTasks[index]); }
+
+    // Get bytes of a watched task's stack that were never used
+    uint32_t getStackHighWater(uint8_t index);
+
+    // Get times a hot path ran and allocations made on it, allocations are
+    // always 0 without MEMORY_STATS_COUNT_ALLOCATIONS
+    static uint32_t getHotPathRuns(HotPath path);
+    static uint32_t getHotPathAllocations(HotPath path);
+
+    // Zero the hot path counters
+    static void resetHotPaths();
+
+    // Halt on the first allocation made on a hot path, defaults to on with
+    // MEMORY_STATS_ALLOC_TRAP
+    static void setAllocTrap(bool enabled);
+
+    // Print heap, stacks and hot paths
+    void print(Print& out);
+
+private:
+    TaskHandle_t mTasks[MEMORY_STATS_TASKS_MAX];
+    uint8_t mTaskCount;
+    uint32_t mHeapMinFree;
+    uint32_t mLastSampleMs;
+};
+
+#endif
+#endif
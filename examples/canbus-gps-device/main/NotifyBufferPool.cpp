@@ -0,0 +1,44 @@
+/*
+ * NotifyBufferPool.cpp
+ */
+#include "NotifyBufferPool.h"
+
+NotifyBufferPool::NotifyBufferPool() {
+    for (int i = 0; i < NOTIFY_BUFFER_POOL_SIZE; i++) {
+        mBuffers[i].len = 0;
+        mBuffers[i].refCount = 0;
+        mFreeList[i] = &mBuffers[i];
+    }
+    mFreeCount = NOTIFY_BUFFER_POOL_SIZE;
+    mMinFreeCount = NOTIFY_BUFFER_POOL_SIZE;
+    mExhaustedCount = 0;
+}
+
+NotifyBufferPool::~NotifyBufferPool() {
+}
+
+NotifyBuffer* NotifyBufferPool::acquire() {
+    if (mFreeCount == 0) {
+        mExhaustedCount++;
+        return nullptr;
+    }
+    mFreeCount--;
+    if (mFreeCount < mMinFreeCount) {
+        mMinFreeCount = mFreeCount;
+    }
+    NotifyBuffer* buffer = mFreeList[mFreeCount];
+    buffer->len = 0;
+    buffer->refCount = 1;
+    return buffer;
+}
+
+void NotifyBufferPool::release(NotifyBuffer* buffer) {
+    if (buffer->refCount == 0) {
+        return;
+    }
+    buffer->refCount--;
+    if (buffer->refCount == 0) {
+        mFreeList[mFreeCount] = buffer;
+        mFreeCount++;
+    }
+}
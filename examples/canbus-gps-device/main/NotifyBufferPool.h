@@ -0,0 +1,52 @@
+/*
+ * NotifyBufferPool.h
+ */
+
+#ifndef NOTIFYBUFFERPOOL_H_
+#define NOTIFYBUFFERPOOL_H_
+#ifdef __cplusplus
+
+#include <Arduino.h>
+
+static const uint8_t NOTIFY_PAYLOAD_MAX = 20;
+static const uint8_t NOTIFY_BUFFER_POOL_SIZE = 16;
+
+struct NotifyBuffer {
+    uint8_t data[NOTIFY_PAYLOAD_MAX];
+    uint8_t len;
+    uint8_t refCount;
+};
+
+class NotifyBufferPool {
+public:
+    NotifyBufferPool();
+    virtual ~NotifyBufferPool();
+
+    // Get a free buffer with one reference, or nullptr if all are in use
+    NotifyBuffer* acquire();
+
+    // Add a reference to a buffer
+    void retain(NotifyBuffer* buffer) { buffer->refCount++; }
+
+    // Drop a reference, the buffer returns to the pool with the last one
+    void release(NotifyBuffer* buffer);
+
+    // Get number of free buffers
+    uint8_t getFreeCount() { return mFreeCount; }
+
+    // Get lowest number of free buffers seen
+    uint8_t getMinFreeCount() { return mMinFreeCount; }
+
+    // Get number of times acquire() found the pool empty
+    uint32_t getExhaustedCount() { return mExhaustedCount; }
+
+private:
+    NotifyBuffer mBuffers[NOTIFY_BUFFER_POOL_SIZE];
+    NotifyBuffer* mFreeList[NOTIFY_BUFFER_POOL_SIZE];
+    uint8_t mFreeCount;
+    uint8_t mMinFreeCount;
+    uint32_t mExhaustedCount;
+};
+
+#endif
+#endif
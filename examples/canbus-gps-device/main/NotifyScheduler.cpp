@@ -0,0 +1,121 @@
+/*
+ * NotifyScheduler.cpp
+ */
+#include "NotifyScheduler.h"
+
+NotifyScheduler::NotifyScheduler(NotifyBufferPool* bufferPool) {
+    mBufferPool = bufferPool;
+    // Only the latest GPS fix and time are worth sending, CAN keeps a backlog.
+    // CAN budget leaves room in every event for a GPS fix arriving mid-event.
+    mQueues[NOTIFY_CLASS_GPS_FIX].capacity = 1;
+    mQueues[NOTIFY_CLASS_GPS_FIX].budget = 1;
+    mQueues[NOTIFY_CLASS_GPS_TIME].capacity = 1;
+    mQueues[NOTIFY_CLASS_GPS_TIME].budget = 1;
+    mQueues[NOTIFY_CLASS_CAN].capacity = NOTIFY_QUEUE_MAX;
+    mQueues[NOTIFY_CLASS_CAN].budget = 3;
+    mQueues[NOTIFY_CLASS_DIAGNOSTICS].capacity = 2;
+    mQueues[NOTIFY_CLASS_DIAGNOSTICS].budget = 1;
+    mConnectionIntervalMs = 15;
+    mPromoteAfterMs = 50;
+    mEventBudget = 4;
+    for (int c = 0; c < NOTIFY_CLASS_COUNT; c++) {
+        mQueues[c].count = 0;
+    }
+    reset();
+}
+
+NotifyScheduler::~NotifyScheduler() {
+}
+
+void NotifyScheduler::reset() {
+    for (int c = 0; c < NOTIFY_CLASS_COUNT; c++) {
+        while (mQueues[c].count > 0) {
+            pop(mQueues[c]);
+        }
+        mQueues[c].head = 0;
+        mQueues[c].used = 0;
+        mQueues[c].maxLatencyMs = 0;
+        mQueues[c].dropCount = 0;
+    }
+    mEventStartMs = millis();
+    mEventUsed = 0;
+}
+
+void NotifyScheduler::pop(Queue& queue) {
+    mBufferPool->release(queue.entries[queue.head].buffer);
+    queue.head = (queue.head + 1) % queue.capacity;
+    queue.count--;
+}
+
+bool NotifyScheduler::enqueue(NotifyClass notifyClass, BLECharacteristic* characteristic, NotifyBuffer* buffer) {
+    Queue& queue = mQueues[notifyClass];
+    bool dropped = false;
+    if (queue.count >= queue.capacity) {
+        // Full, the oldest value is the least useful one
+        pop(queue);
+        queue.dropCount++;
+        dropped = true;
+    }
+    Entry& entry = queue.entries[(queue.head + queue.count) % queue.capacity];
+    entry.characteristic = characteristic;
+    entry.buffer = buffer;
+    entry.enqueuedMs = millis();
+    queue.count++;
+    return !dropped;
+}
+
+int NotifyScheduler::pickClass(uint32_t ms) {
+    int bestClass = -1;
+    int bestPriority = 0;
+    for (int c = 0; c < NOTIFY_CLASS_COUNT; c++) {
+        Queue& queue = mQueues[c];
+        if (queue.count == 0 || queue.used >= queue.budget) {
+            continue;
+        }
+
+        // Promote one class up for every promote interval spent waiting
+        uint32_t ageMs = ms - queue.entries[queue.head].enqueuedMs;
+        int priority = c - (int)(ageMs / mPromoteAfterMs);
+        if (bestClass < 0 || priority < bestPriority) {
+            bestClass = c;
+            bestPriority = priority;
+        }
+    }
+    return bestClass;
+}
+
+void NotifyScheduler::service() {
+    uint32_t ms = millis();
+    if (ms - mEventStartMs >= mConnectionIntervalMs) {
+        // New connection event, refill budgets
+        for (int c = 0; c < NOTIFY_CLASS_COUNT; c++) {
+            mQueues[c].used = 0;
+        }
+        mEventStartMs = ms;
+        mEventUsed = 0;
+    }
+
+    while (mEventUsed < mEventBudget) {
+        int c = pickClass(ms);
+        if (c < 0) {
+            return;
+        }
+        Queue& queue = mQueues[c];
+        Entry& entry = queue.entries[queue.head];
+        // The stack copies the payload, so the buffer can go back right away
+        bool sent = entry.characteristic->notify(entry.buffer->data, entry.buffer->len);
+        uint32_t enqueuedMs = entry.enqueuedMs;
+        pop(queue);
+        if (!sent) {
+            // Not connected or not subscribed, nobody wants this value
+            queue.dropCount++;
+            continue;
+        }
+        uint32_t latencyMs = ms - enqueuedMs;
+        if (latencyMs > queue.maxLatencyMs) {
+            queue.maxLatencyMs = latencyMs;
+        }
+        queue.used++;
+        mEventUsed++;
+    }
+}
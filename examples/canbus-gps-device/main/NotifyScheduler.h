@@ -0,0 +1,95 @@
+/*
+ * NotifyScheduler.h
+ */
+
+#ifndef NOTIFYSCHEDULER_H_
+#define NOTIFYSCHEDULER_H_
+#ifdef __cplusplus
+
+#include <Arduino.h>
+#include <bluefruit.h>
+#include "NotifyBufferPool.h"
+
+// Priority classes, highest priority first
+enum NotifyClass {
+    NOTIFY_CLASS_GPS_FIX = 0,
+    NOTIFY_CLASS_GPS_TIME,
+    NOTIFY_CLASS_CAN,
+    NOTIFY_CLASS_DIAGNOSTICS,
+    NOTIFY_CLASS_COUNT
+};
+
+static const uint8_t NOTIFY_QUEUE_MAX = 8;
+
+class NotifyScheduler {
+public:
+    NotifyScheduler(NotifyBufferPool* bufferPool);
+    virtual ~NotifyScheduler();
+
+    // Drop everything queued and clear the statistics
+    void reset();
+
+    // Queue a notification, takes over the caller's reference to the buffer.
+    // Returns false if an older one had to be dropped.
+    bool enqueue(NotifyClass notifyClass, BLECharacteristic* characteristic, NotifyBuffer* buffer);
+
+    // Send what the current connection event allows, call from loop()
+    void service();
+
+    // Set connection interval, starts a new budget every interval
+    void setConnectionInterval(uint16_t connectionIntervalMs) { mConnectionIntervalMs = max((uint16_t)1, connectionIntervalMs); }
+
+    // Set total notifications per connection event
+    void setEventBudget(uint8_t eventBudget) { mEventBudget = eventBudget; }
+
+    // Set notifications per connection event for one class
+    void setClassBudget(NotifyClass notifyClass, uint8_t budget) { mQueues[notifyClass].budget = budget; }
+
+    // Get notifications per connection event for one class
+    uint8_t getClassBudget(NotifyClass notifyClass) { return mQueues[notifyClass].budget; }
+
+    // Set age after which a waiting notification is promoted one class up
+    void setPromoteAfterMs(uint16_t promoteAfterMs) { mPromoteAfterMs = max((uint16_t)1, promoteAfterMs); }
+
+    // Get worst queueing latency seen for a class since reset
+    uint32_t getMaxLatencyMs(NotifyClass notifyClass) { return mQueues[notifyClass].maxLatencyMs; }
+
+    // Get number of notifications dropped for a class since reset
+    uint32_t getDropCount(NotifyClass notifyClass) { return mQueues[notifyClass].dropCount; }
+
+private:
+    struct Entry {
+        BLECharacteristic* characteristic;
+        NotifyBuffer* buffer;
+        uint32_t enqueuedMs;
+    };
+
+    struct Queue {
+        Entry entries[NOTIFY_QUEUE_MAX];
+        uint8_t head;
+        uint8_t count;
+        uint8_t capacity;
+        uint8_t budget;
+        uint8_t used;
+        uint32_t maxLatencyMs;
+        uint32_t dropCount;
+    };
+
+    // Remove the oldest entry of a queue and release its buffer
+    void pop(Queue& queue);
+
+    // Get class to send next, or -1 if nothing can be sent in this event
+    int pickClass(uint32_t ms);
+
+private:
+    NotifyBufferPool* mBufferPool;
+    Queue mQueues[NOTIFY_CLASS_COUNT];
+    uint32_t mEventStartMs;
+    uint16_t mConnectionIntervalMs;
+    uint16_t mPromoteAfterMs;
+    uint8_t mEventBudget;
+    uint8_t mEventUsed;
+};
+
+#endif
+#endif
@@ -8,6 +8,9 @@ PacketIdInfoItem::PacketIdInfoItem(uint32_t packetId, uint16_t notifyIntervalMs)
     mNextItem = nullptr;
     mPreviousNotifyMs = 0;
     mNotifyIntervalMs = notifyIntervalMs;
+    mReceivedCount = 0;
+    mObservedRate = 0;
+    mIsExplicit = false;
 }
 
 PacketIdInfoItem::~PacketIdInfoItem() {
@@ -20,24 +23,23 @@ PacketIdInfoItem::~PacketIdInfoItem() {
 PacketIdInfoItem* PacketIdInfoItem::findItem(uint32_t packetId) {
     // Find existing item
     PacketIdInfoItem* current = this;
-    PacketIdInfoItem* latest = this;
     while (current) {
         if (current->mPacketId == packetId) {
             return current;
         }
-        latest = current;
         current = current->mNextItem;
     }
     return nullptr;
 }
 
-void PacketIdInfoItem::add(PacketIdInfoItem** rootItem, uint32_t packetId, uint16_t notifyIntervalMs) {
+PacketIdInfoItem* PacketIdInfoItem::add(PacketIdInfoItem** rootItem, uint32_t packetId, uint16_t notifyIntervalMs, bool isExplicit) {
     PacketIdInfoItem* current = *rootItem;
     PacketIdInfoItem* latest = *rootItem;
     while (current) {
         if (current->mPacketId == packetId) {
             current->mNotifyIntervalMs = notifyIntervalMs;
-            return;
+            current->mIsExplicit = isExplicit;
+            return current;
         }
         latest = current;
         current = current->mNextItem;
@@ -45,6 +47,7 @@ void PacketIdInfoItem::add(PacketIdInfoItem** rootItem, uint32_t packetId, uint1
 
     // Not found, create new item
     PacketIdInfoItem* newItem = new PacketIdInfoItem(packetId, notifyIntervalMs);
+    newItem->mIsExplicit = isExplicit;
     
     // Save new item
     if (latest) {
@@ -54,6 +57,7 @@ void PacketIdInfoItem::add(PacketIdInfoItem** rootItem, uint32_t packetId, uint1
         // Created root item
         *rootItem = newItem;
     }
+    return newItem;
 }
 
 bool PacketIdInfoItem::shouldNotify() {
@@ -79,16 +83,25 @@ void PacketIdInfoItem::markNotified() {
     }
 }
 
+void PacketIdInfoItem::updateObservedRate(uint32_t elapsedMs) {
+    if (elapsedMs > 0) {
+        mObservedRate = min((uint32_t)0xFFFF, (mReceivedCount * 1000 + elapsedMs / 2) / elapsedMs);
+    }
+    mReceivedCount = 0;
+}
+
 PacketIdInfo::PacketIdInfo() {
     mItemCount = 0;  
+    mDefaultNotifyIntervalMs = 0;
     mGenericItem = new PacketIdInfoItem(0, 0);
-    for (int pos = 0; pos < MAP_HASH_SIZE; pos++) {
+    for (uint32_t pos = 0; pos < MAP_HASH_SIZE; pos++) {
         mHashMap[pos] = nullptr;
     }
 }
 
 PacketIdInfo::~PacketIdInfo() {
     reset();
+    delete mGenericItem;
 }
 
 uint32_t PacketIdInfo::getHashValue(uint32_t packetId) {
@@ -96,12 +109,13 @@ uint32_t PacketIdInfo::getHashValue(uint32_t packetId) {
 }
 
 void PacketIdInfo::reset() {
-    for (int pos = 0; pos < MAP_HASH_SIZE; pos++) {
+    for (uint32_t pos = 0; pos < MAP_HASH_SIZE; pos++) {
         if (mHashMap[pos]) {
             delete mHashMap[pos];
             mHashMap[pos] = nullptr;
         }
     }
+    mItemCount = 0;
 }
 
 PacketIdInfoItem* PacketIdInfo::findItem(uint32_t packetId, bool createIfMissing) {
@@ -118,21 +132,27 @@ PacketIdInfoItem* PacketIdInfo::findItem(uint32_t packetId, bool createIfMissing
         // Did not find, but do create
         if (mItemCount < MAP_MAX_ITEMS) {
             // Create new item
-            foundItem = new PacketIdInfoItem(packetId, mDefaultNotifyIntervalMs);
-            PacketIdInfoItem::add(rootItem, packetId, mDefaultNotifyIntervalMs);
-            return foundItem;
+            mItemCount++;
+            return PacketIdInfoItem::add(rootItem, packetId, mDefaultNotifyIntervalMs, false);
         } else {
             // Give generic item, as we do not want to run out of memory
             return mGenericItem;
         }
-        mItemCount++;
     } else {
         return nullptr;
     }
 }
 
-void PacketIdInfo::setNotifyInterval(uint32_t packetId, uint16_t notifyIntervalMs) {
+bool PacketIdInfo::setNotifyInterval(uint32_t packetId, uint16_t notifyIntervalMs) {
     uint32_t hashValue = getHashValue(packetId);
     PacketIdInfoItem** rootItem = &mHashMap[hashValue];
-    PacketIdInfoItem::add(rootItem, packetId, notifyIntervalMs);  
+    if (!(*rootItem && (*rootItem)->findItem(packetId))) {
+        if (mItemCount >= MAP_MAX_ITEMS) {
+            // Same limit as findItem(), the app cannot run us out of memory either
+            return false;
+        }
+        mItemCount++;
+    }
+    PacketIdInfoItem::add(rootItem, packetId, notifyIntervalMs, true);
+    return true;
 }
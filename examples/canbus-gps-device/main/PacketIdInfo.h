@@ -21,26 +21,47 @@ public:
     // Find a packet id info
     PacketIdInfoItem* findItem(uint32_t packetId);
 
-    // Add new packet id info
-    static void add(PacketIdInfoItem** rootItem, uint32_t packetId, uint16_t notifyIntervalMs);
+    // Add new packet id info, returns the added or updated item
+    static PacketIdInfoItem* add(PacketIdInfoItem** rootItem, uint32_t packetId, uint16_t notifyIntervalMs, bool isExplicit);
 
     // Return true if this packetId should be notified
     bool shouldNotify();
     
     // Mark packet id notified
     void markNotified();
+
+    // Mark packet id received from the bus
+    void markReceived() { if (mReceivedCount < 0xFFFF) mReceivedCount++; }
+
+    // Update observed frame rate from packets received during the elapsed time
+    void updateObservedRate(uint32_t elapsedMs);
+
+    // Get frames per second observed on the bus
+    uint16_t getObservedRate() { return mObservedRate; }
     
     // Get packet id
     uint32_t getPacketId() { return mPacketId; }
 
+    // Get next item in the same hash chain
+    PacketIdInfoItem* getNextItem() { return mNextItem; }
+
+    // Get notify interval
+    uint16_t getNotifyInterval() { return mNotifyIntervalMs; }
+
     // Set notify interval (0 = no throttling)
     void setNotifyInterval(uint16_t notifyIntervalMs) { mNotifyIntervalMs = notifyIntervalMs; }
 
+    // Return true if the interval was requested for this packet id, false if it came from the default
+    bool isExplicit() { return mIsExplicit; }
+
 private:
     uint32_t mPacketId;
     uint32_t mPreviousNotifyMs;
     PacketIdInfoItem* mNextItem;
     uint16_t mNotifyIntervalMs;
+    uint16_t mReceivedCount;
+    uint16_t mObservedRate;
+    bool mIsExplicit;
 };
 
 class PacketIdInfo {
@@ -54,12 +75,21 @@ public:
     // Create new packetId record
     PacketIdInfoItem* findItem(uint32_t packetId, bool createIfMissing);
 
-    // Add new packet id info with interval
-    void setNotifyInterval(uint32_t packetId, uint16_t notifyIntervalMs);
+    // Add new packet id info with interval, returns false if the table is full
+    bool setNotifyInterval(uint32_t packetId, uint16_t notifyIntervalMs);
 
     // Set default notify interval (0 = no throttling)
     void setDefaultNotifyInterval(uint16_t defaultNotifyIntervalMs) { mDefaultNotifyIntervalMs = defaultNotifyIntervalMs; }
 
+    // Get default notify interval
+    uint16_t getDefaultNotifyInterval() { return mDefaultNotifyIntervalMs; }
+
+    // Get number of packet id records
+    uint16_t getItemCount() { return mItemCount; }
+
+    // Get first item of a hash chain, iterate with getNextItem()
+    PacketIdInfoItem* getChain(uint32_t hashValue) { return mHashMap[hashValue]; }
+
 private:
     // Get hash value for packet id
     static uint32_t getHashValue(uint32_t packetId);
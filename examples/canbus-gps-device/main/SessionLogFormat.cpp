@@ -0,0 +1,343 @@
+/*
+ * SessionLogFormat.cpp
+ */
+#include <string.h>
+#include "SessionLogFormat.h"
+
+static const uint8_t LOG_MAGIC[4] = { 'R', 'C', 'L', '1' };
+
+// CRC-32 remainders for each nibble, small enough to keep in flash
+static const uint32_t CRC_TABLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static void putUint16(uint8_t* out, uint16_t value) {
+    out[0] = value;
+    out[1] = value >> 8;
+}
+
+static void putUint32(uint8_t* out, uint32_t value) {
+    out[0] = value;
+    out[1] = value >> 8;
+    out[2] = value >> 16;
+    out[3] = value >> 24;
+}
+
+static uint16_t getUint16(const uint8_t* in) {
+    return in[0] | (in[1] << 8);
+}
+
+static uint32_t getUint32(const uint8_t* in) {
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static uint8_t getVarintSize(uint32_t value) {
+    uint8_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+uint32_t getSessionLogCrc(const uint8_t* data, size_t len, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ CRC_TABLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC_TABLE[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+SessionLogEncoder::SessionLogEncoder() {
+    mBlock = nullptr;
+    mPos = 0;
+    mRecordCount = 0;
+    mPreviousUs = 0;
+    mRawBytes = 0;
+    mDictionaryCount = 0;
+}
+
+SessionLogEncoder::~SessionLogEncoder() {
+}
+
+void SessionLogEncoder::begin(uint8_t* block, uint32_t sequence) {
+    mBlock = block;
+    mPos = LOG_HEADER_SIZE;
+    mRecordCount = 0;
+    mPreviousUs = 0;
+    mRawBytes = 0;
+    mDictionaryCount = 0;
+    memset(mHash, 0, sizeof(mHash));
+    memset(mPreviousLen, 0xFF, sizeof(mPreviousLen));
+    putUint32(mBlock + 4, sequence);
+}
+
+int SessionLogEncoder::findId(uint32_t packetId, bool& added) {
+    added = false;
+    uint16_t slot = (packetId * 2654435761u) >> 23;
+    while (mHash[slot] != 0) {
+        if (mDictionaryIds[mHash[slot] - 1] == packetId) {
+            return mHash[slot] - 1;
+        }
+        slot = (slot + 1) % HASH_SIZE;
+    }
+
+    // New in this block, the decoder adds it at the same index while there is room
+    added = true;
+    if (mDictionaryCount >= LOG_DICTIONARY_MAX) {
+        return -1;
+    }
+    mDictionaryIds[mDictionaryCount] = packetId;
+    mDictionaryCount++;
+    mHash[slot] = mDictionaryCount;
+    return mDictionaryCount - 1;
+}
+
+bool SessionLogEncoder::addHeader(SessionLogRecordType type, uint32_t timeUs, uint8_t len) {
+    uint32_t deltaUs = mRecordCount == 0 ? 0 : timeUs - mPreviousUs;
+    if (mPos + 1 + getVarintSize(deltaUs) + 4 + len > LOG_BLOCK_SIZE) {
+        return false;
+    }
+    if (mRecordCount == 0) {
+        putUint32(mBlock + 8, timeUs);
+    }
+    mBlock[mPos++] = (type << 6) | len;
+    while (deltaUs >= 0x80) {
+        mBlock[mPos++] = (deltaUs & 0x7F) | 0x80;
+        deltaUs >>= 7;
+    }
+    mBlock[mPos++] = deltaUs;
+    mPreviousUs = timeUs;
+    mRecordCount++;
+    return true;
+}
+
+bool SessionLogEncoder::addCan(uint32_t timeUs, uint32_t packetId, const uint8_t* data, uint8_t len) {
+    if (len > LOG_PAYLOAD_MAX) {
+        len = LOG_PAYLOAD_MAX;
+    }
+
+    // Check room before touching the dictionary, a full block must stay consistent
+    uint32_t deltaUs = mRecordCount == 0 ? 0 : timeUs - mPreviousUs;
+    if (mPos + 1 + getVarintSize(deltaUs) + 4 + len > LOG_BLOCK_SIZE) {
+        return false;
+    }
+    bool added;
+    int index = findId(packetId, added);
+    mRawBytes += 9 + len;
+    if (!added && addCanDelta(timeUs, index, data, len)) {
+        return true;
+    }
+    if (added) {
+        addHeader(LOG_RECORD_CAN_NEW_ID, timeUs, len);
+        putUint32(mBlock + mPos, packetId);
+        mPos += 4;
+    } else {
+        addHeader(LOG_RECORD_CAN, timeUs, len);
+        mBlock[mPos++] = index;
+    }
+    memcpy(mBlock + mPos, data, len);
+    mPos += len;
+
+    // Following frames of this id are coded against this one
+    if (index >= 0 && len <= LOG_DELTA_PAYLOAD_MAX) {
+        memcpy(mPreviousData[index], data, len);
+        mPreviousLen[index] = len;
+    } else if (index >= 0) {
+        mPreviousLen[index] = 0xFF;
+    }
+    return true;
+}
+
+bool SessionLogEncoder::addCanDelta(uint32_t timeUs, int index, const uint8_t* data, uint8_t len) {
+    if (len > LOG_DELTA_PAYLOAD_MAX || mPreviousLen[index] != len) {
+        return false;
+    }
+
+    // Unchanged bytes cost one mask bit, so a frame repeating itself takes the mask byte only
+    uint8_t* previous = mPreviousData[index];
+    uint8_t mask = 0;
+    uint8_t changed = 0;
+    for (uint8_t i = 0; i < len; i++) {
+        if (data[i] != previous[i]) {
+            mask |= 1 << i;
+            changed++;
+        }
+    }
+    if (1 + changed >= len) {
+        return false;
+    }
+    addHeader(LOG_RECORD_CAN_DELTA, timeUs, len);
+    mBlock[mPos++] = index;
+    mBlock[mPos++] = mask;
+    for (uint8_t i = 0; i < len; i++) {
+        if (mask & (1 << i)) {
+            mBlock[mPos++] = data[i] ^ previous[i];
+            previous[i] = data[i];
+        }
+    }
+    return true;
+}
+
+bool SessionLogEncoder::addGps(uint32_t timeUs, const uint8_t* data, uint8_t len) {
+    if (len > LOG_PAYLOAD_MAX) {
+        len = LOG_PAYLOAD_MAX;
+    }
+    if (!addHeader(LOG_RECORD_GPS, timeUs, len)) {
+        return false;
+    }
+    mRawBytes += 9 + len;
+    memcpy(mBlock + mPos, data, len);
+    mPos += len;
+    return true;
+}
+
+void SessionLogEncoder::finish() {
+    memcpy(mBlock, LOG_MAGIC, sizeof(LOG_MAGIC));
+    if (mRecordCount == 0) {
+        putUint32(mBlock + 8, 0);
+    }
+    putUint16(mBlock + 12, mPos - LOG_HEADER_SIZE);
+    putUint16(mBlock + 14, mRecordCount);
+    memset(mBlock + mPos, 0, LOG_BLOCK_SIZE - mPos);
+    uint32_t crc = getSessionLogCrc(mBlock, 16);
+    crc = getSessionLogCrc(mBlock + LOG_HEADER_SIZE, mPos - LOG_HEADER_SIZE, crc);
+    putUint32(mBlock + 16, crc);
+}
+
+SessionLogDecoder::SessionLogDecoder() {
+    mBlock = nullptr;
+    mPos = 0;
+    mEnd = 0;
+    mRecordCount = 0;
+    mRecordIndex = 0;
+    mSequence = 0;
+    mTimeUs = 0;
+    mDictionaryCount = 0;
+}
+
+SessionLogDecoder::~SessionLogDecoder() {
+}
+
+bool SessionLogDecoder::begin(const uint8_t* block, size_t len) {
+    mBlock = block;
+    mPos = 0;
+    mEnd = 0;
+    mRecordCount = 0;
+    mRecordIndex = 0;
+    mDictionaryCount = 0;
+    memset(mPreviousLen, 0xFF, sizeof(mPreviousLen));
+    if (len < LOG_HEADER_SIZE || memcmp(block, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+        return false;
+    }
+    uint16_t payloadLen = getUint16(block + 12);
+    if ((size_t)LOG_HEADER_SIZE + payloadLen > len) {
+        return false;
+    }
+    uint32_t crc = getSessionLogCrc(block, 16);
+    crc = getSessionLogCrc(block + LOG_HEADER_SIZE, payloadLen, crc);
+    if (crc != getUint32(block + 16)) {
+        return false;
+    }
+    mSequence = getUint32(block + 4);
+    mTimeUs = getUint32(block + 8);
+    mRecordCount = getUint16(block + 14);
+    mPos = LOG_HEADER_SIZE;
+    mEnd = LOG_HEADER_SIZE + payloadLen;
+    return true;
+}
+
+bool SessionLogDecoder::next(SessionLogRecord& record) {
+    if (mRecordIndex >= mRecordCount || mPos >= mEnd) {
+        return false;
+    }
+    uint8_t header = mBlock[mPos++];
+    record.type = (SessionLogRecordType)(header >> 6);
+    record.len = header & 0x3F;
+
+    // Time delta
+    uint32_t deltaUs = 0;
+    for (uint8_t shift = 0; ; shift += 7) {
+        if (mPos >= mEnd || shift > 28) {
+            return false;
+        }
+        uint8_t byte = mBlock[mPos++];
+        deltaUs |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    mTimeUs += deltaUs;
+    record.timeUs = mTimeUs;
+
+    // Packet id
+    int index = -1;
+    record.packetId = 0;
+    if (record.type == LOG_RECORD_CAN || record.type == LOG_RECORD_CAN_DELTA) {
+        if (mPos >= mEnd || mBlock[mPos] >= mDictionaryCount) {
+            return false;
+        }
+        index = mBlock[mPos++];
+        record.packetId = mDictionaryIds[index];
+    } else if (record.type == LOG_RECORD_CAN_NEW_ID) {
+        if (mPos + 4 > mEnd) {
+            return false;
+        }
+        record.packetId = getUint32(mBlock + mPos);
+        mPos += 4;
+        if (mDictionaryCount < LOG_DICTIONARY_MAX) {
+            index = mDictionaryCount;
+            mDictionaryIds[mDictionaryCount++] = record.packetId;
+        }
+    }
+
+    // Changed bytes applied to the previous payload of the id
+    if (record.type == LOG_RECORD_CAN_DELTA) {
+        if (mPreviousLen[index] != record.len || mPos >= mEnd) {
+            return false;
+        }
+        uint8_t mask = mBlock[mPos++];
+        uint8_t* previous = mPreviousData[index];
+        for (uint8_t i = 0; i < LOG_DELTA_PAYLOAD_MAX; i++) {
+            if (!(mask & (1 << i))) {
+                continue;
+            }
+            if (i >= record.len || mPos >= mEnd) {
+                return false;
+            }
+            previous[i] ^= mBlock[mPos++];
+        }
+        record.type = LOG_RECORD_CAN;
+        record.data = previous;
+        mRecordIndex++;
+        return true;
+    }
+
+    // Payload
+    if (mPos + record.len > mEnd) {
+        return false;
+    }
+    record.data = mBlock + mPos;
+    mPos += record.len;
+    if (record.type != LOG_RECORD_GPS) {
+        record.type = LOG_RECORD_CAN;
+        setPrevious(index, record.data, record.len);
+    }
+    mRecordIndex++;
+    return true;
+}
+
+void SessionLogDecoder::setPrevious(int index, const uint8_t* data, uint8_t len) {
+    if (index < 0) {
+        return;
+    }
+    if (len <= LOG_DELTA_PAYLOAD_MAX) {
+        memcpy(mPreviousData[index], data, len);
+        mPreviousLen[index] = len;
+    } else {
+        mPreviousLen[index] = 0xFF;
+    }
+}
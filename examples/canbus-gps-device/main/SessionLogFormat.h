@@ -0,0 +1,149 @@
+/*
+ * SessionLogFormat.h
+ */
+
+#ifndef SESSIONLOGFORMAT_H_
+#define SESSIONLOGFORMAT_H_
+#ifdef __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// Session log, a sequence of fixed size blocks so any block can be found and
+// decoded on its own. Multi-byte fields are little-endian.
+//
+// Block header:
+//   0-3   magic "RCL1"
+//   4-7   block sequence number
+//   8-11  time of the first record in microseconds
+//   12-13 payload length
+//   14-15 record count
+//   16-19 CRC-32 of bytes 0-15 and the payload
+//
+// Record:
+//   type (bits 7-6) and payload length (bits 5-0)
+//   time since the previous record in microseconds, varint
+//   CAN: ID dictionary index, or the 32-bit ID when first seen in the block
+//   CAN delta: ID dictionary index, a mask of the bytes that changed since
+//     the previous frame of that ID in the block, then the changed bytes
+//     XORed with their previous value
+//   payload, unless it is a delta
+//
+static const uint16_t LOG_BLOCK_SIZE = 4096;
+static const uint8_t LOG_HEADER_SIZE = 20;
+static const uint8_t LOG_PAYLOAD_MAX = 63;
+static const uint8_t LOG_DICTIONARY_MAX = 255;
+static const uint8_t LOG_RECORD_SIZE_MAX = 1 + 5 + 4 + LOG_PAYLOAD_MAX;
+static const uint8_t LOG_DELTA_PAYLOAD_MAX = 8;
+
+enum SessionLogRecordType {
+    LOG_RECORD_CAN = 0,
+    LOG_RECORD_CAN_NEW_ID = 1,
+    LOG_RECORD_GPS = 2,
+    LOG_RECORD_CAN_DELTA = 3
+};
+
+struct SessionLogRecord {
+    SessionLogRecordType type;
+    uint32_t timeUs;
+    uint32_t packetId;
+    const uint8_t* data;
+    uint8_t len;
+};
+
+// Get CRC-32 (IEEE) of data, continuing from a previous result
+uint32_t getSessionLogCrc(const uint8_t* data, size_t len, uint32_t crc = 0);
+
+class SessionLogEncoder {
+public:
+    SessionLogEncoder();
+    virtual ~SessionLogEncoder();
+
+    // Start a new block in a LOG_BLOCK_SIZE buffer
+    void begin(uint8_t* block, uint32_t sequence);
+
+    // Add a CAN frame, returns false if the block is full
+    bool addCan(uint32_t timeUs, uint32_t packetId, const uint8_t* data, uint8_t len);
+
+    // Add a GPS fix as sent on the GPS main characteristic, returns false if the block is full
+    bool addGps(uint32_t timeUs, const uint8_t* data, uint8_t len);
+
+    // Write the header and zero the unused tail, the block is then ready to store
+    void finish();
+
+    // Get whether no record was added since begin()
+    bool isEmpty() { return mRecordCount == 0; }
+
+    // Get bytes used in the block including the header
+    uint16_t getUsed() { return mPos; }
+
+    // Get bytes the records added since begin() take without compression,
+    // a 32-bit time, 32-bit ID and length byte followed by the payload
+    uint32_t getRawBytes() { return mRawBytes; }
+
+private:
+    // Start a record, returns false if a record of this size may not fit
+    bool addHeader(SessionLogRecordType type, uint32_t timeUs, uint8_t len);
+
+    // Find a packet id in this block's dictionary, adds it if there is room
+    int findId(uint32_t packetId, bool& added);
+
+    // Add a CAN frame as the change from the previous frame of its id, returns false if that is not smaller
+    bool addCanDelta(uint32_t timeUs, int index, const uint8_t* data, uint8_t len);
+
+private:
+    static const uint16_t HASH_SIZE = 512;
+
+    uint8_t* mBlock;
+    uint16_t mPos;
+    uint16_t mRecordCount;
+    uint32_t mPreviousUs;
+    uint32_t mRawBytes;
+    uint32_t mDictionaryIds[LOG_DICTIONARY_MAX];
+    uint8_t mDictionaryCount;
+    // Dictionary index + 1 per hash slot, 0 = free
+    uint8_t mHash[HASH_SIZE];
+    // Previous payload per dictionary index, length 0xFF = none
+    uint8_t mPreviousData[LOG_DICTIONARY_MAX][LOG_DELTA_PAYLOAD_MAX];
+    uint8_t mPreviousLen[LOG_DICTIONARY_MAX];
+};
+
+class SessionLogDecoder {
+public:
+    SessionLogDecoder();
+    virtual ~SessionLogDecoder();
+
+    // Start decoding a block, returns false if it is not a valid block
+    bool begin(const uint8_t* block, size_t len);
+
+    // Get the next record, returns false at the end of the block or on a corrupt record.
+    // Record data stays valid until the next call.
+    bool next(SessionLogRecord& record);
+
+    // Get sequence number of the block
+    uint32_t getSequence() { return mSequence; }
+
+    // Get number of records in the block
+    uint16_t getRecordCount() { return mRecordCount; }
+
+private:
+    // Remember a payload as the previous one of its dictionary index
+    void setPrevious(int index, const uint8_t* data, uint8_t len);
+
+private:
+    const uint8_t* mBlock;
+    uint16_t mPos;
+    uint16_t mEnd;
+    uint16_t mRecordCount;
+    uint16_t mRecordIndex;
+    uint32_t mSequence;
+    uint32_t mTimeUs;
+    uint32_t mDictionaryIds[LOG_DICTIONARY_MAX];
+    uint8_t mDictionaryCount;
+    uint8_t mPreviousData[LOG_DICTIONARY_MAX][LOG_DELTA_PAYLOAD_MAX];
+    uint8_t mPreviousLen[LOG_DICTIONARY_MAX];
+};
+
+#endif
+#endif
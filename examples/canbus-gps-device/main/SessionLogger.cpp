@@ -0,0 +1,139 @@
+/*
+ * SessionLogger.cpp
+ */
+#include "SessionLogger.h"
+
+SessionLogger::SessionLogger() {
+    mOut = nullptr;
+    for (int i = 0; i < BUFFER_COUNT; i++) {
+        mFull[i] = false;
+    }
+    mFillIndex = 0;
+    mWriteIndex = 0;
+    mSequence = 0;
+    mWriterHandle = nullptr;
+    mBytesWritten = 0;
+    mWriteBusyMs = 0;
+    mMaxWriteMs = 0;
+    mMaxLogUs = 0;
+    mLogBusyUs = 0;
+    mDroppedCount = 0;
+    mRawBytes = 0;
+    mEncodedBytes = 0;
+}
+
+SessionLogger::~SessionLogger() {
+}
+
+bool SessionLogger::begin(Print* out) {
+    if (mOut) {
+        return false;
+    }
+    if (!mWriterHandle && xTaskCreate(writerTask, "log", 1024, this, TASK_PRIO_LOW, &mWriterHandle) != pdPASS) {
+        mWriterHandle = nullptr;
+        return false;
+    }
+    for (int i = 0; i < BUFFER_COUNT; i++) {
+        mFull[i] = false;
+    }
+    mFillIndex = 0;
+    mWriteIndex = 0;
+    mBytesWritten = 0;
+    mWriteBusyMs = 0;
+    mMaxWriteMs = 0;
+    mMaxLogUs = 0;
+    mLogBusyUs = 0;
+    mDroppedCount = 0;
+    mRawBytes = 0;
+    mEncodedBytes = 0;
+    mEncoder.begin(mBlocks[mFillIndex], mSequence++);
+    mOut = out;
+    return true;
+}
+
+void SessionLogger::end() {
+    if (!mOut) {
+        return;
+    }
+    if (!mEncoder.isEmpty()) {
+        while (!swap()) {
+            delay(1);
+        }
+    }
+    for (int i = 0; i < BUFFER_COUNT; i++) {
+        while (mFull[i]) {
+            delay(1);
+        }
+    }
+    mOut = nullptr;
+}
+
+bool SessionLogger::swap() {
+    uint8_t next = (mFillIndex + 1) % BUFFER_COUNT;
+    if (mFull[next]) {
+        return false;
+    }
+    mEncoder.finish();
+    mRawBytes += mEncoder.getRawBytes();
+    mEncodedBytes += mEncoder.getUsed();
+    mFull[mFillIndex] = true;
+    xTaskNotifyGive(mWriterHandle);
+    mFillIndex = next;
+    mEncoder.begin(mBlocks[mFillIndex], mSequence++);
+    return true;
+}
+
+bool SessionLogger::logCan(uint32_t timeUs, uint32_t packetId, const uint8_t* data, uint8_t len) {
+    if (!mOut) {
+        return false;
+    }
+    uint32_t startUs = micros();
+    bool logged = mEncoder.addCan(timeUs, packetId, data, len) ||
+        (swap() && mEncoder.addCan(timeUs, packetId, data, len));
+    if (!logged) {
+        mDroppedCount++;
+    }
+    uint32_t elapsedUs = micros() - startUs;
+    mLogBusyUs += elapsedUs;
+    mMaxLogUs = max(mMaxLogUs, elapsedUs);
+    return logged;
+}
+
+bool SessionLogger::logGps(uint32_t timeUs, const uint8_t* data, uint8_t len) {
+    if (!mOut) {
+        return false;
+    }
+    uint32_t startUs = micros();
+    bool logged = mEncoder.addGps(timeUs, data, len) ||
+        (swap() && mEncoder.addGps(timeUs, data, len));
+    if (!logged) {
+        mDroppedCount++;
+    }
+    uint32_t elapsedUs = micros() - startUs;
+    mLogBusyUs += elapsedUs;
+    mMaxLogUs = max(mMaxLogUs, elapsedUs);
+    return logged;
+}
+
+void SessionLogger::writerTask(void* arg) {
+    SessionLogger* logger = (SessionLogger*)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        logger->writeBlocks();
+    }
+}
+
+void SessionLogger::writeBlocks() {
+    // Flash latency only ever stalls this task, acquisition keeps filling the other buffer
+    while (mFull[mWriteIndex]) {
+        uint32_t startMs = millis();
+        mOut->write(mBlocks[mWriteIndex], LOG_BLOCK_SIZE);
+        mOut->flush();
+        uint32_t elapsedMs = millis() - startMs;
+        mBytesWritten += LOG_BLOCK_SIZE;
+        mWriteBusyMs += elapsedMs;
+        mMaxWriteMs = max(mMaxWriteMs, elapsedMs);
+        mFull[mWriteIndex] = false;
+        mWriteIndex = (mWriteIndex + 1) % BUFFER_COUNT;
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * SessionLogger.h
+ */
+
+#ifndef SESSIONLOGGER_H_
+#define SESSIONLOGGER_H_
+#ifdef __cplusplus
+
+#include <Arduino.h>
+#include "SessionLogFormat.h"
+
+class SessionLogger {
+public:
+    SessionLogger();
+    virtual ~SessionLogger();
+
+    // Start logging to an open file, blocks are written by a background task
+    bool begin(Print* out);
+
+    // Write the partial block and wait until everything is stored
+    void end();
+
+    // Get whether logging is running
+    bool isLogging() { return mOut != nullptr; }
+
+    // Log a CAN frame, never waits for storage. Returns false if it was dropped.
+    bool logCan(uint32_t timeUs, uint32_t packetId, const uint8_t* data, uint8_t len);
+
+    // Log a GPS fix, never waits for storage. Returns false if it was dropped.
+    bool logGps(uint32_t timeUs, const uint8_t* data, uint8_t len);
+
+    // Get bytes written to storage
+    uint32_t getBytesWritten() { return mBytesWritten; }
+
+    // Get bytes per second storage sustained while writing
+    uint32_t getWriteRate() { return mWriteBusyMs > 0 ? (uint64_t)mBytesWritten * 1000 / mWriteBusyMs : 0; }
+
+    // Get longest write of one block
+    uint32_t getMaxWriteMs() { return mMaxWriteMs; }
+
+    // Get longest time a log call kept acquisition waiting
+    uint32_t getMaxLogUs() { return mMaxLogUs; }
+
+    // Get number of records dropped because both buffers were waiting for storage
+    uint32_t getDroppedCount() { return mDroppedCount; }
+
+    // Get size of the encoded records in percent of their uncompressed size
+    uint8_t getCompressionPercent() { return mRawBytes > 0 ? (uint64_t)mEncodedBytes * 100 / mRawBytes : 0; }
+
+    // Get uncompressed bytes per second of CPU time spent encoding
+    uint32_t getEncodeRate() { return mLogBusyUs > 0 ? (uint64_t)mRawBytes * 1000000 / mLogBusyUs : 0; }
+
+    // Get the task writing blocks to storage, nullptr before begin()
+    TaskHandle_t getWriterTask() { return mWriterHandle; }
+
+private:
+    // Pass the filled block to the writer and continue in the other buffer,
+    // returns false if the other buffer is still being written
+    bool swap();
+
+    // Writer task entry point
+    static void writerTask(void* arg);
+
+    // Write filled blocks in order until none is left
+    void writeBlocks();
+
+private:
+    static const uint8_t BUFFER_COUNT = 2;
+
+    Print* volatile mOut;
+    SessionLogEncoder mEncoder;
+    uint8_t mBlocks[BUFFER_COUNT][LOG_BLOCK_SIZE];
+    volatile bool mFull[BUFFER_COUNT];
+    uint8_t mFillIndex;
+    uint8_t mWriteIndex;
+    uint32_t mSequence;
+    TaskHandle_t mWriterHandle;
+    uint32_t mBytesWritten;
+    uint32_t mWriteBusyMs;
+    uint32_t mMaxWriteMs;
+    uint32_t mMaxLogUs;
+    uint32_t mLogBusyUs;
+    uint32_t mDroppedCount;
+    uint32_t mRawBytes;
+    uint32_t mEncodedBytes;
+};
+
+#endif
+#endif
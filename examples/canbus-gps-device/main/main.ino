@@ -4,6 +4,13 @@
 #include <Adafruit_GPS.h>
 #include <bluefruit.h>
 #include "PacketIdInfo.h"
+#include "NotifyBufferPool.h"
+#include "NotifyScheduler.h"
+#include "AirtimePlanner.h"
+#include "LapTimer.h"
+#include "SessionLogger.h"
+#include "MemoryStats.h"
+#include "racechrono_protocol.hpp"
 
 //
 // Disable if you do not have CAN-Bus board connected
@@ -15,6 +22,33 @@
 //
 //#define HAS_GPS
 
+//
+// Enable to time laps on the device from GPS, needs HAS_GPS. The start/finish
+// line is given by its end points in 1e-7 degrees. With HAS_CAN_BUS the lap
+// time and the predictive delta are sent as packet LAP_TIMER_PACKET_ID, so the
+// app can log them next to its own delta.
+//
+//#define HAS_LAP_TIMER
+#define LAP_TIMER_LINE_LATITUDE_1 0
+#define LAP_TIMER_LINE_LONGITUDE_1 0
+#define LAP_TIMER_LINE_LATITUDE_2 0
+#define LAP_TIMER_LINE_LONGITUDE_2 0
+#define LAP_TIMER_PACKET_ID 0x7D0
+
+//
+// Enable to log every CAN frame and GPS fix to flash, so nothing is lost while
+// the app is not connected. CAN-Bus then stays up without a connection.
+//
+//#define HAS_SESSION_LOG
+#define SESSION_LOG_PATH "/session.rcl"
+
+//
+// Enable if you have an ignition sense input (high when ignition is on), used
+// to wake up advertising from the backed off interval
+//
+//#define HAS_IGNITION_SENSE
+#define IGNITION_SENSE_PIN A3
+
 #ifdef HAS_GPS
 void dummy_debug(...) {
 }
@@ -27,26 +61,49 @@ void dummy_debug(...) {
 #endif
 
 BLEService mainService = BLEService(0x00000001000000fd8933990d6f411ff8);
-uint8_t tempData[20];
 int ledState = LOW;
+NotifyBufferPool notifyBufferPool;
+NotifyScheduler notifyScheduler(&notifyBufferPool);
+// Set on the Bluefruit callback task, the scheduler and pool belong to loop(),
+// which also prints the disconnect report when it resets them
+volatile boolean notifySchedulerResetPending = false;
+MemoryStats memoryStats;
+//
+// Advertising policy, intervals in unit of 0.625 ms. Fast after boot, disconnect
+// or wake, then doubling every step up to the maximum while nobody connects.
+//
+static const uint16_t ADV_FAST_INTERVAL = 32; // 20 ms
+static const uint32_t ADV_FAST_MS = 30000;
+static const uint16_t ADV_BACKOFF_INTERVAL = 244; // 152.5 ms
+static const uint16_t ADV_MAX_INTERVAL = 3200; // 2 s
+static const uint32_t ADV_BACKOFF_STEP_MS = 60000;
+uint16_t bluetoothAdvInterval = 0;
+uint32_t bluetoothAdvPhaseStartMs = 0;
+ble_gap_addr_t bluetoothLastCentral;
+boolean bluetoothHasLastCentral = false;
+uint32_t bluetoothDisconnectMs = 0;
+uint32_t bluetoothLastReconnectMs = 0;
+uint16_t bluetoothConnHdl = BLE_CONN_HANDLE_INVALID;
 
 #ifdef HAS_CAN_BUS
-BLECharacteristic canBusMainCharacteristic   = BLECharacteristic (0x01);
-BLECharacteristic canBusFilterCharacteristic = BLECharacteristic (0x02);
+BLECharacteristic canBusMainCharacteristic   = BLECharacteristic (RaceChronoProtocol::CAN_MAIN_UUID);
+BLECharacteristic canBusFilterCharacteristic = BLECharacteristic (RaceChronoProtocol::CAN_FILTER_UUID);
 
-static const int CAN_BUS_CMD_DENY_ALL = 0;
-static const int CAN_BUS_CMD_ALLOW_ALL = 1;
-static const int CAN_BUS_CMD_ADD_PID = 2;
 PacketIdInfo canBusPacketIdInfo;
+AirtimePlanner canBusAirtimePlanner(&canBusPacketIdInfo);
 bool canBusAllowUnknownPackets = false;
 uint32_t canBusLastNotifyMs = 0;
 boolean isCanBusConnected = false;
 
 #endif
 
+#ifdef HAS_IGNITION_SENSE
+int ignitionPreviousState = LOW;
+#endif
+
 #ifdef HAS_GPS
-BLECharacteristic gpsMainCharacteristic = BLECharacteristic (0x03);
-BLECharacteristic gpsTimeCharacteristic = BLECharacteristic (0x04);
+BLECharacteristic gpsMainCharacteristic = BLECharacteristic (RaceChronoProtocol::GPS_MAIN_UUID);
+BLECharacteristic gpsTimeCharacteristic = BLECharacteristic (RaceChronoProtocol::GPS_TIME_UUID);
 
 Adafruit_GPS* gps = NULL;
 int gpsPreviousDateAndHour = 0;
@@ -54,11 +111,25 @@ uint8_t gpsSyncBits = 0;
 
 #endif
 
+#ifdef HAS_SESSION_LOG
+#include <InternalFileSystem.h>
+using namespace Adafruit_LittleFS_Namespace;
+File sessionLogFile(InternalFS);
+SessionLogger sessionLogger;
+#endif
+
+#if defined(HAS_GPS) && defined(HAS_LAP_TIMER)
+LapTimer lapTimer;
+uint32_t lapTimerPreviousDayMs = 0;
+uint32_t lapTimerTimeMs = 0;
+uint32_t lapTimerMaxUpdateUs = 0;
+#endif
+
 void bluetoothSetupMainService(void) {
     mainService.begin();
 
 #ifdef HAS_CAN_BUS
-    canBusMainCharacteristic.setProperties(CHR_PROPS_NOTIFY | CHR_PROPS_READ);
+    canBusMainCharacteristic.setProperties(CHR_PROPS_NOTIFY);
     canBusMainCharacteristic.setPermission(SECMODE_OPEN, SECMODE_NO_ACCESS);
     canBusMainCharacteristic.begin();
     canBusFilterCharacteristic.setProperties(CHR_PROPS_WRITE);
@@ -77,16 +148,149 @@ void bluetoothSetupMainService(void) {
 #endif
 }
 
+void bluetoothStartUndirectedAdvertising(uint16_t interval) {
+    Bluefruit.Advertising.stop();
+    Bluefruit.Advertising.setType(BLE_GAP_ADV_TYPE_CONNECTABLE_SCANNABLE_UNDIRECTED);
+    Bluefruit.Advertising.setStopCallback(NULL);
+    Bluefruit.Advertising.setInterval(interval, interval);
+    Bluefruit.Advertising.start(0);
+    bluetoothAdvInterval = interval;
+    bluetoothAdvPhaseStartMs = millis();
+}
+
+void bluetoothDirectedAdvertisingStopCallback(void) {
+    // The last central did not come back, fall back to undirected advertising
+    if (!Bluefruit.connected()) {
+        bluetoothStartUndirectedAdvertising(ADV_FAST_INTERVAL);
+    }
+}
+
+void bluetoothStartDirectedAdvertising(void) {
+    Bluefruit.Advertising.stop();
+    Bluefruit.Advertising.setType(BLE_GAP_ADV_TYPE_CONNECTABLE_NONSCANNABLE_DIRECTED_HIGH_DUTY_CYCLE);
+    Bluefruit.Advertising.setPeerAddress(bluetoothLastCentral);
+    Bluefruit.Advertising.setStopCallback(bluetoothDirectedAdvertisingStopCallback);
+    Bluefruit.Advertising.start(1); // High duty cycle is limited to 1.28 s by the spec
+    bluetoothAdvInterval = 0;
+}
+
+void bluetoothAdvertisingLoop() {
+    // Back off exponentially while nobody connects
+    if (Bluefruit.connected() || bluetoothAdvInterval == 0) {
+        return;
+    }
+    uint32_t elapsedMs = millis() - bluetoothAdvPhaseStartMs;
+    if (bluetoothAdvInterval == ADV_FAST_INTERVAL) {
+        if (elapsedMs > ADV_FAST_MS) {
+            bluetoothStartUndirectedAdvertising(ADV_BACKOFF_INTERVAL);
+        }
+    } else if (bluetoothAdvInterval < ADV_MAX_INTERVAL && elapsedMs > ADV_BACKOFF_STEP_MS) {
+        bluetoothStartUndirectedAdvertising(min(ADV_MAX_INTERVAL, (uint16_t)(bluetoothAdvInterval * 2)));
+    }
+}
+
+void bluetoothWake() {
+    // Re-escalate to fast advertising when backed off
+    if (!Bluefruit.connected() && bluetoothAdvInterval > ADV_FAST_INTERVAL) {
+        bluetoothStartUndirectedAdvertising(ADV_FAST_INTERVAL);
+    }
+}
+
+void bluetoothConnectCallback(uint16_t conn_hdl) {
+    // Remember the central for directed advertising after a drop. Without
+    // bonding there is no IRK, and a resolvable private address will have
+    // changed by the time the central comes back
+    bluetoothLastCentral = Bluefruit.Connection(conn_hdl)->getPeerAddr();
+    bluetoothHasLastCentral = bluetoothLastCentral.addr_type != BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_RESOLVABLE;
+    bluetoothAdvInterval = 0;
+    // loop() picks up the link parameters on its next pass, the scheduler and
+    // planner are not touched from this task
+    bluetoothConnHdl = conn_hdl;
+}
+
+void bluetoothUpdateLinkParameters() {
+    // Connection interval in unit of 1.25 ms, the central may change it at any time
+    BLEConnection* connection = Bluefruit.Connection(bluetoothConnHdl);
+    if (!connection) {
+        return;
+    }
+    uint16_t connectionIntervalMs = (connection->getConnectionInterval() * 5) / 4;
+    notifyScheduler.setConnectionInterval(connectionIntervalMs);
+#ifdef HAS_CAN_BUS
+    canBusAirtimePlanner.setLinkCapacity(connectionIntervalMs, notifyScheduler.getClassBudget(NOTIFY_CLASS_CAN));
+#endif
+}
+
+void bluetoothPrintReport() {
+    // Figures of the connection that just ended, printed from loop()
+    debug("Max latency ms GPS ");
+    debug(notifyScheduler.getMaxLatencyMs(NOTIFY_CLASS_GPS_FIX));
+    debug(" CAN ");
+    debugln(notifyScheduler.getMaxLatencyMs(NOTIFY_CLASS_CAN));
+#if defined(HAS_GPS) && defined(HAS_LAP_TIMER)
+    debug("Lap timer max update us ");
+    debugln(lapTimerMaxUpdateUs);
+#endif
+#ifdef HAS_SESSION_LOG
+    debug("Session log bytes ");
+    debug(sessionLogger.getBytesWritten());
+    debug(" write B/s ");
+    debug(sessionLogger.getWriteRate());
+    debug(" max write ms ");
+    debug(sessionLogger.getMaxWriteMs());
+    debug(" max log us ");
+    debug(sessionLogger.getMaxLogUs());
+    debug(" dropped ");
+    debug(sessionLogger.getDroppedCount());
+    debug(" size % ");
+    debug(sessionLogger.getCompressionPercent());
+    debug(" encode B/s ");
+    debugln(sessionLogger.getEncodeRate());
+#endif
+    debug("Buffer pool min free ");
+    debug(notifyBufferPool.getMinFreeCount());
+    debug(" exhausted ");
+    debugln(notifyBufferPool.getExhaustedCount());
+#if defined(HAS_CAN_BUS) && defined(HAS_DEBUG)
+    canBusAirtimePlanner.printPlan(Serial);
+#endif
+#ifdef HAS_DEBUG
+    memoryStats.print(Serial);
+#endif
+}
+
+void bluetoothDisconnectCallback(uint16_t conn_hdl, uint8_t reason) {
+    // loop() prints the report and resets the scheduler
+    notifySchedulerResetPending = true;
+    bluetoothConnHdl = BLE_CONN_HANDLE_INVALID;
+    bluetoothDisconnectMs = millis();
+    if (bluetoothHasLastCentral) {
+        bluetoothStartDirectedAdvertising();
+    } else {
+        bluetoothStartUndirectedAdvertising(ADV_FAST_INTERVAL);
+    }
+}
+
+void bluetoothMarkValueSent() {
+    // Report disconnect-to-first-value time once per reconnect
+    if (bluetoothDisconnectMs != 0) {
+        bluetoothLastReconnectMs = millis() - bluetoothDisconnectMs;
+        bluetoothDisconnectMs = 0;
+        debug("Reconnected, first value after ms ");
+        debugln(bluetoothLastReconnectMs);
+    }
+}
+
 void bluetoothStartAdvertising(void) {
     Bluefruit.setTxPower(+4);
     Bluefruit.Advertising.addFlags(BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE);
     Bluefruit.Advertising.addTxPower();
     Bluefruit.Advertising.addService(mainService);
     Bluefruit.Advertising.addName();
-    Bluefruit.Advertising.restartOnDisconnect(true);
-    Bluefruit.Advertising.setInterval(160, 160); // in unit of 0.625 ms
-    Bluefruit.Advertising.setFastTimeout(30);
-    Bluefruit.Advertising.start(0);
+    Bluefruit.Advertising.restartOnDisconnect(false);
+    Bluefruit.Periph.setConnectCallback(bluetoothConnectCallback);
+    Bluefruit.Periph.setDisconnectCallback(bluetoothDisconnectCallback);
+    bluetoothStartUndirectedAdvertising(ADV_FAST_INTERVAL);
 }
 
 void bluetoothStart() {
@@ -102,55 +306,60 @@ void bluetoothStart() {
 }
 
 #ifdef HAS_CAN_BUS
-void canBusNotifyLatestPacket(BLECharacteristic* characteristic) {
-    // Set packet id
-    ((uint32_t*)tempData)[0] = CAN.packetId();
-
-    // Set packet payload
-    int pos = 4;
+int canBusReadPayload(uint8_t* data, int size) {
+    int len = 0;
     int dataByte = CAN.read();
-    while (dataByte != -1 && pos < sizeof(tempData)) {
-        tempData[pos] = (uint8_t)dataByte;
+    while (dataByte != -1 && len < size) {
+        data[len] = (uint8_t)dataByte;
         dataByte = CAN.read();
-        pos++;
+        len++;
     }
+    return len;
+}
+
+bool canBusNotifyLatestPacket(BLECharacteristic* characteristic, uint32_t packetId, const uint8_t* data, int len) {
+    // Fill a pooled buffer in place, it stays untouched until sent. Returns
+    // false if the pool is empty and nothing was queued.
+    NotifyBuffer* buffer = notifyBufferPool.acquire();
+    if (!buffer) {
+        return false;
+    }
+
+    // Packet id and payload
+    buffer->len = RaceChronoProtocol::encode_can_frame(buffer->data, packetId, data, len);
 
-    // Notify
-    characteristic->notify(tempData, pos);
+    // Queue notify
+    notifyScheduler.enqueue(NOTIFY_CLASS_CAN, characteristic, buffer);
+    return true;
 }
 
 void canBusFilterWriteCallback(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
-    if (len < 1) {
+    RaceChronoProtocol::CanFilterCommand command;
+    if (!RaceChronoProtocol::decode_can_filter(data, len, command)) {
         return;
     }
-    uint8_t command = data[0];
-    switch (command) {
-        case CAN_BUS_CMD_DENY_ALL:
-            if (len == 1) {
-                canBusPacketIdInfo.reset();
-                canBusAllowUnknownPackets = false;
-                debugln("CAN-Bus command DENY"); 
-            }
+    switch (command.cmd) {
+        case RaceChronoProtocol::CAN_FILTER_DENY_ALL:
+            canBusPacketIdInfo.reset();
+            canBusAllowUnknownPackets = false;
+            debugln("CAN-Bus command DENY"); 
             break;
-        case CAN_BUS_CMD_ALLOW_ALL:
-            if (len == 3) {
-                canBusPacketIdInfo.reset();
-                uint16_t notifyIntervalMs = data[1] << 8 | data[2];
-                canBusPacketIdInfo.setDefaultNotifyInterval(notifyIntervalMs); 
-                canBusAllowUnknownPackets = true;
-                debug("CAN-Bus command ALLOW interval ");
-                debugln(notifyIntervalMs); 
-            }
+        case RaceChronoProtocol::CAN_FILTER_ALLOW_ALL:
+            canBusPacketIdInfo.reset();
+            canBusPacketIdInfo.setDefaultNotifyInterval(command.interval_ms); 
+            canBusAllowUnknownPackets = true;
+            debug("CAN-Bus command ALLOW interval ");
+            debugln(command.interval_ms); 
             break;
-        case CAN_BUS_CMD_ADD_PID:
-            if (len == 7) {
-                uint16_t notifyIntervalMs = data[1] << 8 | data[2];
-                uint32_t pid = data[3] << 24 | data[4] << 16 | data[5] << 8 | data[6];
-                canBusPacketIdInfo.setNotifyInterval(pid, notifyIntervalMs);
+        case RaceChronoProtocol::CAN_FILTER_ADD_PID:
+            if (!canBusPacketIdInfo.setNotifyInterval(command.packet_id, command.interval_ms)) {
+                debug("CAN-Bus PID table full, ignored ");
+                debugln(command.packet_id);
+            } else {
                 debug("CAN-Bus command ADD PID ");
-                debug(pid);
+                debug(command.packet_id);
                 debug(" interval ");
-                debugln(notifyIntervalMs); 
+                debugln(command.interval_ms);
             }
             break;
         default:
@@ -162,11 +371,23 @@ void canBusSetup() {
     // Ininitialize CAN board
     CAN.setClockFrequency(8E6);
     CAN.setPins(28, 29);
+
+    // Give important packet ids a larger share of the link when "Allow all" saturates it, e.g.
+    // canBusAirtimePlanner.setPriority(0x120, 4);
+}
+
+bool canBusIsWanted() {
+#ifdef HAS_SESSION_LOG
+    if (sessionLogger.isLogging()) {
+        return true;
+    }
+#endif
+    return Bluefruit.connected();
 }
 
 void canBusLoop() {
     // Manage CAN-Bus connection
-    if (!isCanBusConnected && Bluefruit.connected()) {
+    if (!isCanBusConnected && canBusIsWanted()) {
         // Connect to CAN-Bus
         debug("Connecting CAN-Bus...");
         if (CAN.begin(500E3)) {
@@ -179,7 +400,7 @@ void canBusLoop() {
 
         // Clear info
         canBusPacketIdInfo.reset();
-    } else if (isCanBusConnected && !Bluefruit.connected()) {
+    } else if (isCanBusConnected && !canBusIsWanted()) {
         // Disconnect from CAN-Bus
         CAN.end();
         isCanBusConnected = false;      
@@ -190,14 +411,29 @@ void canBusLoop() {
         // Try to parse packet
         int packetSize = CAN.parsePacket();
         if (packetSize > 0) {
-            // received a packet
+            // received a packet, under "Allow all" the first frame of an id
+            // adds it to the table, which allocates and stays off the hot path
             uint32_t packetId = CAN.packetId();
             PacketIdInfoItem* infoItem = canBusPacketIdInfo.findItem(packetId, canBusAllowUnknownPackets);
-            if (infoItem && infoItem->shouldNotify()) {
-                canBusNotifyLatestPacket(&canBusMainCharacteristic);    
+            HotPathScope hotPath(HOT_PATH_CAN_FRAME);
+            uint8_t data[16];
+            int len = canBusReadPayload(data, sizeof(data));
+#ifdef HAS_SESSION_LOG
+            sessionLogger.logCan(micros(), packetId, data, len);
+#endif
+            if (infoItem) {
+                infoItem->markReceived();
+            }
+            // A frame dropped for lack of a buffer leaves its id due, so the next one goes out
+            if (infoItem && infoItem->shouldNotify() && Bluefruit.connected() &&
+                    canBusNotifyLatestPacket(&canBusMainCharacteristic, packetId, data, len)) {
                 infoItem->markNotified();
+                bluetoothMarkValueSent();
             }
         }
+
+        // Keep default intervals within what the link can carry
+        canBusAirtimePlanner.loop();
     }
 }
 #endif
@@ -218,57 +454,137 @@ void gpsLoop() {
         digitalWrite(LED_RED, ledState);
 
         // Calculate date field
-        int dateAndHour = (gps->year * 8928) + ((gps->month-1) * 744) + ((gps->day-1) * 24) + gps->hour;
+        int dateAndHour = RaceChronoProtocol::gps_date_and_hour(gps->year, gps->month, gps->day, gps->hour);
         if (gpsPreviousDateAndHour != dateAndHour) {
             gpsPreviousDateAndHour = dateAndHour;
             gpsSyncBits++;
         }
 
-        // Calculate time field
-        int timeSinceHourStart = (gps->minute * 30000) + (gps->seconds * 500) + (gps->milliseconds / 2);
-
-        // Calculate latitude and longitude
-        int latitude = gps->latitude_fixed; // / 10000000) * 6000000 + (gps->latitude_fixed % 10000000);
-        int longitude = gps->longitude_fixed; // / 10000000) * 6000000 + (gps->longitude_fixed % 10000000);
-
-        // Calculate altitude, speed and bearing
-        int altitude = gps->altitude > 6000.f ? (max(0, round(gps->altitude + 500.f)) & 0x7FFF) | 0x8000 : max(0, round((gps->altitude + 500.f) * 10.f)) & 0x7FFF; 
-        int speed = gps->speed > 600.f ? ((max(0, round(gps->speed * 10.f))) & 0x7FFF) | 0x8000 : (max(0, round(gps->speed * 100.f))) & 0x7FFF; 
-        int bearing = max(0, round(gps->angle * 100.f));
-
-        // Create main data
-        tempData[0] = ((gpsSyncBits & 0x7) << 5) | ((timeSinceHourStart >> 16) & 0x1F);
-        tempData[1] = timeSinceHourStart >> 8;
-        tempData[2] = timeSinceHourStart;
-        tempData[3] = ((min(0x3, gps->fixquality) & 0x3) << 6) | ((min(0x3F, gps->satellites)) & 0x3F);
-        tempData[4] = latitude >> 24;
-        tempData[5] = latitude >> 16;
-        tempData[6] = latitude >> 8;
-        tempData[7] = latitude >> 0;
-        tempData[8] = longitude >> 24;
-        tempData[9] = longitude >> 16;
-        tempData[10] = longitude >> 8;
-        tempData[11] = longitude >> 0;
-        tempData[12] = altitude >> 8;
-        tempData[13] = altitude;
-        tempData[14] = speed >> 8;
-        tempData[15] = speed;
-        tempData[16] = bearing >> 8;
-        tempData[17] = bearing;
-        tempData[18] = round(gps->HDOP * 10.f);
-        tempData[19] = 0xFF; // Unimplemented 
-       
-        // Notify main characteristics
-        gpsMainCharacteristic.notify(tempData, 20);
+        // Fill the fix fields
+        RaceChronoProtocol::GpsFix fix;
+        fix.sync_bits = gpsSyncBits;
+        fix.time_since_hour = RaceChronoProtocol::gps_time_since_hour(gps->minute, gps->seconds, gps->milliseconds);
+        fix.fix_quality = gps->fixquality;
+        fix.satellites = gps->satellites;
+        fix.latitude = gps->latitude_fixed;
+        fix.longitude = gps->longitude_fixed;
+        fix.altitude = RaceChronoProtocol::gps_altitude(gps->altitude);
+        fix.speed = RaceChronoProtocol::gps_speed(gps->speed);
+        fix.bearing = RaceChronoProtocol::round_positive(gps->angle * 100.f);
+        fix.hdop = RaceChronoProtocol::round_positive(gps->HDOP * 10.f);
+        fix.vdop = RaceChronoProtocol::GPS_DOP_UNKNOWN; // Unimplemented
+
+        // Create main data, the log and lap timer see every fix even when
+        // no pooled buffer is left to notify it
+        uint8_t data[RaceChronoProtocol::GPS_MAIN_LEN];
+        uint8_t len = RaceChronoProtocol::encode_gps_main(data, fix);
+#ifdef HAS_SESSION_LOG
+        sessionLogger.logGps(micros(), data, len);
+#endif
 
-        // Create time data
-        tempData[0] = ((gpsSyncBits & 0x7) << 5) | ((dateAndHour >> 16) & 0x1F);
-        tempData[1] = dateAndHour >> 8;
-        tempData[2] = dateAndHour;
+        // Notify main characteristics
+        NotifyBuffer* buffer = notifyBufferPool.acquire();
+        if (buffer) {
+            memcpy(buffer->data, data, len);
+            buffer->len = len;
+            notifyScheduler.enqueue(NOTIFY_CLASS_GPS_FIX, &gpsMainCharacteristic, buffer);
+            bluetoothMarkValueSent();
+        }
 
         // Notify time characteristics
-        gpsTimeCharacteristic.notify(tempData, 3);
+        buffer = notifyBufferPool.acquire();
+        if (buffer) {
+            buffer->len = RaceChronoProtocol::encode_gps_time(buffer->data, gpsSyncBits, dateAndHour);
+            notifyScheduler.enqueue(NOTIFY_CLASS_GPS_TIME, &gpsTimeCharacteristic, buffer);
+        }
+
+#ifdef HAS_LAP_TIMER
+        if (gps->fix) {
+            lapTimerUpdate(fix.latitude, fix.longitude);
+        }
+#endif
+    }
+}
+#endif
+
+#if defined(HAS_GPS) && defined(HAS_LAP_TIMER)
+void lapTimerSetup() {
+    lapTimer.setLine(LAP_TIMER_LINE_LATITUDE_1, LAP_TIMER_LINE_LONGITUDE_1,
+        LAP_TIMER_LINE_LATITUDE_2, LAP_TIMER_LINE_LONGITUDE_2);
+}
+
+void lapTimerUpdate(int latitude, int longitude) {
+    // Monotonic time from the fix time, the crossing is interpolated on it rather than on arrival
+    uint32_t dayMs = (((gps->hour * 60) + gps->minute) * 60 + gps->seconds) * 1000 + gps->milliseconds;
+    if (lapTimerTimeMs == 0) {
+        lapTimerTimeMs = 1;
+    } else {
+        lapTimerTimeMs += (dayMs + 86400000 - lapTimerPreviousDayMs) % 86400000;
     }
+    lapTimerPreviousDayMs = dayMs;
+
+    // Delta is ready as soon as the fix is parsed, no round trip through the app
+    uint32_t startUs = micros();
+    if (lapTimer.update(lapTimerTimeMs, latitude, longitude)) {
+        debug("Lap ");
+        debug(lapTimer.getLapCount());
+        debug(" ms ");
+        debugln(lapTimer.getLastLapMs());
+    }
+    lapTimerMaxUpdateUs = max(lapTimerMaxUpdateUs, micros() - startUs);
+    if (!lapTimer.isTiming()) {
+        return;
+    }
+
+#ifdef HAS_CAN_BUS
+    if (!Bluefruit.connected()) {
+        return;
+    }
+    NotifyBuffer* buffer = notifyBufferPool.acquire();
+    if (!buffer) {
+        return;
+    }
+    uint8_t* data = buffer->data;
+    uint32_t elapsedMs = lapTimer.getElapsedMs();
+    int32_t deltaMs = lapTimer.hasDelta() ? lapTimer.getDeltaMs() : INT32_MIN;
+    uint32_t lastLapMs = lapTimer.getLastLapMs();
+    uint8_t payload[12];
+    RaceChronoProtocol::write_be32(payload, elapsedMs);
+    RaceChronoProtocol::write_be32(payload + 4, deltaMs);
+    RaceChronoProtocol::write_be32(payload + 8, lastLapMs);
+    buffer->len = RaceChronoProtocol::encode_can_frame(data, LAP_TIMER_PACKET_ID, payload, sizeof(payload));
+    notifyScheduler.enqueue(NOTIFY_CLASS_DIAGNOSTICS, &canBusMainCharacteristic, buffer);
+#endif
+}
+#endif
+
+#ifdef HAS_SESSION_LOG
+void sessionLogSetup() {
+    // Blocks are appended, a log survives power cycles until it is read out and removed
+    InternalFS.begin();
+    if (!sessionLogFile.open(SESSION_LOG_PATH, FILE_O_WRITE)) {
+        debugln("Session log open failed");
+        return;
+    }
+    if (sessionLogger.begin(&sessionLogFile)) {
+        memoryStats.watchTask(sessionLogger.getWriterTask());
+    }
+}
+#endif
+
+#ifdef HAS_IGNITION_SENSE
+void ignitionSetup() {
+    pinMode(IGNITION_SENSE_PIN, INPUT);
+    ignitionPreviousState = digitalRead(IGNITION_SENSE_PIN);
+}
+
+void ignitionLoop() {
+    // Ignition switched on, the driver is about to head out
+    int state = digitalRead(IGNITION_SENSE_PIN);
+    if (state == HIGH && ignitionPreviousState == LOW) {
+        bluetoothWake();
+    }
+    ignitionPreviousState = state;
 }
 #endif
 
@@ -277,6 +593,7 @@ void setup() {
     Serial.begin(115200);
     while (!Serial);
 #endif
+    memoryStats.watchTask();
     bluetoothStart();
     pinMode(LED_RED, OUTPUT);
     digitalWrite(LED_RED, ledState);
@@ -286,13 +603,37 @@ void setup() {
 #ifdef HAS_GPS
     gpsSetup();
 #endif    
+#if defined(HAS_GPS) && defined(HAS_LAP_TIMER)
+    lapTimerSetup();
+#endif
+#ifdef HAS_SESSION_LOG
+    sessionLogSetup();
+#endif
+#ifdef HAS_IGNITION_SENSE
+    ignitionSetup();
+#endif
 }
 
 void loop() {
+    if (notifySchedulerResetPending) {
+        // Report before the reset clears the latency figures
+        notifySchedulerResetPending = false;
+        bluetoothPrintReport();
+        notifyScheduler.reset();
+    }
+    bluetoothAdvertisingLoop();
+    if (Bluefruit.connected()) {
+        bluetoothUpdateLinkParameters();
+    }
+#ifdef HAS_IGNITION_SENSE
+    ignitionLoop();
+#endif
 #ifdef HAS_CAN_BUS
     canBusLoop();
 #endif
 #ifdef HAS_GPS
     gpsLoop();
 #endif      
+    notifyScheduler.service();
+    memoryStats.loop();
 }
@@ -0,0 +1,42 @@
+/*
+ * BigFont.cpp
+ */
+#include "BigFont.h"
+#include "BigFontData.h"
+
+uint16_t getBigFontWidth() {
+    return BIG_FONT_WIDTH;
+}
+
+uint16_t getBigFontHeight() {
+    return BIG_FONT_HEIGHT;
+}
+
+const BigGlyph* getBigGlyph(char c) {
+    for (unsigned int i = 0; i < sizeof(BIG_FONT_GLYPHS) / sizeof(BIG_FONT_GLYPHS[0]); i++) {
+        if (BIG_FONT_GLYPHS[i].c == c) {
+            return &BIG_FONT_GLYPHS[i];
+        }
+    }
+    return nullptr;
+}
+
+const uint8_t* getBigGlyphRuns(const BigGlyph* glyph) {
+    return &BIG_FONT_RUNS[glyph->offset];
+}
+
+void decodeBigGlyph(const BigGlyph* glyph, uint16_t* pixels, uint16_t color, uint16_t background) {
+    uint16_t* end = pixels + BIG_FONT_WIDTH * BIG_FONT_HEIGHT;
+    if (glyph) {
+        const uint8_t* runs = getBigGlyphRuns(glyph);
+        for (uint16_t i = 0; i < glyph->length && pixels < end; i++) {
+            uint16_t value = (i & 1) ? color : background;
+            for (uint8_t n = runs[i]; n > 0 && pixels < end; n--) {
+                *pixels++ = value;
+            }
+        }
+    }
+    while (pixels < end) {
+        *pixels++ = background;
+    }
+}
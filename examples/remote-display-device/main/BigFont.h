@@ -0,0 +1,31 @@
+/*
+ * BigFont.h
+ */
+
+#ifndef BIGFONT_H_
+#define BIGFONT_H_
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+struct BigGlyph {
+    char c;
+    uint16_t offset;    // First run in BIG_FONT_RUNS
+    uint16_t length;    // Number of runs
+};
+
+// Glyph size in pixels, every glyph has the same size
+uint16_t getBigFontWidth();
+uint16_t getBigFontHeight();
+
+// Find glyph of a character, nullptr if the font does not have it
+const BigGlyph* getBigGlyph(char c);
+
+// Get run lengths of a glyph, alternating background and foreground, starting with background
+const uint8_t* getBigGlyphRuns(const BigGlyph* glyph);
+
+// Decode glyph into width * height pixels, nullptr glyph decodes blank
+void decodeBigGlyph(const BigGlyph* glyph, uint16_t* pixels, uint16_t color, uint16_t background);
+
+#endif
+#endif
@@ -0,0 +1,121 @@
+/*
+ * BigFontData.h
+ *
+ * Generated by tools/gen_big_font.py, do not edit
+ */
+
+#ifndef BIGFONTDATA_H_
+#define BIGFONTDATA_H_
+
+#define BIG_FONT_WIDTH 24
+#define BIG_FONT_HEIGHT 40
+
+static const uint8_t BIG_FONT_RUNS[] = {
+    // ' '
+    255, 0, 255, 0, 255, 0, 195,
+    // '-'
+    255, 0, 161, 8, 15, 10, 13, 12, 12, 12, 13, 10, 15, 8, 255, 0,
+    161,
+    // '.'
+    255, 0, 255, 0, 255, 0, 12, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    18, 6, 57,
+    // '0'
+    56, 8, 15, 10, 13, 12, 12, 12, 10, 2, 1, 10, 1, 2, 7, 4,
+    1, 8, 1, 4, 5, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6,
+    4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6,
+    4, 6, 8, 6, 4, 6, 8, 6, 5, 4, 10, 4, 7, 2, 12, 2,
+    56, 2, 12, 2, 7, 4, 10, 4, 5, 6, 8, 6, 4, 6, 8, 6,
+    4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6,
+    4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6, 5, 4, 1, 8,
+    1, 4, 7, 2, 1, 10, 1, 2, 10, 12, 12, 12, 13, 10, 15, 8,
+    56,
+    // '1'
+    162, 2, 21, 4, 19, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    18, 6, 18, 6, 18, 6, 19, 4, 21, 2, 70, 2, 21, 4, 19, 6,
+    18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    19, 4, 21, 2, 148,
+    // '2'
+    56, 8, 15, 10, 13, 12, 12, 12, 13, 10, 1, 2, 12, 8, 1, 4,
+    19, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    18, 6, 10, 8, 1, 4, 10, 10, 1, 2, 10, 12, 12, 12, 10, 2,
+    1, 10, 10, 4, 1, 8, 10, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    18, 6, 18, 6, 18, 6, 18, 6, 19, 4, 1, 8, 12, 2, 1, 10,
+    13, 12, 12, 12, 13, 10, 15, 8, 56,
+    // '3'
+    56, 8, 15, 10, 13, 12, 12, 12, 13, 10, 1, 2, 12, 8, 1, 4,
+    19, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    18, 6, 10, 8, 1, 4, 10, 10, 1, 2, 10, 12, 12, 12, 13, 10,
+    1, 2, 12, 8, 1, 4, 19, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    18, 6, 18, 6, 18, 6, 18, 6, 10, 8, 1, 4, 10, 10, 1, 2,
+    10, 12, 12, 12, 13, 10, 15, 8, 56,
+    // '4'
+    148, 2, 12, 2, 7, 4, 10, 4, 5, 6, 8, 6, 4, 6, 8, 6,
+    4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6,
+    4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6, 5, 4, 1, 8,
+    1, 4, 7, 2, 1, 10, 1, 2, 10, 12, 12, 12, 13, 10, 1, 2,
+    12, 8, 1, 4, 19, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    18, 6, 18, 6, 18, 6, 19, 4, 21, 2, 148,
+    // '5'
+    56, 8, 15, 10, 13, 12, 12, 12, 10, 2, 1, 10, 10, 4, 1, 8,
+    10, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    18, 6, 19, 4, 1, 8, 12, 2, 1, 10, 13, 12, 12, 12, 13, 10,
+    1, 2, 12, 8, 1, 4, 19, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    18, 6, 18, 6, 18, 6, 18, 6, 10, 8, 1, 4, 10, 10, 1, 2,
+    10, 12, 12, 12, 13, 10, 15, 8, 56,
+    // '6'
+    56, 8, 15, 10, 13, 12, 12, 12, 10, 2, 1, 10, 10, 4, 1, 8,
+    10, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    18, 6, 19, 4, 1, 8, 12, 2, 1, 10, 13, 12, 12, 12, 10, 2,
+    1, 10, 1, 2, 7, 4, 1, 8, 1, 4, 5, 6, 8, 6, 4, 6,
+    8, 6, 4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6, 4, 6,
+    8, 6, 4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6, 5, 4,
+    1, 8, 1, 4, 7, 2, 1, 10, 1, 2, 10, 12, 12, 12, 13, 10,
+    15, 8, 56,
+    // '7'
+    56, 8, 15, 10, 13, 12, 12, 12, 13, 10, 1, 2, 12, 8, 1, 4,
+    19, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    18, 6, 19, 4, 21, 2, 70, 2, 21, 4, 19, 6, 18, 6, 18, 6,
+    18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 19, 4, 21, 2,
+    148,
+    // '8'
+    56, 8, 15, 10, 13, 12, 12, 12, 10, 2, 1, 10, 1, 2, 7, 4,
+    1, 8, 1, 4, 5, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6,
+    4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6,
+    4, 6, 8, 6, 4, 6, 8, 6, 5, 4, 1, 8, 1, 4, 7, 2,
+    1, 10, 1, 2, 10, 12, 12, 12, 10, 2, 1, 10, 1, 2, 7, 4,
+    1, 8, 1, 4, 5, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6,
+    4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6,
+    4, 6, 8, 6, 4, 6, 8, 6, 5, 4, 1, 8, 1, 4, 7, 2,
+    1, 10, 1, 2, 10, 12, 12, 12, 13, 10, 15, 8, 56,
+    // '9'
+    56, 8, 15, 10, 13, 12, 12, 12, 10, 2, 1, 10, 1, 2, 7, 4,
+    1, 8, 1, 4, 5, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6,
+    4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6, 4, 6, 8, 6,
+    4, 6, 8, 6, 4, 6, 8, 6, 5, 4, 1, 8, 1, 4, 7, 2,
+    1, 10, 1, 2, 10, 12, 12, 12, 13, 10, 1, 2, 12, 8, 1, 4,
+    19, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6, 18, 6,
+    18, 6, 10, 8, 1, 4, 10, 10, 1, 2, 10, 12, 12, 12, 13, 10,
+    15, 8, 56,
+    // ':'
+    249, 6, 18, 6, 18, 6, 18, 6, 18, 6, 255, 0, 27, 6, 18, 6,
+    18, 6, 18, 6, 18, 6, 225,
+};
+
+static const BigGlyph BIG_FONT_GLYPHS[] = {
+    { ' ', 0, 7 },
+    { '-', 7, 17 },
+    { '.', 24, 19 },
+    { '0', 43, 129 },
+    { '1', 172, 53 },
+    { '2', 225, 89 },
+    { '3', 314, 89 },
+    { '4', 403, 91 },
+    { '5', 494, 89 },
+    { '6', 583, 115 },
+    { '7', 698, 65 },
+    { '8', 763, 141 },
+    { '9', 904, 115 },
+    { ':', 1019, 23 },
+};
+
+#endif
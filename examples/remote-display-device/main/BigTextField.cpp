@@ -0,0 +1,74 @@
+/*
+ * BigTextField.cpp
+ */
+#include "BigTextField.h"
+#include "BigFont.h"
+
+BigTextField::BigTextField() {
+    mX = 0;
+    mY = 0;
+    mWidth = 0;
+    mIsValid = false;
+    mText[0] = '\0';
+}
+
+BigTextField::~BigTextField() {
+}
+
+void BigTextField::begin(int16_t x, int16_t y, uint8_t width) {
+    mX = x;
+    mY = y;
+    mWidth = min(width, BIG_TEXT_FIELD_MAX);
+    mIsValid = false;
+}
+
+int16_t BigTextField::getCellX(uint8_t cell) {
+    return mX + cell * getBigFontWidth();
+}
+
+uint16_t BigTextField::getHeight() {
+    return getBigFontHeight();
+}
+
+void BigTextField::drawGlyphRuns(Adafruit_SPITFT* display, int16_t x, char c, uint16_t color, uint16_t background) {
+    const BigGlyph* glyph = getBigGlyph(c);
+    display->startWrite();
+    display->setAddrWindow(x, mY, getBigFontWidth(), getBigFontHeight());
+    if (glyph) {
+        const uint8_t* runs = getBigGlyphRuns(glyph);
+        for (uint16_t i = 0; i < glyph->length; i++) {
+            if (runs[i] > 0) {
+                display->writeColor((i & 1) ? color : background, runs[i]);
+            }
+        }
+    } else {
+        display->writeColor(background, (uint32_t)getBigFontWidth() * getBigFontHeight());
+    }
+    display->endWrite();
+}
+
+uint32_t BigTextField::draw(TileRenderer* renderer, Adafruit_SPITFT* display, const char* text, uint16_t color, uint16_t background) {
+    uint32_t spiBytes = 0;
+    uint32_t glyphBytes = 10 + 2 * (uint32_t)getBigFontWidth() * getBigFontHeight();
+    size_t textLen = strnlen(text, mWidth);
+    for (uint8_t i = 0; i < mWidth; i++) {
+        char c = i < textLen ? text[i] : ' ';
+        if (mIsValid && c == mText[i]) {
+            continue;
+        }
+        mText[i] = c;
+        uint16_t* pixels = renderer->beginTilePixels(getCellX(i), mY, getBigFontWidth(), getBigFontHeight());
+        if (pixels) {
+            // Decode while the previous glyph is still going out
+            decodeBigGlyph(getBigGlyph(c), pixels, color, background);
+            renderer->endTile();
+        } else {
+            renderer->finish();
+            drawGlyphRuns(display, getCellX(i), c, color, background);
+        }
+        spiBytes += glyphBytes;
+    }
+    mText[mWidth] = '\0';
+    mIsValid = true;
+    return spiBytes;
+}
@@ -0,0 +1,49 @@
+/*
+ * BigTextField.h
+ */
+
+#ifndef BIGTEXTFIELD_H_
+#define BIGTEXTFIELD_H_
+#ifdef __cplusplus
+
+#include <Adafruit_SPITFT.h>
+#include "TileRenderer.h"
+
+static const uint8_t BIG_TEXT_FIELD_MAX = 12;
+
+// Text field drawn with the large-digit font, one pre-rendered glyph per cell
+class BigTextField {
+public:
+    BigTextField();
+    virtual ~BigTextField();
+
+    // Place field at pixel position, width in characters
+    void begin(int16_t x, int16_t y, uint8_t width);
+
+    // Draw text, redrawing only the cells that changed since the previous draw. Each
+    // glyph is decoded into a tile and sent with DMA, or streamed as color runs when
+    // there are no tile buffers. Returns estimated SPI bytes.
+    uint32_t draw(TileRenderer* renderer, Adafruit_SPITFT* display, const char* text, uint16_t color, uint16_t background);
+
+    // Forget the rendered text, the next draw redraws every cell
+    void invalidate() { mIsValid = false; }
+
+    // Get cell geometry in pixels
+    int16_t getCellX(uint8_t cell);
+    int16_t getY() { return mY; }
+    uint16_t getHeight();
+
+private:
+    // Stream glyph runs straight to the display
+    void drawGlyphRuns(Adafruit_SPITFT* display, int16_t x, char c, uint16_t color, uint16_t background);
+
+private:
+    int16_t mX;
+    int16_t mY;
+    uint8_t mWidth;
+    bool mIsValid;
+    char mText[BIG_TEXT_FIELD_MAX + 1];
+};
+
+#endif
+#endif
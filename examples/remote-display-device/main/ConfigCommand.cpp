@@ -0,0 +1,12 @@
+/*
+ * ConfigCommand.cpp
+ */
+#include "ConfigCommand.h"
+
+int getConfigChunkCount(int cmdType, size_t payloadLen) {
+    return RaceChronoProtocol::config_chunk_count(cmdType, payloadLen);
+}
+
+uint8_t buildConfigChunk(uint8_t* bytes, int cmdType, int monitorId, const char* payload, size_t payloadLen, int chunk) {
+    return RaceChronoProtocol::encode_config_chunk(bytes, cmdType, monitorId, payload, payloadLen, chunk);
+}
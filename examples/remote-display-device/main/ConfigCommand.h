@@ -0,0 +1,33 @@
+/*
+ * ConfigCommand.h
+ */
+
+#ifndef CONFIGCOMMAND_H_
+#define CONFIGCOMMAND_H_
+#ifdef __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+#include "racechrono_protocol.hpp"
+
+// Monitor config commands, encoded by the shared protocol codec
+#define CMD_TYPE_REMOVE_ALL RaceChronoProtocol::MONITOR_REMOVE_ALL
+#define CMD_TYPE_REMOVE RaceChronoProtocol::MONITOR_REMOVE
+#define CMD_TYPE_ADD_INCOMPLETE RaceChronoProtocol::MONITOR_ADD_INCOMPLETE
+#define CMD_TYPE_ADD RaceChronoProtocol::MONITOR_ADD
+#define CMD_TYPE_UPDATE_ALL RaceChronoProtocol::MONITOR_UPDATE_ALL
+#define CMD_TYPE_UPDATE RaceChronoProtocol::MONITOR_UPDATE
+
+#define CONFIG_HEADER_LEN RaceChronoProtocol::CONFIG_HEADER_LEN
+#define CONFIG_PAYLOAD_PART_MAX RaceChronoProtocol::CONFIG_PART_MAX
+#define CONFIG_CHUNK_MAX RaceChronoProtocol::CONFIG_CHUNK_MAX
+
+// Get number of indications needed to send a command, payload is only carried by CMD_TYPE_ADD
+int getConfigChunkCount(int cmdType, size_t payloadLen);
+
+// Write one chunk of a command into bytes (CONFIG_CHUNK_MAX long), returns its length.
+// Every chunk but the last of a split payload is sent as CMD_TYPE_ADD_INCOMPLETE.
+uint8_t buildConfigChunk(uint8_t* bytes, int cmdType, int monitorId, const char* payload, size_t payloadLen, int chunk);
+
+#endif
+#endif
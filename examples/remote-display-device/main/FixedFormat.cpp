@@ -0,0 +1,116 @@
+/*
+ * FixedFormat.cpp
+ */
+#include "FixedFormat.h"
+
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint32_t POWERS_OF_TEN[FIXED_DECIMALS_MAX + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+// Write exactly width digits of value, zero padded
+static void formatPadded(char* out, uint32_t value, uint8_t width) {
+    while (width >= 2) {
+        width -= 2;
+        const char* pair = &DIGIT_PAIRS[(value % 100) * 2];
+        out[width] = pair[0];
+        out[width + 1] = pair[1];
+        value /= 100;
+    }
+    if (width) {
+        out[0] = '0' + value % 10;
+    }
+}
+
+uint8_t formatUnsigned(char* out, uint32_t value) {
+    uint8_t len = 1;
+    while (len < 10 && value >= POWERS_OF_TEN[len]) {
+        len++;
+    }
+    formatPadded(out, value, len);
+    return len;
+}
+
+uint8_t formatFixed(char* out, int32_t raw, uint8_t rawDecimals, uint8_t decimals) {
+    if (rawDecimals > FIXED_DECIMALS_MAX) {
+        rawDecimals = FIXED_DECIMALS_MAX;
+    }
+    if (decimals > FIXED_DECIMALS_MAX) {
+        decimals = FIXED_DECIMALS_MAX;
+    }
+
+    // Rescale the magnitude to the shown decimals, only ever in integers
+    bool isNegative = raw < 0;
+    uint64_t magnitude = isNegative ? (uint64_t)(-(int64_t)raw) : (uint64_t)raw;
+    if (decimals < rawDecimals) {
+        uint32_t divisor = POWERS_OF_TEN[rawDecimals - decimals];
+        magnitude = (magnitude + divisor / 2) / divisor;
+    } else {
+        magnitude *= POWERS_OF_TEN[decimals - rawDecimals];
+    }
+    uint64_t unit = POWERS_OF_TEN[decimals];
+    uint64_t whole = magnitude / unit;
+    uint32_t fraction = (uint32_t)(magnitude % unit);
+
+    uint8_t len = 0;
+    if (isNegative && magnitude != 0) {
+        out[len++] = '-';
+    }
+    if (whole >= 1000000000) {
+        // Only reachable with many more decimals shown than carried
+        len += formatUnsigned(out + len, (uint32_t)(whole / 1000000000));
+        formatPadded(out + len, (uint32_t)(whole % 1000000000), 9);
+        len += 9;
+    } else {
+        len += formatUnsigned(out + len, (uint32_t)whole);
+    }
+    if (decimals > 0) {
+        out[len++] = '.';
+        formatPadded(out + len, fraction, decimals);
+        len += decimals;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+uint8_t formatLapTime(char* out, int32_t raw, uint8_t rawDecimals) {
+    if (rawDecimals > FIXED_DECIMALS_MAX) {
+        rawDecimals = FIXED_DECIMALS_MAX;
+    }
+
+    // Whole tenths first, so rounding carries into seconds and minutes
+    bool isNegative = raw < 0;
+    uint32_t magnitude = isNegative ? (uint32_t)(-(int64_t)raw) : (uint32_t)raw;
+    uint64_t tenths;
+    if (rawDecimals >= 1) {
+        uint32_t divisor = POWERS_OF_TEN[rawDecimals - 1];
+        tenths = ((uint64_t)magnitude + divisor / 2) / divisor;
+    } else {
+        tenths = (uint64_t)magnitude * 10;
+    }
+    uint32_t seconds = (uint32_t)(tenths / 10);
+
+    uint8_t len = 0;
+    if (isNegative && tenths != 0) {
+        out[len++] = '-';
+    }
+    len += formatUnsigned(out + len, seconds / 60);
+    out[len++] = ':';
+    formatPadded(out + len, seconds % 60, 2);
+    len += 2;
+    out[len++] = '.';
+    out[len++] = '0' + (char)(tenths % 10);
+    out[len] = '\0';
+    return len;
+}
@@ -0,0 +1,29 @@
+/*
+ * FixedFormat.h
+ */
+
+#ifndef FIXEDFORMAT_H_
+#define FIXEDFORMAT_H_
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+// Longest text with terminator, "-2147483648.123456789" fits
+#define FIXED_FORMAT_MAX 24
+
+// Largest number of decimals shown or implied
+#define FIXED_DECIMALS_MAX 9
+
+// Write digits of value, no terminator. Returns the length written.
+uint8_t formatUnsigned(char* out, uint32_t value);
+
+// Write raw value, which carries rawDecimals implied decimals, with the given
+// number of decimals, rounded half away from zero. Returns the length written.
+uint8_t formatFixed(char* out, int32_t raw, uint8_t rawDecimals, uint8_t decimals);
+
+// Write raw seconds, which carry rawDecimals implied decimals, as m:ss.t.
+// Returns the length written.
+uint8_t formatLapTime(char* out, int32_t raw, uint8_t rawDecimals);
+
+#endif
+#endif
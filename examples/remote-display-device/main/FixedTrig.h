@@ -0,0 +1,22 @@
+/*
+ * FixedTrig.h
+ */
+
+#ifndef FIXEDTRIG_H_
+#define FIXEDTRIG_H_
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+// Angles are in 1/1024 of a turn, results in Q14 (16384 is 1.0)
+#define FIXED_ANGLE_TURN 1024
+#define FIXED_ONE 16384
+
+// Sine from a quarter-wave table, any angle wraps
+int16_t fixedSin(int32_t angle);
+
+// Cosine from the same table
+int16_t fixedCos(int32_t angle);
+
+#endif
+#endif
@@ -0,0 +1,218 @@
+/*
+ * Gauge.cpp
+ */
+#include "Gauge.h"
+#include "FixedTrig.h"
+
+static const int32_t SWEEP_START = -FIXED_ANGLE_TURN * 135 / 360;
+static const int32_t SWEEP = FIXED_ANGLE_TURN * 270 / 360;
+static const uint8_t MAJOR_TICKS = 10;
+static const uint16_t BAND_HEIGHT = 16;
+static const int16_t HUB_RADIUS = 4;
+static const int16_t NEEDLE_MARGIN = 2;
+
+Gauge::Gauge() {
+    mFace = nullptr;
+    mX = 0;
+    mY = 0;
+    mSize = 0;
+    mMin = 0;
+    mMax = 1;
+    mFaceColor = 0xFFFF;
+    mNeedleColor = 0xF800;
+    mBackground = 0;
+    mHasNeedle = false;
+    mTipX = 0;
+    mTipY = 0;
+    mIsValid = false;
+}
+
+Gauge::~Gauge() {
+    delete mFace;
+}
+
+void Gauge::begin(int16_t x, int16_t y, uint16_t size, int32_t min, int32_t max, uint16_t faceColor, uint16_t needleColor, uint16_t background) {
+    mX = x;
+    mY = y;
+    mMin = min;
+    mMax = max > min ? max : min + 1;
+    mFaceColor = faceColor;
+    mNeedleColor = needleColor;
+    mBackground = background;
+    mHasNeedle = false;
+    mIsValid = false;
+
+    // Keep the cache between pages unless the gauge grows
+    if (!mFace || size > mSize) {
+        delete mFace;
+        mFace = new GFXcanvas16(size, size);
+        if (!mFace->getBuffer()) {
+            // Not enough RAM, needle moves erase with the background color
+            delete mFace;
+            mFace = nullptr;
+        }
+    }
+    mSize = size;
+    if (mFace) {
+        mFace->fillScreen(background);
+        drawFace(mFace, 0, 0);
+    }
+}
+
+int32_t Gauge::getAngle(int32_t raw) {
+    if (raw <= mMin) {
+        return SWEEP_START;
+    }
+    if (raw >= mMax) {
+        return SWEEP_START + SWEEP;
+    }
+    return SWEEP_START + (int32_t)((int64_t)(raw - mMin) * SWEEP / (mMax - mMin));
+}
+
+void Gauge::getPoint(int32_t angle, int16_t radius, int16_t* x, int16_t* y) {
+    // Angle 0 points up and grows clockwise, screen y grows down
+    int16_t center = mSize / 2;
+    *x = center + (int16_t)(((int32_t)radius * fixedSin(angle) + FIXED_ONE / 2) >> 14);
+    *y = center - (int16_t)(((int32_t)radius * fixedCos(angle) + FIXED_ONE / 2) >> 14);
+}
+
+void Gauge::drawFace(Adafruit_GFX* gfx, int16_t ox, int16_t oy) {
+    int16_t radius = mSize / 2 - 1;
+    for (int32_t a = 0; a <= SWEEP; a++) {
+        int16_t x;
+        int16_t y;
+        getPoint(SWEEP_START + a, radius, &x, &y);
+        gfx->drawPixel(ox + x, oy + y, mFaceColor);
+    }
+    for (uint8_t i = 0; i <= MAJOR_TICKS; i++) {
+        int32_t angle = SWEEP_START + SWEEP * i / MAJOR_TICKS;
+        int16_t x0;
+        int16_t y0;
+        int16_t x1;
+        int16_t y1;
+        getPoint(angle, radius - 8, &x0, &y0);
+        getPoint(angle, radius, &x1, &y1);
+        gfx->drawLine(ox + x0, oy + y0, ox + x1, oy + y1, mFaceColor);
+    }
+}
+
+void Gauge::drawNeedle(Adafruit_GFX* gfx, int16_t ox, int16_t oy, int16_t tipX, int16_t tipY, uint16_t color) {
+    // Three pixels wide, offset across the major axis of the line
+    int16_t center = mSize / 2;
+    bool isSteep = abs(tipY - center) > abs(tipX - center);
+    for (int16_t d = -1; d <= 1; d++) {
+        int16_t dx = isSteep ? d : 0;
+        int16_t dy = isSteep ? 0 : d;
+        gfx->drawLine(ox + center + dx, oy + center + dy, ox + tipX + dx, oy + tipY + dy, color);
+    }
+    gfx->fillCircle(ox + center, oy + center, HUB_RADIUS, color);
+}
+
+void Gauge::addNeedleSpan(int16_t tipX, int16_t tipY, int16_t y0, int16_t y1, int16_t* x0, int16_t* x1) {
+    int16_t center = mSize / 2;
+
+    // Hub
+    if (y0 <= center + HUB_RADIUS && y1 >= center - HUB_RADIUS) {
+        *x0 = min(*x0, (int16_t)(center - HUB_RADIUS));
+        *x1 = max(*x1, (int16_t)(center + HUB_RADIUS));
+    }
+
+    // Part of the line within the rows, widened by the needle width
+    int16_t top = min(center, tipY);
+    int16_t bottom = max(center, tipY);
+    if (y1 < top - NEEDLE_MARGIN || y0 > bottom + NEEDLE_MARGIN) {
+        return;
+    }
+    int16_t xa = min(center, tipX);
+    int16_t xb = max(center, tipX);
+    if (tipY != center) {
+        // A shallow line shifted one row for its width moves many columns, so
+        // take the line over the rows widened by the margin too
+        int16_t ya = constrain(y0 - NEEDLE_MARGIN, top, bottom);
+        int16_t yb = constrain(y1 + NEEDLE_MARGIN, top, bottom);
+        xa = center + (int32_t)(tipX - center) * (ya - center) / (tipY - center);
+        xb = center + (int32_t)(tipX - center) * (yb - center) / (tipY - center);
+    }
+    *x0 = min(*x0, (int16_t)(min(xa, xb) - NEEDLE_MARGIN));
+    *x1 = max(*x1, (int16_t)(max(xa, xb) + NEEDLE_MARGIN));
+}
+
+uint32_t Gauge::draw(TileRenderer* renderer, Adafruit_SPITFT* display, int32_t raw, bool isValid) {
+    int16_t tipX = mTipX;
+    int16_t tipY = mTipY;
+    if (isValid) {
+        getPoint(getAngle(raw), mSize / 2 - 10, &tipX, &tipY);
+    }
+    if (mIsValid && isValid == mHasNeedle && (!isValid || (tipX == mTipX && tipY == mTipY))) {
+        return 0;
+    }
+
+    uint32_t spiBytes = 0;
+    if (!mFace) {
+        // No cache, erase the old needle with the background and redraw the face
+        if (!mIsValid) {
+            display->fillRect(mX, mY, mSize, mSize, mBackground);
+        } else if (mHasNeedle) {
+            drawNeedle(display, mX, mY, mTipX, mTipY, mBackground);
+        }
+        drawFace(display, mX, mY);
+        if (isValid) {
+            drawNeedle(display, mX, mY, tipX, tipY, mNeedleColor);
+        }
+        spiBytes += 10 + 2 * (uint32_t)mSize * mSize;
+    } else {
+        bool isDirect = false;
+        for (int16_t y0 = 0; y0 < mSize; y0 += BAND_HEIGHT) {
+            int16_t y1 = min((int16_t)(y0 + BAND_HEIGHT), (int16_t)mSize) - 1;
+            int16_t x0 = mSize;
+            int16_t x1 = -1;
+            if (!mIsValid) {
+                x0 = 0;
+                x1 = mSize - 1;
+            } else {
+                if (mHasNeedle) {
+                    addNeedleSpan(mTipX, mTipY, y0, y1, &x0, &x1);
+                }
+                if (isValid) {
+                    addNeedleSpan(tipX, tipY, y0, y1, &x0, &x1);
+                }
+            }
+            x0 = max(x0, (int16_t)0);
+            x1 = min(x1, (int16_t)(mSize - 1));
+            if (x1 < x0) {
+                continue;
+            }
+
+            // Face from the cache, then the needle on top
+            uint16_t width = x1 - x0 + 1;
+            uint16_t height = y1 - y0 + 1;
+            GFXcanvas16* tile = renderer->beginTileCanvas(mX + x0, mY + y0, width, height);
+            if (!tile) {
+                // No tile buffers, restore whole rows and draw the needle once at the end
+                renderer->finish();
+                display->drawRGBBitmap(mX, mY + y0, mFace->getBuffer() + y0 * mSize, mSize, height);
+                spiBytes += 10 + 2 * (uint32_t)mSize * height;
+                isDirect = true;
+                continue;
+            }
+            uint16_t* pixels = tile->getBuffer();
+            const uint16_t* face = mFace->getBuffer();
+            for (uint16_t row = 0; row < height; row++) {
+                memcpy(pixels + row * width, face + (y0 + row) * mSize + x0, width * sizeof(uint16_t));
+            }
+            if (isValid) {
+                drawNeedle(tile, -x0, -y0, tipX, tipY, mNeedleColor);
+            }
+            renderer->endTile();
+            spiBytes += 10 + 2 * (uint32_t)width * height;
+        }
+        if (isDirect && isValid) {
+            drawNeedle(display, mX, mY, tipX, tipY, mNeedleColor);
+        }
+    }
+    mHasNeedle = isValid;
+    mTipX = tipX;
+    mTipY = tipY;
+    mIsValid = true;
+    return spiBytes;
+}
@@ -0,0 +1,67 @@
+/*
+ * Gauge.h
+ */
+
+#ifndef GAUGE_H_
+#define GAUGE_H_
+#ifdef __cplusplus
+
+#include <Adafruit_SPITFT.h>
+#include "TileRenderer.h"
+
+static const uint16_t GAUGE_SIZE_MAX = 112;
+
+// Round gauge with a needle sweeping 270 degrees clockwise from bottom left.
+// The face is cached in RAM, a needle move redraws only the bands of rows the
+// old and new needle cross, and within them only the columns they cover.
+class Gauge {
+public:
+    Gauge();
+    virtual ~Gauge();
+
+    // Place gauge, raw values min..max map to the sweep. Renders the face into the cache.
+    void begin(int16_t x, int16_t y, uint16_t size, int32_t min, int32_t max, uint16_t faceColor, uint16_t needleColor, uint16_t background);
+
+    // Forget what was drawn, the next draw redraws the face and the needle
+    void invalidate() { mIsValid = false; }
+
+    // Move the needle, no needle if the value is not valid. Returns estimated SPI bytes.
+    uint32_t draw(TileRenderer* renderer, Adafruit_SPITFT* display, int32_t raw, bool isValid);
+
+    // Get size in pixels
+    uint16_t getSize() { return mSize; }
+
+private:
+    // Get needle angle of a value
+    int32_t getAngle(int32_t raw);
+
+    // Get point at radius and angle, relative to the gauge origin
+    void getPoint(int32_t angle, int16_t radius, int16_t* x, int16_t* y);
+
+    // Draw face, ticks and arc, with the gauge origin at ox, oy
+    void drawFace(Adafruit_GFX* gfx, int16_t ox, int16_t oy);
+
+    // Draw needle and hub, with the gauge origin at ox, oy
+    void drawNeedle(Adafruit_GFX* gfx, int16_t ox, int16_t oy, int16_t tipX, int16_t tipY, uint16_t color);
+
+    // Widen x0..x1 to the columns the needle covers within rows y0..y1
+    void addNeedleSpan(int16_t tipX, int16_t tipY, int16_t y0, int16_t y1, int16_t* x0, int16_t* x1);
+
+private:
+    GFXcanvas16* mFace;
+    int16_t mX;
+    int16_t mY;
+    uint16_t mSize;
+    int32_t mMin;
+    int32_t mMax;
+    uint16_t mFaceColor;
+    uint16_t mNeedleColor;
+    uint16_t mBackground;
+    bool mHasNeedle;
+    int16_t mTipX;
+    int16_t mTipY;
+    bool mIsValid;
+};
+
+#endif
+#endif
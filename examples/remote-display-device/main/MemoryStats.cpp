@@ -0,0 +1,207 @@
+/*
+ * MemoryStats.cpp
+ */
+#include <new>
+#include "MemoryStats.h"
+
+static const char* const HOT_PATH_NAMES[HOT_PATH_COUNT] = { "CAN frame", "display frame" };
+
+static volatile uint32_t sHotPathRuns[HOT_PATH_COUNT];
+static volatile uint32_t sHotPathAllocations[HOT_PATH_COUNT];
+#ifdef MEMORY_STATS_ALLOC_TRAP
+static volatile bool sAllocTrap = true;
+#else
+static volatile bool sAllocTrap = false;
+#endif
+
+// Hot path of the task that entered it, there is no thread local storage
+static volatile HotPath sCurrentPath = HOT_PATH_NONE;
+static TaskHandle_t volatile sCurrentTask = nullptr;
+
+#ifdef MEMORY_STATS_COUNT_ALLOCATIONS
+// Count an allocation made on the running hot path, if any
+static void countAllocation() {
+    HotPath path = sCurrentPath;
+    if (path != HOT_PATH_NONE && sCurrentTask == xTaskGetCurrentTaskHandle()) {
+        sHotPathAllocations[path]++;
+        if (sAllocTrap) {
+            abort();
+        }
+    }
+}
+
+static void* allocate(size_t size) {
+    countAllocation();
+    return malloc(size > 0 ? size : 1);
+}
+
+// Throw like the standard forms, or abort without exceptions
+static void* succeeded(void* ptr) {
+    if (ptr == nullptr) {
+#if __cpp_exceptions
+        throw std::bad_alloc();
+#else
+        abort();
+#endif
+    }
+    return ptr;
+}
+
+// Every form of new and delete is replaced so all of them pair malloc()
+// with free(), the core's own would not count or might not match
+void* operator new(size_t size) { return succeeded(allocate(size)); }
+void* operator new[](size_t size) { return succeeded(allocate(size)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+
+#if __cpp_aligned_new
+static void* allocateAligned(size_t size, std::align_val_t alignment) {
+    countAllocation();
+    size_t align = (size_t)alignment;
+    size_t rounded = size > 0 ? (size + align - 1) / align * align : align;
+    return aligned_alloc(align, rounded);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) { return succeeded(allocateAligned(size, alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return succeeded(allocateAligned(size, alignment)); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned(size, alignment); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { free(ptr); }
+#endif
+#endif
+
+HotPathScope::HotPathScope(HotPath path) {
+    mPrevious = sCurrentPath;
+    mPreviousTask = sCurrentTask;
+    sCurrentTask = xTaskGetCurrentTaskHandle();
+    sCurrentPath = path;
+    sHotPathRuns[path]++;
+}
+
+HotPathScope::~HotPathScope() {
+    sCurrentPath = mPrevious;
+    sCurrentTask = mPreviousTask;
+}
+
+MemoryStats::MemoryStats() {
+    mTaskCount = 0;
+    mHeapMinFree = UINT32_MAX;
+    mLastSampleMs = 0;
+}
+
+MemoryStats::~MemoryStats() {
+}
+
+bool MemoryStats::watchTask(TaskHandle_t task) {
+    if (task == nullptr) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    for (uint8_t i = 0; i < mTaskCount; i++) {
+        if (mTasks[i] == task) {
+            return true;
+        }
+    }
+    if (mTaskCount == MEMORY_STATS_TASKS_MAX) {
+        return false;
+    }
+    mTasks[mTaskCount++] = task;
+    return true;
+}
+
+void MemoryStats::loop() {
+    uint32_t nowMs = millis();
+    if (mHeapMinFree != UINT32_MAX && nowMs - mLastSampleMs < MEMORY_STATS_SAMPLE_MS) {
+        return;
+    }
+    mLastSampleMs = nowMs;
+    uint32_t heapFree = getHeapFree();
+    if (heapFree < mHeapMinFree) {
+        mHeapMinFree = heapFree;
+    }
+}
+
+uint32_t MemoryStats::getHeapFree() {
+    int heapFree = dbgHeapTotal() - dbgHeapUsed();
+    return heapFree > 0 ? heapFree : 0;
+}
+
+uint32_t MemoryStats::getLargestFreeBlock() {
+    // Binary search on malloc(), free bytes bound the answer
+    uint32_t low = 0;
+    uint32_t high = getHeapFree();
+    while (low < high) {
+        uint32_t size = low + (high - low + 1) / 2;
+        void* block = malloc(size);
+        if (block) {
+            free(block);
+            low = size;
+        } else {
+            high = size - 1;
+        }
+    }
+    return low;
+}
+
+uint32_t MemoryStats::getStackHighWater(uint8_t index) {
+    // FreeRTOS counts stacks in words
+    return uxTaskGetStackHighWaterMark(mTasks[index]) * sizeof(StackType_t);
+}
+
+uint32_t MemoryStats::getHotPathRuns(HotPath path) {
+    return sHotPathRuns[path];
+}
+
+uint32_t MemoryStats::getHotPathAllocations(HotPath path) {
+    return sHotPathAllocations[path];
+}
+
+void MemoryStats::resetHotPaths() {
+    for (uint8_t i = 0; i < HOT_PATH_COUNT; i++) {
+        sHotPathRuns[i] = 0;
+        sHotPathAllocations[i] = 0;
+    }
+}
+
+void MemoryStats::setAllocTrap(bool enabled) {
+    sAllocTrap = enabled;
+}
+
+void MemoryStats::print(Print& out) {
+    uint32_t heapFree = getHeapFree();
+    uint32_t largest = getLargestFreeBlock();
+    out.print("Heap free ");
+    out.print(heapFree);
+    out.print(" min ");
+    out.print(mHeapMinFree != UINT32_MAX ? mHeapMinFree : heapFree);
+    out.print(" largest ");
+    out.print(largest);
+    out.print(" fragmentation % ");
+    out.println(heapFree > 0 ? 100 - largest * 100 / heapFree : 0);
+    for (uint8_t i = 0; i < mTaskCount; i++) {
+        out.print("  Stack ");
+        out.print(getTaskName(i));
+        out.print(" unused ");
+        out.println(getStackHighWater(i));
+    }
+    for (uint8_t i = 0; i < HOT_PATH_COUNT; i++) {
+        out.print("  Hot path ");
+        out.print(HOT_PATH_NAMES[i]);
+        out.print(" runs ");
+        out.print(sHotPathRuns[i]);
+        out.print(" allocations ");
+        out.println(sHotPathAllocations[i]);
+    }
+}
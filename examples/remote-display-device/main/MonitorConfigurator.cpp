@@ -0,0 +1,180 @@
+/*
+ * MonitorConfigurator.cpp
+ */
+#include "MonitorConfigurator.h"
+
+MonitorConfigurator::MonitorConfigurator(SendFunction send) {
+    mSend = send;
+    reset();
+}
+
+MonitorConfigurator::~MonitorConfigurator() {
+}
+
+void MonitorConfigurator::reset() {
+    for (int i = 0; i < CONFIGURATOR_MONITORS_MAX; i++) {
+        mSlots[i].equation = nullptr;
+        mSlots[i].resultDeadlineMs = 0;
+        mSlots[i].exceptionType = 0;
+        mSlots[i].state = MONITOR_SLOT_REMOVED;
+        mSlots[i].nextChunk = 0;
+        mSlots[i].retries = 0;
+        mSlots[i].isWanted = false;
+    }
+    mCurrentId = -1;
+}
+
+bool MonitorConfigurator::add(uint8_t monitorId, const char* equation) {
+    if (monitorId >= CONFIGURATOR_MONITORS_MAX) {
+        return false;
+    }
+    Slot& slot = mSlots[monitorId];
+    slot.equation = equation;
+    slot.isWanted = true;
+    if (slot.state == MONITOR_SLOT_FAILED) {
+        // Asked again, give it a new set of retries
+        slot.state = MONITOR_SLOT_REMOVED;
+        slot.retries = 0;
+        slot.exceptionType = 0;
+    }
+    return true;
+}
+
+void MonitorConfigurator::remove(uint8_t monitorId) {
+    if (monitorId < CONFIGURATOR_MONITORS_MAX) {
+        mSlots[monitorId].isWanted = false;
+    }
+}
+
+void MonitorConfigurator::retry(Slot& slot) {
+    if (slot.retries < CONFIGURATOR_RETRIES_MAX) {
+        slot.retries++;
+        slot.state = MONITOR_SLOT_REMOVED;
+    } else {
+        slot.state = MONITOR_SLOT_FAILED;
+    }
+}
+
+bool MonitorConfigurator::sendNextChunk() {
+    Slot& slot = mSlots[mCurrentId];
+    uint8_t bytes[CONFIG_CHUNK_MAX];
+    size_t equationLen = strlen(slot.equation);
+    uint8_t len = buildConfigChunk(bytes, CMD_TYPE_ADD, mCurrentId, slot.equation, equationLen, slot.nextChunk);
+    if (!mSend(bytes, len)) {
+        // Not confirmed, resend the same chunk on the next step
+        return false;
+    }
+    slot.nextChunk++;
+    if (slot.nextChunk >= getConfigChunkCount(CMD_TYPE_ADD, equationLen)) {
+        // Complete, the app answers with a result write
+        slot.state = MONITOR_SLOT_AWAITING_RESULT;
+        slot.resultDeadlineMs = millis() + CONFIGURATOR_RESULT_TIMEOUT_MS;
+        mCurrentId = -1;
+    }
+    return true;
+}
+
+bool MonitorConfigurator::step() {
+    // Finish the monitor being added first, chunks must stay in sequence
+    if (mCurrentId >= 0) {
+        return sendNextChunk();
+    }
+
+    // Retry monitors the app never answered for
+    uint32_t ms = millis();
+    for (int i = 0; i < CONFIGURATOR_MONITORS_MAX; i++) {
+        Slot& slot = mSlots[i];
+        if (slot.state == MONITOR_SLOT_AWAITING_RESULT && (int32_t)(ms - slot.resultDeadlineMs) > 0) {
+            retry(slot);
+        }
+    }
+
+    // Remove before adding, so the app never holds more than needed
+    for (int i = 0; i < CONFIGURATOR_MONITORS_MAX; i++) {
+        Slot& slot = mSlots[i];
+        if (!slot.isWanted && slot.state != MONITOR_SLOT_REMOVED) {
+            uint8_t bytes[CONFIG_CHUNK_MAX];
+            uint8_t len = buildConfigChunk(bytes, CMD_TYPE_REMOVE, i, nullptr, 0, 0);
+            if (!mSend(bytes, len)) {
+                return false;
+            }
+            slot.state = MONITOR_SLOT_REMOVED;
+            slot.retries = 0;
+            slot.exceptionType = 0;
+            return true;
+        }
+    }
+    for (int i = 0; i < CONFIGURATOR_MONITORS_MAX; i++) {
+        Slot& slot = mSlots[i];
+        if (slot.isWanted && slot.state == MONITOR_SLOT_REMOVED && slot.equation) {
+            slot.state = MONITOR_SLOT_ADDING;
+            slot.nextChunk = 0;
+            mCurrentId = i;
+            return sendNextChunk();
+        }
+    }
+    return false;
+}
+
+void MonitorConfigurator::handleResult(const uint8_t* data, uint16_t len) {
+    RaceChronoProtocol::ConfigResult result;
+    if (!RaceChronoProtocol::decode_config_result(data, len, result) || result.monitor_id >= CONFIGURATOR_MONITORS_MAX) {
+        return;
+    }
+    Slot& slot = mSlots[result.monitor_id];
+    if (slot.state != MONITOR_SLOT_AWAITING_RESULT && slot.state != MONITOR_SLOT_ADDING) {
+        return;
+    }
+    switch (result.result) {
+        case CMD_RESULT_OK:
+            slot.state = MONITOR_SLOT_ACTIVE;
+            break;
+        case CMD_RESULT_PAYLOAD_OUT_OF_SEQUENCE:
+            if (mCurrentId == result.monitor_id) {
+                mCurrentId = -1;
+            }
+            retry(slot);
+            break;
+        case CMD_RESULT_EQUATION_EXCEPTION:
+            // Retrying the same equation will not help
+            if (mCurrentId == result.monitor_id) {
+                mCurrentId = -1;
+            }
+            slot.state = MONITOR_SLOT_FAILED;
+            slot.exceptionType = result.exception_type;
+            break;
+        default:
+            break;
+    }
+}
+
+bool MonitorConfigurator::isDone() {
+    for (int i = 0; i < CONFIGURATOR_MONITORS_MAX; i++) {
+        Slot& slot = mSlots[i];
+        if (slot.isWanted ? (slot.state == MONITOR_SLOT_REMOVED || slot.state == MONITOR_SLOT_ADDING || slot.state == MONITOR_SLOT_AWAITING_RESULT)
+                          : slot.state != MONITOR_SLOT_REMOVED) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint8_t MonitorConfigurator::getActiveCount() {
+    uint8_t count = 0;
+    for (int i = 0; i < CONFIGURATOR_MONITORS_MAX; i++) {
+        if (mSlots[i].state == MONITOR_SLOT_ACTIVE) {
+            count++;
+        }
+    }
+    return count;
+}
+
+uint8_t MonitorConfigurator::getWantedCount() {
+    uint8_t count = 0;
+    for (int i = 0; i < CONFIGURATOR_MONITORS_MAX; i++) {
+        if (mSlots[i].isWanted) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,92 @@
+/*
+ * MonitorConfigurator.h
+ */
+
+#ifndef MONITORCONFIGURATOR_H_
+#define MONITORCONFIGURATOR_H_
+#ifdef __cplusplus
+
+#include <Arduino.h>
+#include "ConfigCommand.h"
+
+#define CMD_RESULT_OK RaceChronoProtocol::MONITOR_RESULT_OK
+#define CMD_RESULT_PAYLOAD_OUT_OF_SEQUENCE RaceChronoProtocol::MONITOR_RESULT_OUT_OF_SEQUENCE
+#define CMD_RESULT_EQUATION_EXCEPTION RaceChronoProtocol::MONITOR_RESULT_EQUATION_EXCEPTION
+
+// Covers every one byte monitor ID the sketch hands out, 0 to 254
+static const uint8_t CONFIGURATOR_MONITORS_MAX = 255;
+static const uint8_t CONFIGURATOR_RETRIES_MAX = 3;
+static const uint32_t CONFIGURATOR_RESULT_TIMEOUT_MS = 2000;
+
+enum MonitorSlotState {
+    MONITOR_SLOT_REMOVED = 0,
+    MONITOR_SLOT_ADDING,
+    MONITOR_SLOT_AWAITING_RESULT,
+    MONITOR_SLOT_ACTIVE,
+    MONITOR_SLOT_FAILED
+};
+
+class MonitorConfigurator {
+public:
+    // Sends one indication, returns false if it was not confirmed
+    typedef bool (*SendFunction)(const uint8_t* bytes, uint8_t len);
+
+    MonitorConfigurator(SendFunction send);
+    virtual ~MonitorConfigurator();
+
+    // Forget all monitors, e.g. after a new connection
+    void reset();
+
+    // Ask for a monitor to be configured, the equation must stay valid.
+    // Returns false if the ID is beyond CONFIGURATOR_MONITORS_MAX.
+    bool add(uint8_t monitorId, const char* equation);
+
+    // Ask for a monitor to be removed
+    void remove(uint8_t monitorId);
+
+    // Send at most one chunk, returns true if anything was sent
+    bool step();
+
+    // Handle a result written by the app to the config characteristic
+    void handleResult(const uint8_t* data, uint16_t len);
+
+    // Return true when every monitor is either active, removed or failed
+    bool isDone();
+
+    // Get monitor state
+    MonitorSlotState getState(uint8_t monitorId) { return monitorId < CONFIGURATOR_MONITORS_MAX ? (MonitorSlotState)mSlots[monitorId].state : MONITOR_SLOT_REMOVED; }
+
+    // Get equation exception type of a failed monitor, 0 if none
+    uint16_t getExceptionType(uint8_t monitorId) { return monitorId < CONFIGURATOR_MONITORS_MAX ? mSlots[monitorId].exceptionType : 0; }
+
+    // Get number of active monitors
+    uint8_t getActiveCount();
+
+    // Get number of monitors asked to be configured
+    uint8_t getWantedCount();
+
+private:
+    struct Slot {
+        const char* equation;
+        uint32_t resultDeadlineMs;
+        uint16_t exceptionType;
+        uint8_t state;
+        uint8_t nextChunk;
+        uint8_t retries;
+        bool isWanted;
+    };
+
+    // Schedule a retry of a monitor, or give up after too many
+    void retry(Slot& slot);
+
+    // Send the next chunk of the monitor being added
+    bool sendNextChunk();
+
+private:
+    SendFunction mSend;
+    Slot mSlots[CONFIGURATOR_MONITORS_MAX];
+    int mCurrentId;
+};
+
+#endif
+#endif
@@ -0,0 +1,86 @@
+/*
+ * TextField.cpp
+ */
+#include "TextField.h"
+
+TextField::TextField() {
+    mX = 0;
+    mY = 0;
+    mWidth = 0;
+    mTextSize = 1;
+    mIsValid = false;
+    mText[0] = '\0';
+}
+
+TextField::~TextField() {
+}
+
+void TextField::begin(int16_t x, int16_t y, uint8_t width, uint8_t textSize) {
+    mX = x;
+    mY = y;
+    mWidth = min(width, TEXT_FIELD_MAX);
+    mTextSize = textSize;
+    mIsValid = false;
+}
+
+uint16_t TextField::draw(Adafruit_GFX* gfx, const char* text, uint16_t color, uint16_t background) {
+    uint16_t cellsDrawn = 0;
+    size_t textLen = strnlen(text, mWidth);
+    for (uint8_t i = 0; i < mWidth; i++) {
+        char c = getCell(text, textLen, i);
+        if (!mIsValid || c != mText[i]) {
+            gfx->drawChar(getCellX(i), mY, c, color, background, mTextSize);
+            cellsDrawn++;
+        }
+        mText[i] = c;
+    }
+    mText[mWidth] = '\0';
+    mIsValid = true;
+    return cellsDrawn;
+}
+
+bool TextField::getChangedSpan(const char* text, uint8_t* first, uint8_t* last) {
+    if (mWidth == 0) {
+        return false;
+    }
+    if (!mIsValid) {
+        *first = 0;
+        *last = mWidth - 1;
+        return true;
+    }
+    size_t textLen = strnlen(text, mWidth);
+    bool isChanged = false;
+    for (uint8_t i = 0; i < mWidth; i++) {
+        if (getCell(text, textLen, i) != mText[i]) {
+            if (!isChanged) {
+                *first = i;
+                isChanged = true;
+            }
+            *last = i;
+        }
+    }
+    return isChanged;
+}
+
+void TextField::drawSpan(Adafruit_GFX* tile, const char* text, uint8_t first, uint8_t last, uint16_t color, uint16_t background) {
+    size_t textLen = strnlen(text, mWidth);
+    for (uint8_t i = first; i <= last && i < mWidth; i++) {
+        char c = getCell(text, textLen, i);
+        tile->drawChar((i - first) * getCellWidth(), 0, c, color, background, mTextSize);
+        mText[i] = c;
+    }
+    if (!mIsValid) {
+        // Cells outside the span were never drawn
+        for (uint8_t i = 0; i < mWidth; i++) {
+            mText[i] = getCell(text, textLen, i);
+        }
+        mIsValid = true;
+    }
+    mText[mWidth] = '\0';
+}
+
+uint32_t TextField::getSpiBytesPerCell() {
+    // drawChar() with a background fills every pixel of the 6x8 cell as its own
+    // rectangle: ~10 bytes of address window commands plus 2 bytes per pixel
+    return 6 * 8 * (10 + 2 * mTextSize * mTextSize);
+}
@@ -0,0 +1,57 @@
+/*
+ * TextField.h
+ */
+
+#ifndef TEXTFIELD_H_
+#define TEXTFIELD_H_
+#ifdef __cplusplus
+
+#include <Adafruit_GFX.h>
+
+static const uint8_t TEXT_FIELD_MAX = 24;
+
+class TextField {
+public:
+    TextField();
+    virtual ~TextField();
+
+    // Place field at pixel position, width in characters
+    void begin(int16_t x, int16_t y, uint8_t width, uint8_t textSize);
+
+    // Draw text, redrawing only the character cells that changed since the previous draw.
+    // Returns the number of cells drawn.
+    uint16_t draw(Adafruit_GFX* gfx, const char* text, uint16_t color, uint16_t background);
+
+    // Get first and last cell that differ from the rendered text, false if nothing changed
+    bool getChangedSpan(const char* text, uint8_t* first, uint8_t* last);
+
+    // Draw cells first..last into a tile whose origin is the first cell, and remember the text
+    void drawSpan(Adafruit_GFX* tile, const char* text, uint8_t first, uint8_t last, uint16_t color, uint16_t background);
+
+    // Forget the rendered text, the next draw redraws every cell
+    void invalidate() { mIsValid = false; }
+
+    // Get estimated SPI bytes sent for drawing cells of this field
+    uint32_t getSpiBytesPerCell();
+
+    // Get cell geometry in pixels
+    int16_t getCellX(uint8_t cell) { return mX + cell * getCellWidth(); }
+    int16_t getY() { return mY; }
+    uint16_t getCellWidth() { return 6 * mTextSize; }
+    uint16_t getCellHeight() { return 8 * mTextSize; }
+
+private:
+    // Get character for a cell, padded with spaces past the end of text
+    char getCell(const char* text, size_t textLen, uint8_t cell) { return cell < textLen ? text[cell] : ' '; }
+
+private:
+    int16_t mX;
+    int16_t mY;
+    uint8_t mWidth;
+    uint8_t mTextSize;
+    bool mIsValid;
+    char mText[TEXT_FIELD_MAX + 1];
+};
+
+#endif
+#endif
@@ -0,0 +1,102 @@
+/*
+ * TileRenderer.cpp
+ */
+#include "TileRenderer.h"
+
+TileCanvas::TileCanvas(uint16_t width, uint16_t height) : GFXcanvas16(width, height) {
+    mCapacity = getBuffer() ? (uint32_t)width * height : 0;
+}
+
+bool TileCanvas::setSize(uint16_t width, uint16_t height) {
+    if ((uint32_t)width * height > mCapacity) {
+        return false;
+    }
+    WIDTH = _width = width;
+    HEIGHT = _height = height;
+    return true;
+}
+
+TileRenderer::TileRenderer() {
+    mDisplay = nullptr;
+    mCanvases[0] = nullptr;
+    mCanvases[1] = nullptr;
+    mCurrent = 0;
+    mX = 0;
+    mY = 0;
+    mIsTransferring = false;
+}
+
+TileRenderer::~TileRenderer() {
+    finish();
+    delete mCanvases[0];
+    delete mCanvases[1];
+}
+
+bool TileRenderer::begin(Adafruit_SPITFT* display, uint16_t maxWidth, uint16_t maxHeight) {
+    mDisplay = display;
+    for (int i = 0; i < 2; i++) {
+        mCanvases[i] = new TileCanvas(maxWidth, maxHeight);
+        if (!mCanvases[i]->getBuffer()) {
+            // Not enough RAM, callers fall back to drawing directly
+            delete mCanvases[0];
+            delete mCanvases[1];
+            mCanvases[0] = nullptr;
+            mCanvases[1] = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+Adafruit_GFX* TileRenderer::beginTile(int16_t x, int16_t y, uint16_t width, uint16_t height, uint16_t background) {
+    // The other buffer may still be transferring, this one finished before it started
+    TileCanvas* canvas = mCanvases[mCurrent];
+    if (!canvas || !canvas->setSize(width, height)) {
+        return nullptr;
+    }
+    canvas->fillScreen(background);
+    mX = x;
+    mY = y;
+    return canvas;
+}
+
+uint16_t* TileRenderer::beginTilePixels(int16_t x, int16_t y, uint16_t width, uint16_t height) {
+    // Not cleared, the caller writes every pixel
+    GFXcanvas16* canvas = beginTileCanvas(x, y, width, height);
+    return canvas ? canvas->getBuffer() : nullptr;
+}
+
+GFXcanvas16* TileRenderer::beginTileCanvas(int16_t x, int16_t y, uint16_t width, uint16_t height) {
+    TileCanvas* canvas = mCanvases[mCurrent];
+    if (!canvas || !canvas->setSize(width, height)) {
+        return nullptr;
+    }
+    mX = x;
+    mY = y;
+    return canvas;
+}
+
+void TileRenderer::endTile() {
+    TileCanvas* canvas = mCanvases[mCurrent];
+
+    // One transfer at a time on the bus, wait for the previous tile
+    if (mIsTransferring) {
+        mDisplay->dmaWait();
+        mDisplay->endWrite();
+    }
+    mDisplay->startWrite();
+    mDisplay->setAddrWindow(mX, mY, canvas->width(), canvas->height());
+    mDisplay->writePixels(canvas->getBuffer(), (uint32_t)canvas->width() * canvas->height(), false, false);
+    mIsTransferring = true;
+
+    // Compose the next tile in the other buffer while this one goes out
+    mCurrent ^= 1;
+}
+
+void TileRenderer::finish() {
+    if (mIsTransferring) {
+        mDisplay->dmaWait();
+        mDisplay->endWrite();
+        mIsTransferring = false;
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * TileRenderer.h
+ */
+
+#ifndef TILERENDERER_H_
+#define TILERENDERER_H_
+#ifdef __cplusplus
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SPITFT.h>
+
+// Canvas whose size can shrink to the tile being composed, so the pixels of
+// any tile up to the allocated size are contiguous for one bulk transfer
+class TileCanvas : public GFXcanvas16 {
+public:
+    TileCanvas(uint16_t width, uint16_t height);
+
+    // Resize within the allocated buffer, false if it does not fit
+    bool setSize(uint16_t width, uint16_t height);
+
+private:
+    uint32_t mCapacity;
+};
+
+class TileRenderer {
+public:
+    TileRenderer();
+    virtual ~TileRenderer();
+
+    // Allocate two tile buffers up to the given size, false if there is not enough RAM
+    bool begin(Adafruit_SPITFT* display, uint16_t maxWidth, uint16_t maxHeight);
+
+    // Get a cleared canvas to compose the tile at x, y, or nullptr if it does not fit
+    Adafruit_GFX* beginTile(int16_t x, int16_t y, uint16_t width, uint16_t height, uint16_t background);
+
+    // Get the raw pixels of a tile at x, y that the caller fills completely, or nullptr if it does not fit
+    uint16_t* beginTilePixels(int16_t x, int16_t y, uint16_t width, uint16_t height);
+
+    // Get the canvas of a tile at x, y without clearing it, or nullptr if it does not fit
+    GFXcanvas16* beginTileCanvas(int16_t x, int16_t y, uint16_t width, uint16_t height);
+
+    // Start pushing the composed tile to the display, returns while DMA is still running
+    void endTile();
+
+    // Wait until the last tile is on the display and release the bus
+    void finish();
+
+private:
+    Adafruit_SPITFT* mDisplay;
+    TileCanvas* mCanvases[2];
+    uint8_t mCurrent;
+    int16_t mX;
+    int16_t mY;
+    bool mIsTransferring;
+};
+
+#endif
+#endif
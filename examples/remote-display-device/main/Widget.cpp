@@ -0,0 +1,124 @@
+/*
+ * Widget.cpp
+ */
+#include "Widget.h"
+#include "FixedFormat.h"
+#include "BigFont.h"
+
+Widget::Widget() {
+    mDefinition = nullptr;
+    mX = 0;
+    mY = 0;
+    mWidth = 0;
+    mHeight = 0;
+    mBarEnd = 0;
+    mIsBarValid = false;
+}
+
+Widget::~Widget() {
+}
+
+void Widget::begin(const WidgetDefinition* definition, int16_t x, int16_t y, uint16_t width, uint8_t textSize) {
+    mDefinition = definition;
+    mX = x;
+    mY = y;
+    mWidth = width;
+    mField.begin(x, y, width / (6 * textSize), textSize);
+    mBigField.begin(x, y, width / getBigFontWidth());
+    mHeight = isBig() ? mBigField.getHeight() : 8 * textSize;
+    if (isGauge()) {
+        mGauge.begin(x, y, min(width, GAUGE_SIZE_MAX), definition->min, definition->max, definition->negativeColor, definition->color, 0);
+        mHeight = mGauge.getSize();
+    }
+    invalidate();
+}
+
+void Widget::invalidate() {
+    mField.invalidate();
+    mBigField.invalidate();
+    mGauge.invalidate();
+    mIsBarValid = false;
+}
+
+bool Widget::format(char* text, int32_t raw, uint8_t rawDecimals) {
+    switch (mDefinition->type) {
+        case WIDGET_NUMBER:
+            formatFixed(text, raw, rawDecimals, mDefinition->decimals);
+            return true;
+        case WIDGET_LAP_TIME:
+            formatLapTime(text, raw, rawDecimals);
+            return true;
+        default:
+            return false;
+    }
+}
+
+int16_t Widget::getBarEnd(int32_t raw) {
+    int32_t range = mDefinition->max - mDefinition->min;
+    if (mDefinition->type == WIDGET_DELTA_BAR) {
+        // Grows from the center, right above zero and left below
+        int32_t half = mWidth / 2;
+        int32_t limit = mDefinition->max > 0 ? mDefinition->max : 1;
+        int64_t offset = (int64_t)raw * half / limit;
+        offset = offset > half ? half : offset < -half ? -half : offset;
+        return (int16_t)(half + offset);
+    }
+    if (range <= 0) {
+        return 0;
+    }
+    int64_t end = ((int64_t)raw - mDefinition->min) * mWidth / range;
+    return (int16_t)(end < 0 ? 0 : end > mWidth ? mWidth : end);
+}
+
+uint32_t Widget::fillBar(Adafruit_GFX* gfx, int16_t from, int16_t to, uint16_t color) {
+    if (to <= from) {
+        return 0;
+    }
+    gfx->fillRect(mX + from, mY, to - from, mHeight, color);
+    return 10 + 2 * (uint32_t)(to - from) * mHeight;
+}
+
+uint32_t Widget::drawGauge(TileRenderer* renderer, Adafruit_SPITFT* display, int32_t raw, bool isValid) {
+    return isGauge() ? mGauge.draw(renderer, display, raw, isValid) : 0;
+}
+
+uint32_t Widget::drawBar(Adafruit_GFX* gfx, int32_t raw, bool isValid, uint16_t background) {
+    if (isText() || isGauge()) {
+        return 0;
+    }
+    int16_t center = mDefinition->type == WIDGET_DELTA_BAR ? mWidth / 2 : 0;
+    int16_t end = isValid ? getBarEnd(raw) : center;
+    uint32_t spiBytes = 0;
+    if (!mIsBarValid) {
+        spiBytes += fillBar(gfx, 0, mWidth, background);
+        mBarEnd = center;
+        mIsBarValid = true;
+    }
+    if (end == mBarEnd) {
+        return spiBytes;
+    }
+
+    // Only the pixels between the old and the new end change, unless the
+    // delta bar crosses the center, then the old side is cleared first
+    if ((mBarEnd > center && end < center) || (mBarEnd < center && end > center)) {
+        spiBytes += mBarEnd > center ? fillBar(gfx, center, mBarEnd, background) : fillBar(gfx, mBarEnd, center, background);
+        mBarEnd = center;
+    }
+    if (end > center || (end == center && mBarEnd > center)) {
+        // Right of center
+        if (end > mBarEnd) {
+            spiBytes += fillBar(gfx, mBarEnd, end, mDefinition->color);
+        } else {
+            spiBytes += fillBar(gfx, end, mBarEnd, background);
+        }
+    } else {
+        // Left of center
+        if (end < mBarEnd) {
+            spiBytes += fillBar(gfx, end, mBarEnd, mDefinition->negativeColor);
+        } else {
+            spiBytes += fillBar(gfx, mBarEnd, end, background);
+        }
+    }
+    mBarEnd = end;
+    return spiBytes;
+}
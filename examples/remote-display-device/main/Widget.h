@@ -0,0 +1,101 @@
+/*
+ * Widget.h
+ */
+
+#ifndef WIDGET_H_
+#define WIDGET_H_
+#ifdef __cplusplus
+
+#include <Adafruit_GFX.h>
+#include "TextField.h"
+#include "BigTextField.h"
+#include "Gauge.h"
+
+enum WidgetType {
+    WIDGET_NUMBER = 0,
+    WIDGET_LAP_TIME,
+    WIDGET_BAR,
+    WIDGET_DELTA_BAR,
+    WIDGET_GAUGE
+};
+
+enum WidgetFont {
+    WIDGET_FONT_TEXT = 0,   // Default GFX font at the row text size
+    WIDGET_FONT_BIG         // Pre-rendered large digits, for numbers and lap times
+};
+
+// One row of the layout, declared in a table
+struct WidgetDefinition {
+    uint8_t type;
+    uint8_t monitorId;
+    uint8_t decimals;   // Shown decimals of a number
+    int32_t min;        // Raw value of an empty bar or gauge
+    int32_t max;        // Raw value of a full bar or gauge, or of a full half of a delta bar
+    uint16_t color;     // Text, bar or needle color, a delta bar uses it above zero
+    uint16_t negativeColor; // Delta bar color below zero, gauge face color
+    uint8_t font;
+};
+
+class Widget {
+public:
+    Widget();
+    virtual ~Widget();
+
+    // Place widget at pixel position, a row of the given text size high
+    void begin(const WidgetDefinition* definition, int16_t x, int16_t y, uint16_t width, uint8_t textSize);
+
+    // Forget what was drawn, the next draw redraws everything
+    void invalidate();
+
+    // Write the value into text (FIXED_FORMAT_MAX long), returns false for bars
+    bool format(char* text, int32_t raw, uint8_t rawDecimals);
+
+    // Draw bar for the value, only the pixels that changed. Returns estimated SPI bytes.
+    uint32_t drawBar(Adafruit_GFX* gfx, int32_t raw, bool isValid, uint16_t background);
+
+    // Draw gauge needle for the value, only the parts that changed. Returns estimated SPI bytes.
+    uint32_t drawGauge(TileRenderer* renderer, Adafruit_SPITFT* display, int32_t raw, bool isValid);
+
+    // Get field for the text of numbers and lap times
+    TextField* getField() { return &mField; }
+
+    // Get field for numbers and lap times in the large-digit font
+    BigTextField* getBigField() { return &mBigField; }
+
+    // Get row height in pixels
+    uint16_t getHeight() { return mHeight; }
+
+    // Get definition
+    const WidgetDefinition* getDefinition() { return mDefinition; }
+
+    // Check if widget is drawn as text
+    bool isText() { return mDefinition && (mDefinition->type == WIDGET_NUMBER || mDefinition->type == WIDGET_LAP_TIME); }
+
+    // Check if widget is a gauge
+    bool isGauge() { return mDefinition && mDefinition->type == WIDGET_GAUGE; }
+
+    // Check if text is drawn with the large-digit font
+    bool isBig() { return isText() && mDefinition->font == WIDGET_FONT_BIG; }
+
+private:
+    // Get bar end in pixels from the left edge, a delta bar starts at the center
+    int16_t getBarEnd(int32_t raw);
+
+    // Fill pixels from..to-1 of the bar, returns estimated SPI bytes
+    uint32_t fillBar(Adafruit_GFX* gfx, int16_t from, int16_t to, uint16_t color);
+
+private:
+    const WidgetDefinition* mDefinition;
+    TextField mField;
+    BigTextField mBigField;
+    Gauge mGauge;
+    int16_t mX;
+    int16_t mY;
+    uint16_t mWidth;
+    uint16_t mHeight;
+    int16_t mBarEnd;
+    bool mIsBarValid;
+};
+
+#endif
+#endif
@@ -1,48 +1,173 @@
 #include <Adafruit_Arcada.h>
 #include <bluefruit.h>
+#include "TextField.h"
+#include "TileRenderer.h"
+#include "Widget.h"
+#include "FixedFormat.h"
+#include "MonitorConfigurator.h"
+#include "MemoryStats.h"
+#include "racechrono_protocol.hpp"
 
-#define CMD_TYPE_REMOVE_ALL 0
-#define CMD_TYPE_REMOVE 1
-#define CMD_TYPE_ADD_INCOMPLETE 2
-#define CMD_TYPE_ADD 3
-#define CMD_TYPE_UPDATE_ALL 4
-#define CMD_TYPE_UPDATE 5
+//
+// Enable to show refresh time, estimated SPI bytes, latency and format time
+// per value on the bottom line
+//
+//#define SHOW_DISPLAY_STATS
 
-#define CMD_RESULT_OK 0
-#define CMD_RESULT_PAYLOAD_OUT_OF_SEQUENCE 1
-#define CMD_RESULT_EQUATION_EXCEPTION 2
-
-#define MAX_REMAINING_PAYLOAD 2048
-#define MAX_PAYLOAD_PART 17
 #define MONITOR_NAME_MAX 32
-#define MONITORS_MAX 255
+#define MONITORS_MAX CONFIGURATOR_MONITORS_MAX
+#define DISPLAY_WIDGETS_MAX 16
+#define DISPLAY_TEXT_SIZE 2
 
 static const int32_t INVALID_VALUE = 0x7fffffff;
 
 Adafruit_Arcada arcada;
-BLEService mainService = BLEService(0x1ff8);
-BLECharacteristic monitorConfigCharacteristic = BLECharacteristic (0x05);
-BLECharacteristic monitorNotificationCharacteristic = BLECharacteristic (0x06);
+BLEService mainService = BLEService(RaceChronoProtocol::SERVICE_UUID);
+BLECharacteristic monitorConfigCharacteristic = BLECharacteristic (RaceChronoProtocol::MONITOR_CONFIG_UUID);
+BLECharacteristic monitorNotificationCharacteristic = BLECharacteristic (RaceChronoProtocol::MONITOR_NOTIFY_UUID);
 
 char monitorNames[MONITORS_MAX][MONITOR_NAME_MAX+1];
-float monitorMultipliers[MONITORS_MAX];
+uint8_t monitorDecimals[MONITORS_MAX];
 int32_t monitorValues[MONITORS_MAX];
 int nextMonitorId = 0;
 
+struct MonitorDefinition {
+    const char* name;
+    const char* equation;
+    uint8_t decimals; // Implied decimals of the raw integer value
+};
+
+static const MonitorDefinition MONITOR_DEFINITIONS[] = {
+    { "Time", "channel(device(gps), elapsed_time)*10.0", 1 },
+    { "Speed", "channel(device(gps), speed)*10.0", 1 },
+    { "Altitude", "channel(device(gps), altitude)", 0 },
+    { "Curr lap", "channel(device(lap), lap_number)", 0 },
+    { "Curr time", "channel(device(lap), lap_time)*10.0", 1 },
+    { "Prev lap", "channel(device(lap), previous_lap_number)", 0 },
+    { "Prev time", "channel(device(lap), previous_lap_time)*10.0", 1 },
+    { "Best lap", "channel(device(lap), best_lap_number)", 0 },
+    { "Best time", "channel(device(lap), best_lap_time)*10.0", 1 },
+    { "Prev delta", "(channel(device(lap), previous_lap_time)-channel(device(lap), best_lap_time))*10.0", 1 },
+    { "Satellites", "channel(device(gps), satellites)", 0 },
+    { "Accuracy", "channel(device(gps), accuracy)*10.0", 1 },
+    { "Bearing", "channel(device(gps), bearing)", 0 },
+};
+static const int MONITOR_DEFINITION_COUNT = sizeof(MONITOR_DEFINITIONS) / sizeof(MONITOR_DEFINITIONS[0]);
+
+// Display pages, one row per widget, labelled with the monitor name
+static const WidgetDefinition LAP_PAGE_WIDGETS[] = {
+    { WIDGET_NUMBER, 3, 0, 0, 0, ARCADA_WHITE, ARCADA_WHITE },
+    { WIDGET_LAP_TIME, 4, 0, 0, 0, ARCADA_WHITE, ARCADA_WHITE, WIDGET_FONT_BIG },
+    { WIDGET_NUMBER, 9, 1, 0, 0, ARCADA_WHITE, ARCADA_WHITE, WIDGET_FONT_BIG },
+    { WIDGET_DELTA_BAR, 9, 0, 0, 50, ARCADA_RED, ARCADA_GREEN }, // Slower right, faster left, full at 5 s
+    { WIDGET_LAP_TIME, 8, 0, 0, 0, ARCADA_WHITE, ARCADA_WHITE },
+};
+static const WidgetDefinition GPS_PAGE_WIDGETS[] = {
+    { WIDGET_LAP_TIME, 0, 0, 0, 0, ARCADA_WHITE, ARCADA_WHITE },
+    { WIDGET_NUMBER, 1, 1, 0, 0, ARCADA_WHITE, ARCADA_WHITE, WIDGET_FONT_BIG },
+    { WIDGET_NUMBER, 2, 0, 0, 0, ARCADA_WHITE, ARCADA_WHITE },
+    { WIDGET_GAUGE, 1, 0, 0, 3000, ARCADA_RED, ARCADA_WHITE },
+};
+static const WidgetDefinition HISTORY_PAGE_WIDGETS[] = {
+    { WIDGET_NUMBER, 5, 0, 0, 0, ARCADA_WHITE, ARCADA_WHITE },
+    { WIDGET_LAP_TIME, 6, 0, 0, 0, ARCADA_WHITE, ARCADA_WHITE },
+    { WIDGET_NUMBER, 7, 0, 0, 0, ARCADA_WHITE, ARCADA_WHITE },
+    { WIDGET_LAP_TIME, 8, 0, 0, 0, ARCADA_WHITE, ARCADA_WHITE },
+};
+
+static const WidgetDefinition FIX_PAGE_WIDGETS[] = {
+    { WIDGET_NUMBER, 10, 0, 0, 0, ARCADA_WHITE, ARCADA_WHITE },
+    { WIDGET_NUMBER, 11, 1, 0, 0, ARCADA_WHITE, ARCADA_WHITE },
+    { WIDGET_NUMBER, 12, 0, 0, 0, ARCADA_WHITE, ARCADA_WHITE },
+};
+
+struct PageDefinition {
+    const WidgetDefinition* widgets;
+    uint8_t widgetCount;
+};
+
+#define PAGE(widgets) { widgets, sizeof(widgets) / sizeof(widgets[0]) }
+static const PageDefinition PAGE_DEFINITIONS[] = {
+    PAGE(LAP_PAGE_WIDGETS),
+    PAGE(GPS_PAGE_WIDGETS),
+    PAGE(HISTORY_PAGE_WIDGETS),
+    PAGE(FIX_PAGE_WIDGETS),
+};
+static const int PAGE_COUNT = sizeof(PAGE_DEFINITIONS) / sizeof(PAGE_DEFINITIONS[0]);
+int currentPage = 0;
+uint32_t lastButtons = 0;
+
+// Results written by the app, queued from the Bluetooth task to the loop
+struct MonitorConfigResult {
+    uint8_t data[4];
+    uint8_t len;
+};
+static const int MONITOR_CONFIG_RESULT_QUEUE_LEN = 8;
+QueueHandle_t monitorConfigResultQueue = NULL;
+
+bool monitorConfigSend(const uint8_t* bytes, uint8_t len);
+
+MonitorConfigurator monitorConfigurator(monitorConfigSend);
+
+//
+// Advertising policy, intervals in unit of 0.625 ms. Fast after boot, disconnect
+// or wake, then doubling every step up to the maximum while nobody connects.
+//
+static const uint16_t ADV_FAST_INTERVAL = 32; // 20 ms
+static const uint32_t ADV_FAST_MS = 30000;
+static const uint16_t ADV_BACKOFF_INTERVAL = 244; // 152.5 ms
+static const uint16_t ADV_MAX_INTERVAL = 3200; // 2 s
+static const uint32_t ADV_BACKOFF_STEP_MS = 60000;
+uint16_t bluetoothAdvInterval = 0;
+uint32_t bluetoothAdvPhaseStartMs = 0;
+ble_gap_addr_t bluetoothLastCentral;
+boolean bluetoothHasLastCentral = false;
+uint32_t bluetoothDisconnectMs = 0;
+uint32_t bluetoothLastReconnectMs = 0;
+
 boolean wasConnected = true;
+boolean monitorConfigRequested = false;
 boolean monitorConfigStarted = false;
 boolean displayStarted = false;
-int displayUpdateCount = 0;
+static const uint32_t DISPLAY_FRAME_MS = 33; // Frame rate cap, ~30 fps
+static const uint32_t DISPLAY_IDLE_WAKE_MS = 50; // Buttons are polled
+static const uint32_t DISPLAY_DISCONNECTED_WAKE_MS = 50;
+static const uint32_t DISPLAY_CONFIGURING_WAKE_MS = 20;
+SemaphoreHandle_t displayWakeSemaphore = NULL;
+uint32_t displayChangedIds[(MONITORS_MAX + 31) / 32];
+boolean displayHasPendingChange = false;
+uint32_t displayPendingSinceMs = 0;
+uint32_t displayLastFrameMs = 0;
+uint32_t displayLastLatencyMs = 0;
+uint32_t displayMaxLatencyMs = 0;
+TileRenderer displayRenderer;
+Widget displayWidgets[DISPLAY_WIDGETS_MAX];
+TextField displayReconnectField;
+TextField displayConfigField;
+int displayWidgetCount = 0;
+uint32_t displayLastRefreshUs = 0;
+uint32_t displayLastRefreshSpiBytes = 0;
+uint32_t displayLastFormatNs = 0;
+MemoryStats memoryStats;
+#ifdef SHOW_DISPLAY_STATS
+TextField displayStatsField;
+uint32_t displayBigGlyphUs = 0;
+uint32_t displayScaledGlyphUs = 0;
+uint32_t displayGaugeFps = 0;
+#endif
 
 void monitorConfigWriteCallback(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len);
 
 void monitorNotificationWriteCallback(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len);
 
+void monitorConfigCccdWriteCallback(uint16_t conn_hdl, BLECharacteristic* chr, uint16_t value);
+
 void bluetoothSetupMainService() {
     mainService.begin();
     monitorConfigCharacteristic.setProperties(CHR_PROPS_INDICATE | CHR_PROPS_WRITE);
     monitorConfigCharacteristic.setPermission(SECMODE_OPEN, SECMODE_OPEN);
     monitorConfigCharacteristic.setWriteCallback(monitorConfigWriteCallback);
+    monitorConfigCharacteristic.setCccdWriteCallback(monitorConfigCccdWriteCallback);
     monitorConfigCharacteristic.begin();
     monitorNotificationCharacteristic.setProperties(CHR_PROPS_WRITE_WO_RESP);
     monitorNotificationCharacteristic.setPermission(SECMODE_NO_ACCESS, SECMODE_OPEN);
@@ -50,16 +175,92 @@ void bluetoothSetupMainService() {
     monitorNotificationCharacteristic.begin();
 }
 
+void bluetoothStartUndirectedAdvertising(uint16_t interval) {
+    Bluefruit.Advertising.stop();
+    Bluefruit.Advertising.setType(BLE_GAP_ADV_TYPE_CONNECTABLE_SCANNABLE_UNDIRECTED);
+    Bluefruit.Advertising.setStopCallback(NULL);
+    Bluefruit.Advertising.setInterval(interval, interval);
+    Bluefruit.Advertising.start(0);
+    bluetoothAdvInterval = interval;
+    bluetoothAdvPhaseStartMs = millis();
+}
+
+void bluetoothDirectedAdvertisingStopCallback(void) {
+    // The last central did not come back, fall back to undirected advertising
+    if (!Bluefruit.connected()) {
+        bluetoothStartUndirectedAdvertising(ADV_FAST_INTERVAL);
+    }
+}
+
+void bluetoothStartDirectedAdvertising(void) {
+    Bluefruit.Advertising.stop();
+    Bluefruit.Advertising.setType(BLE_GAP_ADV_TYPE_CONNECTABLE_NONSCANNABLE_DIRECTED_HIGH_DUTY_CYCLE);
+    Bluefruit.Advertising.setPeerAddress(bluetoothLastCentral);
+    Bluefruit.Advertising.setStopCallback(bluetoothDirectedAdvertisingStopCallback);
+    Bluefruit.Advertising.start(1); // High duty cycle is limited to 1.28 s by the spec
+    bluetoothAdvInterval = 0;
+}
+
+void bluetoothAdvertisingLoop() {
+    // Back off exponentially while nobody connects
+    if (Bluefruit.connected() || bluetoothAdvInterval == 0) {
+        return;
+    }
+    uint32_t elapsedMs = millis() - bluetoothAdvPhaseStartMs;
+    if (bluetoothAdvInterval == ADV_FAST_INTERVAL) {
+        if (elapsedMs > ADV_FAST_MS) {
+            bluetoothStartUndirectedAdvertising(ADV_BACKOFF_INTERVAL);
+        }
+    } else if (bluetoothAdvInterval < ADV_MAX_INTERVAL && elapsedMs > ADV_BACKOFF_STEP_MS) {
+        bluetoothStartUndirectedAdvertising(min(ADV_MAX_INTERVAL, (uint16_t)(bluetoothAdvInterval * 2)));
+    }
+}
+
+void bluetoothWake() {
+    // Re-escalate to fast advertising when backed off
+    if (!Bluefruit.connected() && bluetoothAdvInterval > ADV_FAST_INTERVAL) {
+        bluetoothStartUndirectedAdvertising(ADV_FAST_INTERVAL);
+    }
+}
+
+void bluetoothConnectCallback(uint16_t conn_hdl) {
+    // Remember the central for directed advertising after a drop. Without
+    // bonding there is no IRK, and a resolvable private address will have
+    // changed by the time the central comes back
+    bluetoothLastCentral = Bluefruit.Connection(conn_hdl)->getPeerAddr();
+    bluetoothHasLastCentral = bluetoothLastCentral.addr_type != BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_RESOLVABLE;
+    bluetoothAdvInterval = 0;
+    displayWake();
+}
+
+void bluetoothDisconnectCallback(uint16_t conn_hdl, uint8_t reason) {
+    displayWake();
+    bluetoothDisconnectMs = millis();
+    if (bluetoothHasLastCentral) {
+        bluetoothStartDirectedAdvertising();
+    } else {
+        bluetoothStartUndirectedAdvertising(ADV_FAST_INTERVAL);
+    }
+}
+
+void bluetoothMarkValueReceived() {
+    // Report disconnect-to-first-value time once per reconnect
+    if (bluetoothDisconnectMs != 0) {
+        bluetoothLastReconnectMs = millis() - bluetoothDisconnectMs;
+        bluetoothDisconnectMs = 0;
+    }
+}
+
 void bluetoothStartAdvertising(void) {
     Bluefruit.setTxPower(+4);
     Bluefruit.Advertising.addFlags(BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE);
     Bluefruit.Advertising.addTxPower();
     Bluefruit.Advertising.addService(mainService);
     Bluefruit.Advertising.addName();
-    Bluefruit.Advertising.restartOnDisconnect(true);
-    Bluefruit.Advertising.setInterval(160, 160); // in unit of 0.625 ms
-    Bluefruit.Advertising.setFastTimeout(30);
-    Bluefruit.Advertising.start(0);
+    Bluefruit.Advertising.restartOnDisconnect(false);
+    Bluefruit.Periph.setConnectCallback(bluetoothConnectCallback);
+    Bluefruit.Periph.setDisconnectCallback(bluetoothDisconnectCallback);
+    bluetoothStartUndirectedAdvertising(ADV_FAST_INTERVAL);
 }
 
 void bluetoothStart() {
@@ -74,144 +275,333 @@ void bluetoothStart() {
     bluetoothStartAdvertising(); 
 }
 
-boolean sendConfigCommand(int cmdType, int monitorId, const char* payload, int payloadSequence = 0) {
-    // Initially use CMD_TYPE_ADD instead of CMD_TYPE_ADD_INCOMPLETE
-    cmdType = cmdType == CMD_TYPE_ADD_INCOMPLETE ? CMD_TYPE_ADD : cmdType;
-
-    // Figure out payload
-    char* remainingPayload = NULL; 
-    char payloadPart[MAX_PAYLOAD_PART + 1];
-    if (payload && cmdType == CMD_TYPE_ADD) {
-        // Copy first 17 characters to payload
-        strncpy(payloadPart, payload, MAX_PAYLOAD_PART);
-        payloadPart[MAX_PAYLOAD_PART] = '\0';
-        
-         // If it does not fit to one payload, save the remaining part
-        int payloadLen = strlen(payload);
-        if (payloadLen > MAX_PAYLOAD_PART) {
-            int remainingPayloadLen = payloadLen - MAX_PAYLOAD_PART;
-            remainingPayload = (char*)malloc(remainingPayloadLen + 1);
-            strncpy(remainingPayload, payload + MAX_PAYLOAD_PART, remainingPayloadLen);
-            remainingPayload[remainingPayloadLen] = '\0';
-            cmdType = CMD_TYPE_ADD_INCOMPLETE;
-        }
-    } else {
-        payloadPart[0] = '\0';
-    }
-  
-    // Indicate the characteristic
-    byte bytes[20];
-    bytes[0] = (byte)cmdType;
-    bytes[1] = (byte)monitorId;
-    bytes[2] = (byte)payloadSequence;
-    memcpy(bytes + 3, payloadPart, strlen(payloadPart));
-    if (!monitorConfigCharacteristic.indicate(bytes,  3 + strlen(payloadPart))) {
-        return false;
-    }
-
-    // Handle remaining payload
-    if (remainingPayload) {
-        boolean r = sendConfigCommand(CMD_TYPE_ADD, monitorId, remainingPayload, payloadSequence + 1);
-        free(remainingPayload);
-        return r;
-    } else {
-        return true;
-    }
+bool monitorConfigSend(const uint8_t* bytes, uint8_t len) {
+    // Blocks only until this one indication is confirmed
+    return monitorConfigCharacteristic.indicate(bytes, len);
 }
 
-boolean addMonitor(const char* monitorName, const char* filterDef, float multiplier) {
-    if (nextMonitorId < MONITORS_MAX) {
-        if (!sendConfigCommand(CMD_TYPE_ADD, nextMonitorId, filterDef)) {
-            return false;
-        }
-        strncpy(monitorNames[nextMonitorId], monitorName, MONITOR_NAME_MAX);
+void monitorConfigLoad() {
+    // Names are known up front, so the layout does not wait for the app
+    nextMonitorId = 0;
+    monitorConfigurator.reset();
+    while (nextMonitorId < MONITOR_DEFINITION_COUNT && nextMonitorId < MONITORS_MAX) {
+        const MonitorDefinition* definition = &MONITOR_DEFINITIONS[nextMonitorId];
+        strncpy(monitorNames[nextMonitorId], definition->name, MONITOR_NAME_MAX);
         monitorNames[nextMonitorId][MONITOR_NAME_MAX] = '\0';
-        monitorMultipliers[nextMonitorId] = multiplier;
+        monitorDecimals[nextMonitorId] = definition->decimals;
         nextMonitorId++;
     }
-    return true;
+    monitorConfigSelectPages();
 }
 
-boolean configureMonitors() {
-    // Configure monitors
-    nextMonitorId = 0;
-    if (!addMonitor("Time", "channel(device(gps), elapsed_time)*10.0", 0.1) ||       
-        !addMonitor("Speed", "channel(device(gps), speed)*10.0", 0.1) ||
-        !addMonitor("Altitude", "channel(device(gps), altitude)", 1.0) ||
-        !addMonitor("Curr lap", "channel(device(lap), lap_number)", 1.0) ||
-        !addMonitor("Curr time", "channel(device(lap), lap_time)*10.0", 0.1) ||
-        !addMonitor("Prev lap", "channel(device(lap), previous_lap_number)", 1.0) ||
-        !addMonitor("Prev time", "channel(device(lap), previous_lap_time)*10.0", 0.1) ||
-        !addMonitor("Best lap", "channel(device(lap), best_lap_number)", 1.0) ||
-        !addMonitor("Best time", "channel(device(lap), best_lap_time)*10.0", 0.1)) {
-        return false;
+void monitorConfigSelectPages() {
+    // Only monitors of the current and adjacent pages are configured, so a page
+    // change usually finds its values already arriving
+    uint32_t wantedIds[(MONITORS_MAX + 31) / 32];
+    memset(wantedIds, 0, sizeof(wantedIds));
+    for (int offset = -1; offset <= 1; offset++) {
+        const PageDefinition* page = &PAGE_DEFINITIONS[(currentPage + offset + PAGE_COUNT) % PAGE_COUNT];
+        for (int i = 0; i < page->widgetCount; i++) {
+            int monitorId = page->widgets[i].monitorId;
+            wantedIds[monitorId / 32] |= 1UL << (monitorId % 32);
+        }
+    }
+    for (int i = 0; i < nextMonitorId; i++) {
+        if (wantedIds[i / 32] & (1UL << (i % 32))) {
+            monitorConfigurator.add(i, MONITOR_DEFINITIONS[i].equation);
+        } else if (monitorConfigurator.getState(i) != MONITOR_SLOT_REMOVED) {
+            // The app stops sending it, do not show a stale value once added again
+            monitorConfigurator.remove(i);
+            monitorValues[i] = INVALID_VALUE;
+        }
     }
-    return true;    
 }
 
 void monitorConfigWriteCallback(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
-    if (len >= 1) {
-        int result = data[0];
-        int monitorId = data[1];
-        switch (result) {
-            case CMD_RESULT_PAYLOAD_OUT_OF_SEQUENCE:
-                arcada.display->setTextColor(ARCADA_RED, ARCADA_BLACK);
-                arcada.display->println("");
-                arcada.display->print(monitorId);
-                arcada.display->println(" out-of-sequence");
-                break;
-            case CMD_RESULT_EQUATION_EXCEPTION:
-                // Notice exception details available in the data
-                arcada.display->setTextColor(ARCADA_RED, ARCADA_BLACK);
-                arcada.display->println("");
-                arcada.display->print(monitorId);
-                arcada.display->println(" exception");
-                break;
-            default:
-                break;
-        }
+    // Handled in the loop, the configurator is not touched from the Bluetooth task
+    if (len >= 2 && monitorConfigResultQueue) {
+        MonitorConfigResult result;
+        result.len = min(len, (uint16_t)sizeof(result.data));
+        memcpy(result.data, data, result.len);
+        xQueueSend(monitorConfigResultQueue, &result, 0);
+        displayWake();
     }
 }
 
+void monitorConfigCccdWriteCallback(uint16_t conn_hdl, BLECharacteristic* chr, uint16_t value) {
+    // Start configuring on the loop pass right after the app subscribes
+    if (value & BLE_GATT_HVX_INDICATION) {
+        monitorConfigRequested = true;
+        displayWake();
+    }
+}
 
 void monitorNotificationWriteCallback(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
-    int dataPos = 0;
-    while (dataPos + 5 <= len) {
-        int monitorId = (int)data[dataPos];
-        int32_t value = data[dataPos + 1] << 24 | data[dataPos + 2] << 16 | data[dataPos + 3] << 8 | data[dataPos + 4];
-        if (monitorId < nextMonitorId) {
+    bluetoothMarkValueReceived();
+    boolean isChanged = false;
+    size_t count = RaceChronoProtocol::monitor_value_count(len);
+    for (size_t i = 0; i < count; i++) {
+        int monitorId = RaceChronoProtocol::monitor_value_id(data, i);
+        int32_t value = RaceChronoProtocol::monitor_value_raw(data, i);
+        if (monitorId < nextMonitorId && monitorValues[monitorId] != value) {
             monitorValues[monitorId] = value;
+            displayMarkChanged(monitorId);
+            isChanged = true;
         }
-        dataPos += 5;
+    }
+    if (isChanged) {
+        displayWake();
     }
 }
 
 void setup() {
+    memoryStats.watchTask();
+    displayWakeSemaphore = xSemaphoreCreateBinary();
+    monitorConfigResultQueue = xQueueCreate(MONITOR_CONFIG_RESULT_QUEUE_LEN, sizeof(MonitorConfigResult));
     arcada.displayBegin();
     arcada.setBacklight(250);
     arcada.display->setCursor(0, 0);
     arcada.display->setTextWrap(false);
     arcada.display->setTextSize(2);
+    displayRenderer.begin(arcada.display, arcada.display->width(), 8 * DISPLAY_TEXT_SIZE);
+#ifdef SHOW_DISPLAY_STATS
+    displayMeasureGlyphs();
+    displayMeasureGauge();
+#endif
     bluetoothStart();
 }
 
+void displayWake() {
+    if (displayWakeSemaphore) {
+        xSemaphoreGive(displayWakeSemaphore);
+    }
+}
+
+void displayMarkChanged(int monitorId) {
+    // Called from the Bluetooth task, the render loop takes the changes atomically
+    taskENTER_CRITICAL();
+    displayChangedIds[monitorId / 32] |= 1UL << (monitorId % 32);
+    if (!displayHasPendingChange) {
+        displayHasPendingChange = true;
+        displayPendingSinceMs = millis();
+    }
+    taskEXIT_CRITICAL();
+}
+
+boolean displayTakeChanges(uint32_t* changedIds, uint32_t* pendingSinceMs) {
+    taskENTER_CRITICAL();
+    boolean hasChanges = displayHasPendingChange;
+    memcpy(changedIds, displayChangedIds, sizeof(displayChangedIds));
+    memset(displayChangedIds, 0, sizeof(displayChangedIds));
+    *pendingSinceMs = displayPendingSinceMs;
+    displayHasPendingChange = false;
+    taskEXIT_CRITICAL();
+    return hasChanges;
+}
+
+#ifdef SHOW_DISPLAY_STATS
+void displayMeasureGlyphs() {
+    // Draw time per glyph, large-digit font versus default font scaled to a similar size
+    static const int GLYPH_COUNT = 10;
+    BigTextField field;
+    field.begin(0, 0, 1);
+    uint32_t startUs = micros();
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        field.invalidate();
+        field.draw(&displayRenderer, arcada.display, "8", ARCADA_WHITE, ARCADA_BLACK);
+    }
+    displayRenderer.finish();
+    displayBigGlyphUs = (micros() - startUs) / GLYPH_COUNT;
+    startUs = micros();
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        arcada.display->drawChar(0, 0, '8', ARCADA_WHITE, ARCADA_BLACK, 5);
+    }
+    displayScaledGlyphUs = (micros() - startUs) / GLYPH_COUNT;
+    arcada.display->fillScreen(ARCADA_BLACK);
+}
+
+void displayMeasureGauge() {
+    // Needle frames per second while sweeping a full size gauge up and down
+    static const int FRAME_COUNT = 60;
+    Gauge gauge;
+    gauge.begin(0, 0, GAUGE_SIZE_MAX, 0, FRAME_COUNT / 2, ARCADA_WHITE, ARCADA_RED, ARCADA_BLACK);
+    gauge.draw(&displayRenderer, arcada.display, 0, true);
+    displayRenderer.finish();
+    uint32_t startUs = micros();
+    for (int i = 1; i <= FRAME_COUNT; i++) {
+        gauge.draw(&displayRenderer, arcada.display, i <= FRAME_COUNT / 2 ? i : FRAME_COUNT - i, true);
+        displayRenderer.finish();
+    }
+    uint32_t elapsedUs = max(micros() - startUs, (uint32_t)1);
+    displayGaugeFps = (uint64_t)FRAME_COUNT * 1000000 / elapsedUs;
+    arcada.display->fillScreen(ARCADA_BLACK);
+}
+#endif
+
+void displayLayout() {
+    // Static labels are drawn once, values go to fields placed after them
+    arcada.display->fillScreen(ARCADA_BLACK);
+    arcada.display->setTextColor(ARCADA_WHITE, ARCADA_BLACK);
+    arcada.display->setTextSize(DISPLAY_TEXT_SIZE);
+    int columns = arcada.display->width() / (6 * DISPLAY_TEXT_SIZE);
+    int rowHeight = 8 * DISPLAY_TEXT_SIZE;
+    int y = 0;
+    displayWidgetCount = 0;
+    const PageDefinition* page = &PAGE_DEFINITIONS[currentPage];
+    for (int i = 0; i < page->widgetCount && displayWidgetCount < DISPLAY_WIDGETS_MAX; i++) {
+        const WidgetDefinition* definition = &page->widgets[i];
+        if (definition->monitorId >= nextMonitorId) {
+            continue;
+        }
+        Widget* widget = &displayWidgets[displayWidgetCount];
+        const char* label = monitorNames[definition->monitorId];
+        if (definition->font == WIDGET_FONT_BIG || definition->type == WIDGET_GAUGE) {
+            // Small label above, large digits or gauge across the full width
+            arcada.display->setTextSize(1);
+            arcada.display->setCursor(0, y);
+            arcada.display->print(label);
+            arcada.display->setTextSize(DISPLAY_TEXT_SIZE);
+            widget->begin(definition, 0, y + 8, arcada.display->width(), DISPLAY_TEXT_SIZE);
+            y += 8 + widget->getHeight();
+        } else {
+            int labelLen = strlen(label) + 1;
+            arcada.display->setCursor(0, y);
+            arcada.display->print(label);
+            widget->begin(definition, labelLen * 6 * DISPLAY_TEXT_SIZE, y, max(0, columns - labelLen) * 6 * DISPLAY_TEXT_SIZE, DISPLAY_TEXT_SIZE);
+            y += widget->getHeight();
+        }
+        displayWidgetCount++;
+    }
+    arcada.display->setCursor(0, y);
+    arcada.display->print("Reconn ms ");
+    displayReconnectField.begin(10 * 6 * DISPLAY_TEXT_SIZE, y, max(0, columns - 10), DISPLAY_TEXT_SIZE);
+    arcada.display->setCursor(0, y + rowHeight);
+    arcada.display->print("Config ");
+    displayConfigField.begin(7 * 6 * DISPLAY_TEXT_SIZE, y + rowHeight, max(0, columns - 7), DISPLAY_TEXT_SIZE);
+#ifdef SHOW_DISPLAY_STATS
+    displayStatsField.begin(0, arcada.display->height() - 8, arcada.display->width() / 6, 1);
+#endif
+}
+
+/**
+ * @return false if the widget has no value to show yet
+ */
+boolean formatWidgetValue(char* text, size_t size, Widget* widget) {
+    int monitorId = widget->getDefinition()->monitorId;
+    MonitorSlotState state = monitorConfigurator.getState(monitorId);
+    if (state == MONITOR_SLOT_FAILED) {
+        snprintf(text, size, "Error %u", monitorConfigurator.getExceptionType(monitorId));
+        return false;
+    }
+    if (state != MONITOR_SLOT_ACTIVE) {
+        snprintf(text, size, "...");
+        return false;
+    }
+    if (monitorValues[monitorId] == INVALID_VALUE) {
+        snprintf(text, size, "N/A");
+        return false;
+    }
+    return widget->format(text, monitorValues[monitorId], monitorDecimals[monitorId]);
+}
+
+uint32_t displayDrawField(TextField* field, const char* text, uint16_t color) {
+    // Compose the changed span in RAM and push it with one bulk transfer
+    uint8_t first;
+    uint8_t last;
+    if (!field->getChangedSpan(text, &first, &last)) {
+        return 0;
+    }
+    uint16_t width = (last - first + 1) * field->getCellWidth();
+    uint16_t height = field->getCellHeight();
+    Adafruit_GFX* tile = displayRenderer.beginTile(field->getCellX(first), field->getY(), width, height, ARCADA_BLACK);
+    if (tile) {
+        field->drawSpan(tile, text, first, last, color, ARCADA_BLACK);
+        displayRenderer.endTile();
+        return 10 + 2 * (uint32_t)width * height;
+    }
+
+    // No tile buffers, draw glyph by glyph once pending tiles have landed
+    displayRenderer.finish();
+    return field->draw(arcada.display, text, color, ARCADA_BLACK) * field->getSpiBytesPerCell();
+}
+
 void updateDisplay() {
+    HotPathScope hotPath(HOT_PATH_DISPLAY_FRAME);
+    uint32_t startUs = micros();
+    uint32_t spiBytes = 0;
+    boolean isFullRedraw = !displayStarted;
     if (!displayStarted) {
         displayStarted = true;
-        arcada.display->fillScreen(ARCADA_BLACK);
-        arcada.display->setTextColor(ARCADA_WHITE, ARCADA_BLACK);
+        displayLayout();
     }
-    arcada.display->setCursor(0, 0);
-    for (int i = 0; i < nextMonitorId; i++) {
-        arcada.display->print(monitorNames[i]);
-        arcada.display->print(" ");
-        if (monitorValues[i] != INVALID_VALUE) {
-            arcada.display->print((float)monitorValues[i] * monitorMultipliers[i]);
+    uint32_t changedIds[(MONITORS_MAX + 31) / 32];
+    uint32_t pendingSinceMs;
+    boolean hasChanges = displayTakeChanges(changedIds, &pendingSinceMs);
+
+    // Redraw only the values that changed, and only the characters or bar pixels that changed
+    char text[FIXED_FORMAT_MAX > TEXT_FIELD_MAX + 1 ? FIXED_FORMAT_MAX : TEXT_FIELD_MAX + 1];
+    uint32_t formatUs = 0;
+    uint32_t formatCount = 0;
+    for (int i = 0; i < displayWidgetCount; i++) {
+        Widget* widget = &displayWidgets[i];
+        const WidgetDefinition* definition = widget->getDefinition();
+        int monitorId = definition->monitorId;
+        if (!isFullRedraw && !(changedIds[monitorId / 32] & (1UL << (monitorId % 32)))) {
+            continue;
+        }
+        uint32_t formatStartUs = micros();
+        boolean hasValue = formatWidgetValue(text, sizeof(text), widget);
+        formatUs += micros() - formatStartUs;
+        formatCount++;
+        if (widget->isGauge()) {
+            spiBytes += widget->drawGauge(&displayRenderer, arcada.display, monitorValues[monitorId], hasValue);
+        } else if (widget->isBig()) {
+            // The large-digit font has no letters, status is shown as a dash
+            spiBytes += widget->getBigField()->draw(&displayRenderer, arcada.display, hasValue ? text : "-", definition->color, ARCADA_BLACK);
+        } else if (widget->isText()) {
+            spiBytes += displayDrawField(widget->getField(), text, definition->color);
+        } else if (!hasValue) {
+            // Status text in place of a bar, the first bar draw clears it
+            widget->invalidate();
+            spiBytes += displayDrawField(widget->getField(), text, ARCADA_WHITE);
         } else {
-            arcada.display->print("N/A");      
+            // Bars draw straight to the display, let pending tiles land first
+            displayRenderer.finish();
+            spiBytes += widget->drawBar(arcada.display, monitorValues[monitorId], true, ARCADA_BLACK);
         }
-        arcada.display->println("         ");
     }
+    if (formatCount > 0) {
+        displayLastFormatNs = formatUs * 1000 / formatCount;
+    }
+    if (bluetoothLastReconnectMs != 0) {
+        snprintf(text, sizeof(text), "%lu", (unsigned long)bluetoothLastReconnectMs);
+    } else {
+        snprintf(text, sizeof(text), "-");
+    }
+    spiBytes += displayDrawField(&displayReconnectField, text, ARCADA_WHITE);
+    if (!monitorConfigStarted) {
+        snprintf(text, sizeof(text), "waiting");
+    } else {
+        snprintf(text, sizeof(text), "%d/%d%s P%d", monitorConfigurator.getActiveCount(), monitorConfigurator.getWantedCount(),
+            monitorConfigurator.isDone() ? "" : "...", currentPage + 1);
+    }
+    spiBytes += displayDrawField(&displayConfigField, text, ARCADA_WHITE);
+    displayRenderer.finish();
+    displayLastRefreshUs = micros() - startUs;
+    displayLastRefreshSpiBytes = spiBytes;
+    displayLastFrameMs = millis();
+
+    // Value-arrival-to-pixel latency of the oldest change in this frame
+    if (hasChanges) {
+        displayLastLatencyMs = displayLastFrameMs - pendingSinceMs;
+        displayMaxLatencyMs = max(displayMaxLatencyMs, displayLastLatencyMs);
+    }
+
+#ifdef SHOW_DISPLAY_STATS
+    snprintf(text, sizeof(text), "%luus %luB %lums %luns", (unsigned long)displayLastRefreshUs, (unsigned long)displayLastRefreshSpiBytes, (unsigned long)displayLastLatencyMs, (unsigned long)displayLastFormatNs);
+    displayDrawField(&displayStatsField, text, ARCADA_LIGHTGREY);
+    displayRenderer.finish();
+#endif
 }
 
 void handleConnected() {
@@ -220,52 +610,80 @@ void handleConnected() {
         monitorValues[i] = INVALID_VALUE;
     }
     monitorConfigStarted = false;
+    monitorConfigLoad();
+    xQueueReset(monitorConfigResultQueue);
     displayStarted = false;
-    displayUpdateCount = 0;
+    memset(displayChangedIds, 0, sizeof(displayChangedIds));
+    displayHasPendingChange = false;
+    displayMaxLatencyMs = 0;
 
-    // Print status
-    arcada.display->fillScreen(ARCADA_BLACK);
-    arcada.display->setCursor(0, 0);
-    arcada.display->setTextColor(ARCADA_BLUE, ARCADA_BLACK);
-    arcada.display->println("BLE connected!");
+}
 
+void handlePageButtons() {
+    // Next page on A or right, previous on B or left
+    uint32_t buttons = arcada.readButtons();
+    uint32_t pressed = buttons & ~lastButtons;
+    lastButtons = buttons;
+    int page = currentPage;
+    if (pressed & (ARCADA_BUTTONMASK_A | ARCADA_BUTTONMASK_RIGHT)) {
+        page = (page + 1) % PAGE_COUNT;
+    } else if (pressed & (ARCADA_BUTTONMASK_B | ARCADA_BUTTONMASK_LEFT)) {
+        page = (page + PAGE_COUNT - 1) % PAGE_COUNT;
+    }
+    if (page != currentPage) {
+        currentPage = page;
+        monitorConfigSelectPages();
+        displayStarted = false;
+    }
 }
 
 void handleDisconnected() {
+    monitorConfigRequested = false;
+
     // Print status
     arcada.display->fillScreen(ARCADA_BLACK);
     arcada.display->setCursor(0, 0);
     arcada.display->setTextColor(ARCADA_LIGHTGREY, ARCADA_BLACK);
     arcada.display->println("No BLE connection");
+#ifdef SHOW_DISPLAY_STATS
+    arcada.display->print("Big glyph us ");
+    arcada.display->println(displayBigGlyphUs);
+    arcada.display->print("Scaled us ");
+    arcada.display->println(displayScaledGlyphUs);
+    arcada.display->print("Gauge fps ");
+    arcada.display->println(displayGaugeFps);
+    memoryStats.print(*arcada.display);
+#endif
 }
 
 /**
- * @return true if everything is configured
+ * @return true if a chunk was sent and the next step should follow right away
  */
 boolean handleConfigure() {
-    // Start configuring when inidicate is enabled for the first time 
+    // Start configuring when inidicate is enabled for the first time
     if (!monitorConfigStarted) {
-        boolean isIndicating = monitorConfigCharacteristic.indicateEnabled();
-        if (isIndicating) {
-            // Configure in loop until success or disconnected
-            monitorConfigStarted = true;
-            while (1) {
-                arcada.display->setTextColor(ARCADA_LIGHTGREY, ARCADA_BLACK);
-                arcada.display->print("Configuring... ");    
-                if (!Bluefruit.connected() || configureMonitors()) {
-                    arcada.display->println("Done");    
-                    return true;
-                }
-                arcada.display->setTextColor(ARCADA_RED, ARCADA_BLACK);
-                arcada.display->println("Fail");    
-            }
+        if (!monitorConfigRequested && !monitorConfigCharacteristic.indicateEnabled()) {
+            return false;
+        }
+        monitorConfigStarted = true;
+    }
+
+    // Apply results from the app, a monitor that changed state is redrawn
+    MonitorConfigResult result;
+    while (xQueueReceive(monitorConfigResultQueue, &result, 0) == pdTRUE) {
+        monitorConfigurator.handleResult(result.data, result.len);
+        if (result.data[1] < nextMonitorId) {
+            displayMarkChanged(result.data[1]);
         }
-        return false;
     }
-    return true;
+
+    // One chunk per pass, failed monitors are retried on their own
+    return monitorConfigurator.step();
 }
-  
+
 void loop() {
+    memoryStats.loop();
+
     // Monitor change in Bluetooth connection status
     boolean isConnected = Bluefruit.connected();
     if (wasConnected != isConnected) {
@@ -279,17 +697,37 @@ void loop() {
         }
     }
 
-    if (isConnected) {
-        // Try configuring
-        if (handleConfigure()) {
-            // Update display, every 200 ms
-            displayUpdateCount++;
-            if (displayUpdateCount >= 8) {
-                updateDisplay();
-                displayUpdateCount = 0;   
-            }
+    if (!isConnected) {
+        // Back off advertising, any button press wakes it up again
+        bluetoothAdvertisingLoop();
+        if (arcada.readButtons()) {
+            bluetoothWake();
         }
+        xSemaphoreTake(displayWakeSemaphore, ms2tick(DISPLAY_DISCONNECTED_WAKE_MS));
+        return;
     }
 
-    delay(25);
+    // Configure step by step, the display keeps refreshing in between
+    handlePageButtons();
+    boolean isConfigSent = handleConfigure();
+
+    // Stay within the frame rate cap, then draw what changed. While
+    // configuring, skip the frame instead of holding back the next chunk.
+    uint32_t sinceFrameMs = millis() - displayLastFrameMs;
+    if (sinceFrameMs >= DISPLAY_FRAME_MS) {
+        updateDisplay();
+    } else if (!isConfigSent) {
+        delay(DISPLAY_FRAME_MS - sinceFrameMs);
+        updateDisplay();
+    }
+
+    // Sleep until a value changes, the connection changes, or the idle timeout.
+    // Awaited results and retries are polled more often while configuring.
+    uint32_t wakeMs = DISPLAY_IDLE_WAKE_MS;
+    if (isConfigSent) {
+        wakeMs = 0;
+    } else if (monitorConfigStarted && !monitorConfigurator.isDone()) {
+        wakeMs = DISPLAY_CONFIGURING_WAKE_MS;
+    }
+    xSemaphoreTake(displayWakeSemaphore, ms2tick(wakeMs));
 }
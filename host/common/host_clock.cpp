@@ -0,0 +1,171 @@
+// Real and virtual time for the host stand-ins
+
+// Imports
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include "host_clock.hpp"
+
+namespace
+{
+    struct Timer
+    {
+        int64_t due_us;
+        int64_t period_us;
+        bool repeat;
+        uint64_t sequence;
+        host_clock::timer_callback_t callback;
+    };
+
+    std::chrono::steady_clock::time_point start_time =
+        std::chrono::steady_clock::now();
+    std::atomic<bool> virtual_time(false);
+    std::atomic<int64_t> virtual_now_us(0);
+
+    // Timers are few, a scan for the earliest is cheaper than keeping order
+    std::mutex timer_mutex;
+    std::map<const void*, Timer> timers;
+    uint64_t next_sequence = 0;
+
+    int64_t real_now_us()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    // Take the earliest timer due by time_us, rescheduling or removing it,
+    // ties go to the timer armed first
+    bool take_due(int64_t time_us, int64_t& due_us,
+        host_clock::timer_callback_t& callback)
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex);
+        auto earliest = timers.end();
+        for (auto it = timers.begin(); it != timers.end(); ++it)
+        {
+            if (it->second.due_us <= time_us && (earliest == timers.end() ||
+                it->second.due_us < earliest->second.due_us ||
+                (it->second.due_us == earliest->second.due_us &&
+                it->second.sequence < earliest->second.sequence)))
+            {
+                earliest = it;
+            }
+        }
+        if (earliest == timers.end()) { return false; }
+        due_us = earliest->second.due_us;
+        callback = earliest->second.callback;
+        if (earliest->second.repeat)
+        {
+            earliest->second.due_us += earliest->second.period_us;
+        }
+        else
+        {
+            timers.erase(earliest);
+        }
+        return true;
+    }
+}
+
+void host_clock::use_virtual_time(int64_t start_us)
+{
+    virtual_now_us = start_us;
+    virtual_time = true;
+}
+
+void host_clock::use_real_time()
+{
+    virtual_time = false;
+}
+
+bool host_clock::is_virtual()
+{
+    return virtual_time;
+}
+
+int64_t host_clock::now_us()
+{
+    return virtual_time ? virtual_now_us.load() : real_now_us();
+}
+
+void host_clock::advance_us(int64_t us)
+{
+    advance_to_us(now_us() + us);
+}
+
+void host_clock::advance_to_us(int64_t time_us)
+{
+    assert(virtual_time);
+    int64_t due_us;
+    timer_callback_t callback;
+    while (take_due(time_us, due_us, callback))
+    {
+        if (due_us > virtual_now_us) { virtual_now_us = due_us; }
+        callback();
+    }
+    if (time_us > virtual_now_us) { virtual_now_us = time_us; }
+}
+
+void host_clock::sleep_us(int64_t us)
+{
+    if (virtual_time)
+    {
+        advance_us(us);
+    }
+    else
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+        run_due();
+    }
+    std::this_thread::yield();
+}
+
+void host_clock::arm(const void* owner, int64_t period_us, bool repeat,
+    timer_callback_t callback)
+{
+    // A repeating zero period would fire forever without time moving, a
+    // one-shot at zero fires on the next advance or run_due()
+    if (period_us < 1) { period_us = repeat ? 1 : 0; }
+    int64_t due_us = now_us() + period_us;
+    std::lock_guard<std::mutex> lock(timer_mutex);
+    timers[owner] = Timer{due_us, period_us, repeat, next_sequence++,
+        std::move(callback)};
+}
+
+void host_clock::disarm(const void* owner)
+{
+    std::lock_guard<std::mutex> lock(timer_mutex);
+    timers.erase(owner);
+}
+
+bool host_clock::is_armed(const void* owner)
+{
+    std::lock_guard<std::mutex> lock(timer_mutex);
+    return timers.count(owner) > 0;
+}
+
+size_t host_clock::run_due()
+{
+    int64_t time_us = now_us();
+    size_t fired = 0;
+    int64_t due_us;
+    timer_callback_t callback;
+    while (take_due(time_us, due_us, callback))
+    {
+        callback();
+        fired++;
+    }
+    return fired;
+}
+
+int64_t host_clock::next_due_us()
+{
+    std::lock_guard<std::mutex> lock(timer_mutex);
+    int64_t next = -1;
+    for (auto& it : timers)
+    {
+        if (next < 0 || it.second.due_us < next) { next = it.second.due_us; }
+    }
+    return next;
+}
@@ -0,0 +1,54 @@
+// Clock behind millis(), micros(), esp_timer_get_time(), delay() and Ticker
+// in both host stand-ins. Runs on the host's monotonic clock by default;
+// tests and simulations switch it to virtual time and move it explicitly, so
+// a long session replays in a moment with exact timing
+
+#pragma once
+
+// Imports
+#include <functional>
+#include <stdint.h>
+
+namespace host_clock
+{
+    typedef std::function<void()> timer_callback_t;
+
+    // Switch to virtual time starting at start_us, from then on time only
+    // moves through advance_us(), advance_to_us() and delay()
+    void use_virtual_time(int64_t start_us=0);
+
+    // Back to the host's monotonic clock, timers stay armed
+    void use_real_time();
+
+    // True while time is virtual
+    bool is_virtual();
+
+    // Microseconds since the start of the clock
+    int64_t now_us();
+
+    // Move virtual time forward, firing every timer that falls due on the
+    // way at its own time and in order
+    void advance_us(int64_t us);
+    void advance_to_us(int64_t time_us);
+    inline void advance_ms(uint32_t ms) { advance_us((int64_t) ms * 1000); }
+
+    // delay(), advances virtual time or sleeps on the real clock and then
+    // fires the due timers. Always yields, so spin waits on other threads
+    // make progress
+    void sleep_us(int64_t us);
+
+    // Arm the timer of an owner (a Ticker) to fire after period_us, again
+    // every period_us if repeat. Re-arming replaces the previous timer.
+    // Timers only fire from advance_us(), sleep_us() and run_due(), on the
+    // calling thread
+    void arm(const void* owner, int64_t period_us, bool repeat,
+        timer_callback_t callback);
+    void disarm(const void* owner);
+    bool is_armed(const void* owner);
+
+    // Fire the timers due now, returns how many fired
+    size_t run_due();
+
+    // Time the next timer falls due, -1 if none is armed
+    int64_t next_due_us();
+}
@@ -0,0 +1,73 @@
+// Host stand-in for the parts of the ESP32 Arduino core the library uses
+
+#pragma once
+
+// Imports
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+
+using std::max;
+using std::min;
+
+typedef bool boolean;
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_TIMEOUT 0x107
+#define IRAM_ATTR
+
+// Time from host_clock.hpp, real or virtual, delay() also fires due Tickers
+uint32_t millis();
+uint32_t micros();
+int64_t esp_timer_get_time();
+void delay(uint32_t ms);
+
+// Spinlock stand-in, a mutex is close enough on the host
+struct portMUX_TYPE
+{
+    std::mutex mutex;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+inline void portENTER_CRITICAL(portMUX_TYPE* mux) { mux->mutex.lock(); }
+inline void portEXIT_CRITICAL(portMUX_TYPE* mux) { mux->mutex.unlock(); }
+
+// Minimal Print, output goes to stdout
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t len);
+    size_t print(const char* text);
+    size_t print(int value);
+    size_t print(unsigned value);
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(long long value);
+    size_t print(unsigned long long value);
+    size_t print(double value, int digits=2);
+    size_t println(const char* text="");
+    template <typename T> size_t println(T value)
+    {
+        return print(value) + println();
+    }
+    size_t printf(const char* format, ...);
+};
+
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* data, size_t len);
+};
+
+extern HardwareSerial Serial;
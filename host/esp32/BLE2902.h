@@ -0,0 +1,18 @@
+// Host stand-in for the client characteristic configuration descriptor
+
+#pragma once
+
+#include <BLEDevice.h>
+
+class BLE2902 : public BLEDescriptor
+{
+public:
+    bool getIndications() { return indications; }
+    bool getNotifications() { return notifications; }
+    void setIndications(bool on) { indications = on; }
+    void setNotifications(bool on) { notifications = on; }
+
+private:
+    bool indications = false;
+    bool notifications = false;
+};
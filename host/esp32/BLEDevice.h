@@ -0,0 +1,206 @@
+// Host stand-in for the ESP32 BLE library. Characteristics keep their values
+// in memory and the central's side is driven through host_ble.hpp
+
+#pragma once
+
+// Imports
+#include <string>
+#include <vector>
+#include <Arduino.h>
+
+typedef uint8_t esp_bd_addr_t[6];
+typedef uint8_t esp_gatt_if_t;
+
+enum esp_ble_addr_type_t
+{
+    BLE_ADDR_TYPE_PUBLIC = 0,
+    BLE_ADDR_TYPE_RANDOM = 1
+};
+
+enum
+{
+    ADV_TYPE_IND = 0,
+    ADV_TYPE_DIRECT_IND_HIGH = 1
+};
+
+enum { ADV_CHNL_ALL = 7 };
+enum { ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY = 0 };
+
+struct esp_ble_adv_params_t
+{
+    uint16_t adv_int_min;
+    uint16_t adv_int_max;
+    int adv_type;
+    int own_addr_type;
+    esp_bd_addr_t peer_addr;
+    esp_ble_addr_type_t peer_addr_type;
+    int channel_map;
+    int adv_filter_policy;
+};
+
+union esp_ble_gatts_cb_param_t
+{
+    struct
+    {
+        uint16_t conn_id;
+        esp_bd_addr_t remote_bda;
+        esp_ble_addr_type_t ble_addr_type;
+    } connect;
+};
+
+esp_err_t esp_ble_gap_start_advertising(esp_ble_adv_params_t* params);
+esp_err_t esp_ble_gap_stop_advertising();
+esp_err_t esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if, uint16_t conn_id,
+    uint16_t handle, uint16_t len, uint8_t* data, bool need_confirm);
+
+class BLEUUID
+{
+public:
+    BLEUUID() : uuid(0) {}
+    BLEUUID(uint16_t uuid) : uuid(uuid) {}
+    bool equals(const BLEUUID& other) const { return uuid == other.uuid; }
+    uint16_t get_uuid16() const { return uuid; }
+
+private:
+    uint16_t uuid;
+};
+
+class BLECharacteristic;
+class BLEDescriptor;
+
+class BLECharacteristicCallbacks
+{
+public:
+    virtual ~BLECharacteristicCallbacks() {}
+    virtual void onWrite(BLECharacteristic* ch) { (void) ch; }
+};
+
+class BLEDescriptorCallbacks
+{
+public:
+    virtual ~BLEDescriptorCallbacks() {}
+    virtual void onWrite(BLEDescriptor* desc) { (void) desc; }
+};
+
+class BLEDescriptor
+{
+public:
+    virtual ~BLEDescriptor() {}
+    void setCallbacks(BLEDescriptorCallbacks* callbacks) { this->callbacks = callbacks; }
+    BLEDescriptorCallbacks* getCallbacks() { return callbacks; }
+
+private:
+    BLEDescriptorCallbacks* callbacks = nullptr;
+};
+
+class BLECharacteristic
+{
+public:
+    static const uint32_t PROPERTY_READ = 1 << 0;
+    static const uint32_t PROPERTY_WRITE = 1 << 1;
+    static const uint32_t PROPERTY_NOTIFY = 1 << 2;
+    static const uint32_t PROPERTY_BROADCAST = 1 << 3;
+    static const uint32_t PROPERTY_INDICATE = 1 << 4;
+    static const uint32_t PROPERTY_WRITE_NR = 1 << 5;
+
+    BLECharacteristic(BLEUUID uuid, uint32_t properties);
+
+    void setCallbacks(BLECharacteristicCallbacks* callbacks) { this->callbacks = callbacks; }
+    BLECharacteristicCallbacks* getCallbacks() { return callbacks; }
+    void addDescriptor(BLEDescriptor* descriptor) { descriptors.push_back(descriptor); }
+    std::vector<BLEDescriptor*>& getDescriptors() { return descriptors; }
+    void setValue(uint8_t* data, size_t len) { value.assign((const char*) data, len); }
+    uint8_t* getData() { return (uint8_t*) value.data(); }
+    size_t getLength() { return value.size(); }
+    BLEUUID getUUID() { return uuid; }
+    uint16_t getHandle() { return handle; }
+
+    // Send the current value to the host_ble indication listener
+    void indicate();
+    void notify(bool is_notification=true);
+
+private:
+    BLEUUID uuid;
+    uint32_t properties;
+    uint16_t handle;
+    std::string value;
+    BLECharacteristicCallbacks* callbacks = nullptr;
+    std::vector<BLEDescriptor*> descriptors;
+};
+
+class BLEService
+{
+public:
+    BLEService(BLEUUID uuid) : uuid(uuid) {}
+    BLECharacteristic* createCharacteristic(BLEUUID uuid, uint32_t properties);
+    BLECharacteristic* getCharacteristic(BLEUUID uuid);
+    BLEUUID getUUID() { return uuid; }
+    void start() {}
+
+private:
+    BLEUUID uuid;
+    std::vector<BLECharacteristic*> characteristics;
+};
+
+class BLEServer;
+
+class BLEServerCallbacks
+{
+public:
+    virtual ~BLEServerCallbacks() {}
+    virtual void onConnect(BLEServer* server) { (void) server; }
+    virtual void onConnect(BLEServer* server, esp_ble_gatts_cb_param_t* param)
+    {
+        (void) param;
+        onConnect(server);
+    }
+    virtual void onDisconnect(BLEServer* server) { (void) server; }
+};
+
+class BLEAdvertising
+{
+public:
+    void addServiceUUID(BLEUUID uuid) { (void) uuid; }
+    void setMinInterval(uint16_t interval) { min_interval = interval; }
+    void setMaxInterval(uint16_t interval) { max_interval = interval; }
+    void start() { advertising = true; }
+    void stop() { advertising = false; }
+    bool isAdvertising() { return advertising; }
+    uint16_t getMinInterval() { return min_interval; }
+    uint16_t getMaxInterval() { return max_interval; }
+
+private:
+    uint16_t min_interval = 0;
+    uint16_t max_interval = 0;
+    bool advertising = false;
+};
+
+class BLEServer
+{
+public:
+    BLEService* createService(BLEUUID uuid);
+    BLEService* getServiceByUUID(BLEUUID uuid);
+    void removeService(BLEService* service);
+    BLEAdvertising* getAdvertising() { return &advertising; }
+    void setCallbacks(BLEServerCallbacks* callbacks) { this->callbacks = callbacks; }
+    BLEServerCallbacks* getCallbacks() { return callbacks; }
+    uint32_t getConnectedCount() { return connected; }
+    uint16_t getConnId() { return 0; }
+    esp_gatt_if_t getGattsIf() { return 0; }
+
+    // Set by host_ble::connect() and host_ble::disconnect()
+    void setConnectedCount(uint32_t count) { connected = count; }
+
+private:
+    std::vector<BLEService*> services;
+    BLEAdvertising advertising;
+    BLEServerCallbacks* callbacks = nullptr;
+    uint32_t connected = 0;
+};
+
+class BLEDevice
+{
+public:
+    static void init(std::string name) { (void) name; }
+    static BLEServer* createServer() { return new BLEServer(); }
+};
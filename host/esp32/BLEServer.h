@@ -0,0 +1,5 @@
+// Host stand-in, everything lives in BLEDevice.h
+
+#pragma once
+
+#include <BLEDevice.h>
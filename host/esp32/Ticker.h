@@ -0,0 +1,26 @@
+// Host stand-in for the ESP32 Ticker, timers run on host_clock and fire when
+// it is advanced or from delay()
+
+#pragma once
+
+#include <Arduino.h>
+#include <host_clock.hpp>
+
+class Ticker
+{
+public:
+    ~Ticker() { detach(); }
+
+    template <typename T> void attach_ms(uint32_t ms, void (*callback)(T), T arg)
+    {
+        host_clock::arm(this, (int64_t) ms * 1000, true,
+            [callback, arg]() { callback(arg); });
+    }
+    template <typename T> void once_ms(uint32_t ms, void (*callback)(T), T arg)
+    {
+        host_clock::arm(this, (int64_t) ms * 1000, false,
+            [callback, arg]() { callback(arg); });
+    }
+    void detach() { host_clock::disarm(this); }
+    bool active() { return host_clock::is_armed(this); }
+};
@@ -0,0 +1,61 @@
+// Host stand-in for the ESP-IDF RMT driver. Frames go out instantly: the
+// end of transmit callback runs from rmt_write_items() and the items are kept
+// for host_rmt::get_items()
+
+#pragma once
+
+// Imports
+#include <vector>
+#include <Arduino.h>
+
+typedef int gpio_num_t;
+
+enum rmt_channel_t
+{
+    RMT_CHANNEL_0,
+    RMT_CHANNEL_1,
+    RMT_CHANNEL_2,
+    RMT_CHANNEL_3,
+    RMT_CHANNEL_4,
+    RMT_CHANNEL_5,
+    RMT_CHANNEL_6,
+    RMT_CHANNEL_7,
+    RMT_CHANNEL_MAX
+};
+
+struct rmt_item32_t
+{
+    uint32_t duration0 : 15;
+    uint32_t level0 : 1;
+    uint32_t duration1 : 15;
+    uint32_t level1 : 1;
+};
+
+struct rmt_config_t
+{
+    rmt_channel_t channel;
+    gpio_num_t gpio_num;
+    uint8_t clk_div;
+};
+
+#define RMT_DEFAULT_CONFIG_TX(gpio, channel_id) { channel_id, gpio, 80 }
+
+typedef void (*rmt_tx_end_fn_t)(rmt_channel_t channel, void* arg);
+
+esp_err_t rmt_config(const rmt_config_t* config);
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size,
+    int intr_alloc_flags);
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel);
+void rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void* arg);
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t* items,
+    int item_num, bool wait_tx_done);
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, uint32_t wait_time);
+
+namespace host_rmt
+{
+    // Items of the last frame written to a channel
+    const std::vector<rmt_item32_t>& get_items(rmt_channel_t channel);
+
+    // Number of frames written to a channel since start
+    uint32_t get_frame_count(rmt_channel_t channel);
+}
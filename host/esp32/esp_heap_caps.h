@@ -0,0 +1,21 @@
+// Host stand-in for the ESP-IDF heap capabilities API. The host has no fixed
+// heap, so the figures are whatever host_heap::set() last gave
+
+#pragma once
+
+// Imports
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+
+namespace host_heap
+{
+    // Set the figures the heap_caps functions report
+    void set(size_t free_bytes, size_t min_free_bytes, size_t largest_free_block);
+}
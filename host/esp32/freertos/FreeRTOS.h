@@ -0,0 +1,13 @@
+// Host stand-in for the FreeRTOS types the library uses
+
+#pragma once
+
+// Imports
+#include <stdint.h>
+
+typedef uint32_t UBaseType_t;
+typedef int32_t BaseType_t;
+typedef uint32_t TickType_t;
+typedef struct HostTask* TaskHandle_t;
+
+#define portMAX_DELAY 0xFFFFFFFFu
@@ -0,0 +1,19 @@
+// Host stand-in for the FreeRTOS task API. Every host thread is a task of its
+// own, named "loopTask" for the main thread like the Arduino loop
+
+#pragma once
+
+// Imports
+#include <freertos/FreeRTOS.h>
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+char* pcTaskGetName(TaskHandle_t task);
+
+// Bytes of stack never used, as ESP-IDF counts them
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+namespace host_task
+{
+    // Set the high-water mark uxTaskGetStackHighWaterMark() reports
+    void set_stack_high_water(TaskHandle_t task, UBaseType_t bytes);
+}
@@ -0,0 +1,39 @@
+// Drives the host BLE stand-in from the central's side, for tests, replays
+// and benchmarks of code written against the ESP32 BLE library
+
+#pragma once
+
+// Imports
+#include <BLEDevice.h>
+
+namespace host_ble
+{
+    // Called for every indication or notification the peripheral sends, with
+    // the characteristic's 16-bit UUID
+    typedef void (*indication_listener_t)(void* arg, uint16_t uuid,
+        const uint8_t* data, size_t len);
+
+    // Receive everything the peripheral sends, nullptr to stop
+    void set_indication_listener(indication_listener_t listener, void* arg);
+
+    // Find a characteristic by its 16-bit UUID in any service of the server
+    BLECharacteristic* find_characteristic(BLEServer* server, uint16_t uuid);
+
+    // Connect a central and run the server's connect callback, from a
+    // public address unless one is given
+    void connect(BLEServer* server);
+    void connect(BLEServer* server, const esp_bd_addr_t addr,
+        esp_ble_addr_type_t addr_type);
+
+    // Disconnect the central and run the server's disconnect callback
+    void disconnect(BLEServer* server);
+
+    // Write a value as the central and run the characteristic's callback
+    void write(BLECharacteristic* ch, const uint8_t* data, size_t len);
+
+    // Enable indications on the characteristic's CCCD and run its callback
+    void subscribe(BLECharacteristic* ch);
+
+    // True while directed advertising runs, started through the GAP API
+    bool is_advertising_directed();
+}
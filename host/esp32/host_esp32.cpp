@@ -0,0 +1,402 @@
+// Host stand-in implementations of the ESP32 Arduino core and BLE library
+
+// Imports
+#include <stdarg.h>
+#include <thread>
+#include <Arduino.h>
+#include <BLE2902.h>
+#include <BLEDevice.h>
+#include <driver/rmt.h>
+#include <esp_heap_caps.h>
+#include <freertos/task.h>
+#include <host_clock.hpp>
+#include "host_ble.hpp"
+
+HardwareSerial Serial;
+
+namespace
+{
+    host_ble::indication_listener_t indication_listener = nullptr;
+    void* indication_arg = nullptr;
+    uint16_t next_handle = 1;
+    std::vector<BLECharacteristic*> all_characteristics;
+    bool advertising_directed = false;
+
+    // Pass a sent value on to the listener
+    void send_to_listener(uint16_t uuid, const uint8_t* data, size_t len)
+    {
+        if (indication_listener != nullptr)
+        {
+            indication_listener(indication_arg, uuid, data, len);
+        }
+    }
+}
+
+// Microseconds since start
+int64_t esp_timer_get_time()
+{
+    return host_clock::now_us();
+}
+
+uint32_t millis()
+{
+    return (uint32_t) (esp_timer_get_time() / 1000);
+}
+
+uint32_t micros()
+{
+    return (uint32_t) esp_timer_get_time();
+}
+
+void delay(uint32_t ms)
+{
+    host_clock::sleep_us((int64_t) ms * 1000);
+}
+
+// Print helpers, all formatting goes through printf
+size_t Print::write(const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) { write(data[i]); }
+    return len;
+}
+
+size_t Print::print(const char* text)
+{
+    return write((const uint8_t*) text, strlen(text));
+}
+
+size_t Print::print(int value) { return printf("%d", value); }
+size_t Print::print(unsigned value) { return printf("%u", value); }
+size_t Print::print(long value) { return printf("%ld", value); }
+size_t Print::print(unsigned long value) { return printf("%lu", value); }
+size_t Print::print(long long value) { return printf("%lld", value); }
+size_t Print::print(unsigned long long value) { return printf("%llu", value); }
+
+size_t Print::print(double value, int digits)
+{
+    return printf("%.*f", digits, value);
+}
+
+size_t Print::println(const char* text)
+{
+    return print(text) + print("\r\n");
+}
+
+size_t Print::printf(const char* format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len < 0) { return 0; }
+    return write((const uint8_t*) buffer,
+        std::min((size_t) len, sizeof(buffer) - 1));
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t len)
+{
+    return fwrite(data, 1, len, stdout);
+}
+
+// GAP and GATT calls, advertising is not modelled
+esp_err_t esp_ble_gap_start_advertising(esp_ble_adv_params_t* params)
+{
+    advertising_directed = params->adv_type == ADV_TYPE_DIRECT_IND_HIGH;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_stop_advertising()
+{
+    advertising_directed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if,
+    uint16_t conn_id, uint16_t handle, uint16_t len, uint8_t* data,
+    bool need_confirm)
+{
+    (void) gatts_if;
+    (void) conn_id;
+    (void) need_confirm;
+    for (BLECharacteristic* ch : all_characteristics)
+    {
+        if (ch->getHandle() == handle)
+        {
+            send_to_listener(ch->getUUID().get_uuid16(), data, len);
+            return ESP_OK;
+        }
+    }
+    return ESP_FAIL;
+}
+
+// Characteristics get unique handles so raw GATT calls can find them
+BLECharacteristic::BLECharacteristic(BLEUUID uuid, uint32_t properties)
+    : uuid(uuid)
+    , properties(properties)
+    , handle(next_handle++)
+{
+    all_characteristics.push_back(this);
+}
+
+void BLECharacteristic::indicate()
+{
+    send_to_listener(uuid.get_uuid16(), getData(), getLength());
+}
+
+void BLECharacteristic::notify(bool is_notification)
+{
+    (void) is_notification;
+    send_to_listener(uuid.get_uuid16(), getData(), getLength());
+}
+
+BLECharacteristic* BLEService::createCharacteristic(BLEUUID uuid,
+    uint32_t properties)
+{
+    BLECharacteristic* ch = new BLECharacteristic(uuid, properties);
+    characteristics.push_back(ch);
+    return ch;
+}
+
+BLECharacteristic* BLEService::getCharacteristic(BLEUUID uuid)
+{
+    for (BLECharacteristic* ch : characteristics)
+    {
+        if (ch->getUUID().equals(uuid)) { return ch; }
+    }
+    return nullptr;
+}
+
+BLEService* BLEServer::createService(BLEUUID uuid)
+{
+    BLEService* service = new BLEService(uuid);
+    services.push_back(service);
+    return service;
+}
+
+BLEService* BLEServer::getServiceByUUID(BLEUUID uuid)
+{
+    for (BLEService* service : services)
+    {
+        if (service->getUUID().equals(uuid)) { return service; }
+    }
+    return nullptr;
+}
+
+void BLEServer::removeService(BLEService* service)
+{
+    services.erase(std::remove(services.begin(), services.end(), service),
+        services.end());
+}
+
+void host_ble::set_indication_listener(indication_listener_t listener,
+    void* arg)
+{
+    indication_listener = listener;
+    indication_arg = arg;
+}
+
+BLECharacteristic* host_ble::find_characteristic(BLEServer* server,
+    uint16_t uuid)
+{
+    // Every DIY API lives in the 0x1FF8 service
+    BLEService* service = server->getServiceByUUID(BLEUUID((uint16_t) 0x1FF8));
+    return service != nullptr ? service->getCharacteristic(BLEUUID(uuid)) :
+        nullptr;
+}
+
+void host_ble::connect(BLEServer* server)
+{
+    const esp_bd_addr_t addr = { 0, 0, 0, 0, 0, 1 };
+    connect(server, addr, BLE_ADDR_TYPE_PUBLIC);
+}
+
+void host_ble::connect(BLEServer* server, const esp_bd_addr_t addr,
+    esp_ble_addr_type_t addr_type)
+{
+    esp_ble_gatts_cb_param_t param = {};
+    memcpy(param.connect.remote_bda, addr, sizeof(esp_bd_addr_t));
+    param.connect.ble_addr_type = addr_type;
+    server->setConnectedCount(1);
+    if (server->getCallbacks() != nullptr)
+    {
+        server->getCallbacks()->onConnect(server, &param);
+    }
+}
+
+void host_ble::disconnect(BLEServer* server)
+{
+    server->setConnectedCount(0);
+    if (server->getCallbacks() != nullptr)
+    {
+        server->getCallbacks()->onDisconnect(server);
+    }
+}
+
+void host_ble::write(BLECharacteristic* ch, const uint8_t* data, size_t len)
+{
+    ch->setValue((uint8_t*) data, len);
+    if (ch->getCallbacks() != nullptr)
+    {
+        ch->getCallbacks()->onWrite(ch);
+    }
+}
+
+void host_ble::subscribe(BLECharacteristic* ch)
+{
+    for (BLEDescriptor* desc : ch->getDescriptors())
+    {
+        // Only CCCDs are added by the library
+        static_cast<BLE2902*>(desc)->setIndications(true);
+        if (desc->getCallbacks() != nullptr)
+        {
+            desc->getCallbacks()->onWrite(desc);
+        }
+    }
+}
+
+bool host_ble::is_advertising_directed()
+{
+    return advertising_directed;
+}
+
+// RMT, transmission takes no time
+namespace
+{
+    rmt_tx_end_fn_t rmt_tx_end = nullptr;
+    void* rmt_tx_end_arg = nullptr;
+    std::vector<rmt_item32_t> rmt_items[RMT_CHANNEL_MAX];
+    uint32_t rmt_frames[RMT_CHANNEL_MAX];
+}
+
+esp_err_t rmt_config(const rmt_config_t* config)
+{
+    return config->channel < RMT_CHANNEL_MAX ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size,
+    int intr_alloc_flags)
+{
+    (void) rx_buf_size;
+    (void) intr_alloc_flags;
+    rmt_items[channel].clear();
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel)
+{
+    (void) channel;
+    return ESP_OK;
+}
+
+void rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void* arg)
+{
+    rmt_tx_end = function;
+    rmt_tx_end_arg = arg;
+}
+
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t* items,
+    int item_num, bool wait_tx_done)
+{
+    (void) wait_tx_done;
+    rmt_items[channel].assign(items, items + item_num);
+    rmt_frames[channel]++;
+    if (rmt_tx_end != nullptr) { rmt_tx_end(channel, rmt_tx_end_arg); }
+    return ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, uint32_t wait_time)
+{
+    (void) channel;
+    (void) wait_time;
+    return ESP_OK;
+}
+
+const std::vector<rmt_item32_t>& host_rmt::get_items(rmt_channel_t channel)
+{
+    return rmt_items[channel];
+}
+
+uint32_t host_rmt::get_frame_count(rmt_channel_t channel)
+{
+    return rmt_frames[channel];
+}
+
+// Heap figures set by host_heap::set()
+namespace
+{
+    size_t heap_free = 0;
+    size_t heap_min_free = 0;
+    size_t heap_largest_free_block = 0;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void) caps;
+    return heap_free;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    (void) caps;
+    return heap_min_free;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    (void) caps;
+    return heap_largest_free_block;
+}
+
+void host_heap::set(size_t free_bytes, size_t min_free_bytes,
+    size_t largest_free_block)
+{
+    heap_free = free_bytes;
+    heap_min_free = min_free_bytes;
+    heap_largest_free_block = largest_free_block;
+}
+
+// A task per host thread, created on first use
+struct HostTask
+{
+    char name[16];
+    UBaseType_t stack_high_water;
+};
+
+namespace
+{
+    // Static initialization runs on the main thread
+    std::thread::id main_thread = std::this_thread::get_id();
+    thread_local HostTask* current_task = nullptr;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    if (current_task == nullptr)
+    {
+        current_task = new HostTask();
+        snprintf(current_task->name, sizeof(current_task->name), "%s",
+            std::this_thread::get_id() == main_thread ? "loopTask" : "hostTask");
+    }
+    return current_task;
+}
+
+char* pcTaskGetName(TaskHandle_t task)
+{
+    return task->name;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    return task->stack_high_water;
+}
+
+void host_task::set_stack_high_water(TaskHandle_t task, UBaseType_t bytes)
+{
+    task->stack_high_water = bytes;
+}
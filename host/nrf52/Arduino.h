@@ -0,0 +1,94 @@
+// Host stand-in for the parts of the Adafruit nRF52 Arduino core the example
+// logic uses
+
+#pragma once
+
+// Imports
+#include <algorithm>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utility/debug.h"
+
+using std::max;
+using std::min;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+
+// Time from host_clock.hpp, real or virtual
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+// Minimal Print, output goes to stdout
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t len);
+    virtual void flush() {}
+    size_t print(const char* text);
+    size_t print(int value);
+    size_t print(unsigned value);
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(double value, int digits=2);
+    size_t println(const char* text="");
+    template <typename T> size_t println(T value)
+    {
+        return print(value) + println();
+    }
+    size_t printf(const char* format, ...);
+};
+
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long) {}
+    operator bool() { return true; }
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* data, size_t len);
+};
+
+extern HardwareSerial Serial;
+
+// FreeRTOS tasks and notifications, tasks run as host threads
+typedef struct HostTask* TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xFFFFFFFFu
+#define TASK_PRIO_LOW 1
+
+BaseType_t xTaskCreate(void (*task)(void*), const char* name,
+    uint32_t stack_depth, void* arg, int priority, TaskHandle_t* handle);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+// Task identity, threads not started by xTaskCreate() are the "loop" task
+typedef uint32_t StackType_t;
+typedef uint32_t UBaseType_t;
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+char* pcTaskGetName(TaskHandle_t task);
+
+// Words of stack never used, as FreeRTOS counts them
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+namespace host_task
+{
+    // Set the high-water mark uxTaskGetStackHighWaterMark() reports
+    void set_stack_high_water(TaskHandle_t task, UBaseType_t words);
+}
@@ -0,0 +1,47 @@
+// Host stand-in for the Bluefruit nRF52 library, notifications and
+// indications go to the host_bluefruit listener
+
+#pragma once
+
+// Imports
+#include <Arduino.h>
+
+class BLEService
+{
+public:
+    BLEService(uint16_t uuid) : uuid(uuid) {}
+    void begin() {}
+    uint16_t getUuid() { return uuid; }
+
+private:
+    uint16_t uuid;
+};
+
+class BLECharacteristic
+{
+public:
+    BLECharacteristic(uint16_t uuid) : uuid(uuid) {}
+    void begin() {}
+    uint16_t getUuid() { return uuid; }
+
+    // Returns false if the host_bluefruit listener refused the value
+    bool notify(const void* data, uint16_t len);
+    bool indicate(const void* data, uint16_t len);
+
+private:
+    uint16_t uuid;
+};
+
+class AdafruitBluefruit
+{
+public:
+    bool connected() { return is_connected; }
+
+    // Set by host_bluefruit::set_connected()
+    void setConnected(bool connected) { is_connected = connected; }
+
+private:
+    bool is_connected = false;
+};
+
+extern AdafruitBluefruit Bluefruit;
@@ -0,0 +1,21 @@
+// Drives the host Bluefruit stand-in from the central's side, for tests and
+// benchmarks of the nRF52 example logic
+
+#pragma once
+
+// Imports
+#include <bluefruit.h>
+
+namespace host_bluefruit
+{
+    // Called for every value the peripheral sends, return false to simulate
+    // a full TX queue or a central that did not subscribe
+    typedef bool (*send_listener_t)(void* arg, uint16_t uuid,
+        const uint8_t* data, uint16_t len);
+
+    // Receive everything the peripheral sends, nullptr to accept and drop
+    void set_send_listener(send_listener_t listener, void* arg);
+
+    // Connect or disconnect the central
+    void set_connected(bool connected);
+}
@@ -0,0 +1,100 @@
+// Host stand-in for the FreeRTOS task calls the nRF52 examples use, tasks
+// run as host threads. Kept apart from host_nrf52.cpp so only code that
+// starts tasks links the threading
+
+// Imports
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <Arduino.h>
+
+// Task notification state, a counting semaphore per task
+struct HostTask
+{
+    std::mutex mutex;
+    std::condition_variable notified;
+    uint32_t count = 0;
+    char name[16] = "loop";
+    UBaseType_t stack_high_water = 0;
+};
+
+namespace
+{
+    // Stands in for every thread xTaskCreate() did not start
+    HostTask loop_task;
+
+    thread_local HostTask* current_task = nullptr;
+}
+
+// Tasks never end, like the firmware's, so their threads are detached. One
+// that returns anyway is freed, as vTaskDelete(NULL) would.
+BaseType_t xTaskCreate(void (*task)(void*), const char* name,
+    uint32_t stack_depth, void* arg, int priority, TaskHandle_t* handle)
+{
+    (void) stack_depth;
+    (void) priority;
+    HostTask* state = new HostTask();
+    strncpy(state->name, name, sizeof(state->name) - 1);
+    if (handle != nullptr) { *handle = state; }
+    std::thread([=]()
+    {
+        current_task = state;
+        task(arg);
+        current_task = nullptr;
+        delete state;
+    }).detach();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    HostTask* state = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    auto has_count = [state]() { return state->count > 0; };
+    if (ticks == portMAX_DELAY)
+    {
+        // Timed waits only, the untimed one needs a newer libstdc++ than
+        // some toolchains find first at run time
+        while (!state->notified.wait_for(lock, std::chrono::seconds(1),
+            has_count)) {}
+    }
+    else
+    {
+        state->notified.wait_for(lock, std::chrono::milliseconds(ticks),
+            has_count);
+    }
+    uint32_t count = state->count;
+    state->count = clear_on_exit ? 0 : (count > 0 ? count - 1 : 0);
+    return count;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->count++;
+    }
+    task->notified.notify_one();
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return current_task != nullptr ? current_task : &loop_task;
+}
+
+char* pcTaskGetName(TaskHandle_t task)
+{
+    return task->name;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    return task->stack_high_water;
+}
+
+void host_task::set_stack_high_water(TaskHandle_t task, UBaseType_t words)
+{
+    task->stack_high_water = words;
+}
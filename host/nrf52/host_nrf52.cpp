@@ -0,0 +1,127 @@
+// Host stand-in implementations of the Adafruit nRF52 Arduino core
+
+// Imports
+#include <stdarg.h>
+#include <Arduino.h>
+#include <host_clock.hpp>
+#include "host_bluefruit.hpp"
+
+HardwareSerial Serial;
+AdafruitBluefruit Bluefruit;
+
+namespace
+{
+    host_bluefruit::send_listener_t send_listener = nullptr;
+    void* send_arg = nullptr;
+
+    int heap_total = 0;
+    int heap_used = 0;
+
+    bool send_to_listener(uint16_t uuid, const void* data, uint16_t len)
+    {
+        if (!Bluefruit.connected()) { return false; }
+        if (send_listener == nullptr) { return true; }
+        return send_listener(send_arg, uuid, (const uint8_t*) data, len);
+    }
+}
+
+uint32_t millis()
+{
+    return (uint32_t) (host_clock::now_us() / 1000);
+}
+
+uint32_t micros()
+{
+    return (uint32_t) host_clock::now_us();
+}
+
+void delay(uint32_t ms)
+{
+    host_clock::sleep_us((int64_t) ms * 1000);
+}
+
+int dbgHeapTotal(void)
+{
+    return heap_total;
+}
+
+int dbgHeapUsed(void)
+{
+    return heap_used;
+}
+
+void host_heap::set(int total_bytes, int used_bytes)
+{
+    heap_total = total_bytes;
+    heap_used = used_bytes;
+}
+
+// Print helpers, all formatting goes through printf
+size_t Print::write(const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) { write(data[i]); }
+    return len;
+}
+
+size_t Print::print(const char* text)
+{
+    return write((const uint8_t*) text, strlen(text));
+}
+
+size_t Print::print(int value) { return printf("%d", value); }
+size_t Print::print(unsigned value) { return printf("%u", value); }
+size_t Print::print(long value) { return printf("%ld", value); }
+size_t Print::print(unsigned long value) { return printf("%lu", value); }
+
+size_t Print::print(double value, int digits)
+{
+    return printf("%.*f", digits, value);
+}
+
+size_t Print::println(const char* text)
+{
+    return print(text) + print("\r\n");
+}
+
+size_t Print::printf(const char* format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len < 0) { return 0; }
+    return write((const uint8_t*) buffer,
+        std::min((size_t) len, sizeof(buffer) - 1));
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t len)
+{
+    return fwrite(data, 1, len, stdout);
+}
+
+bool BLECharacteristic::notify(const void* data, uint16_t len)
+{
+    return send_to_listener(uuid, data, len);
+}
+
+bool BLECharacteristic::indicate(const void* data, uint16_t len)
+{
+    return send_to_listener(uuid, data, len);
+}
+
+void host_bluefruit::set_send_listener(send_listener_t listener, void* arg)
+{
+    send_listener = listener;
+    send_arg = arg;
+}
+
+void host_bluefruit::set_connected(bool connected)
+{
+    Bluefruit.setConnected(connected);
+}
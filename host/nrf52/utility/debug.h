@@ -0,0 +1,13 @@
+// Host stand-in for the Adafruit nRF52 core's debug helpers. The host has no
+// fixed heap, so the figures are whatever host_heap::set() last gave
+
+#pragma once
+
+int dbgHeapTotal(void);
+int dbgHeapUsed(void);
+
+namespace host_heap
+{
+    // Set the figures dbgHeapTotal() and dbgHeapUsed() report
+    void set(int total_bytes, int used_bytes);
+}
@@ -0,0 +1,246 @@
+// Heap, stack and hot path allocation statistics
+
+// Imports
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#include "esp32_memory_stats.hpp"
+
+namespace
+{
+    const char* const HOT_PATH_NAMES[ESP32RaceChrono::HOT_PATH_COUNT] =
+        { "monitor_notify", "can_update", "shift_light" };
+
+#ifdef RACECHRONO_MEMORY_STATS
+    std::atomic<uint32_t> hot_path_runs[ESP32RaceChrono::HOT_PATH_COUNT];
+    std::atomic<uint32_t> hot_path_allocations[ESP32RaceChrono::HOT_PATH_COUNT];
+#ifdef RACECHRONO_ALLOC_TRAP
+    std::atomic<bool> alloc_trap(true);
+#else
+    std::atomic<bool> alloc_trap(false);
+#endif
+
+    // Hot path the running task is in, scopes nest
+    thread_local ESP32RaceChrono::hot_path_t current_path =
+        ESP32RaceChrono::HOT_PATH_NONE;
+#endif
+}
+
+#ifdef RACECHRONO_MEMORY_STATS
+namespace
+{
+    // Count an allocation made on the running hot path, if any
+    void count_allocation()
+    {
+        ESP32RaceChrono::hot_path_t path = current_path;
+        if (path != ESP32RaceChrono::HOT_PATH_NONE)
+        {
+            hot_path_allocations[path]++;
+            if (alloc_trap) { abort(); }
+        }
+    }
+
+    void* allocate(size_t size)
+    {
+        count_allocation();
+        return malloc(size > 0 ? size : 1);
+    }
+
+    // Throw like the standard forms, or abort without exceptions
+    void* succeeded(void* ptr)
+    {
+        if (ptr == nullptr)
+        {
+#if __cpp_exceptions
+            throw std::bad_alloc();
+#else
+            abort();
+#endif
+        }
+        return ptr;
+    }
+
+#if __cpp_aligned_new
+    void* allocate_aligned(size_t size, std::align_val_t alignment)
+    {
+        count_allocation();
+        size_t align = (size_t) alignment;
+        size_t rounded = size > 0 ? (size + align - 1) / align * align : align;
+        return aligned_alloc(align, rounded);
+    }
+#endif
+}
+
+// Every form of new and delete is replaced so all of them pair malloc()
+// with free(), the library's own would not count or might not match
+void* operator new(size_t size) { return succeeded(allocate(size)); }
+void* operator new[](size_t size) { return succeeded(allocate(size)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+
+#if __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return succeeded(allocate_aligned(size, alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return succeeded(allocate_aligned(size, alignment));
+}
+void* operator new(size_t size, std::align_val_t alignment,
+    const std::nothrow_t&) noexcept
+{
+    return allocate_aligned(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment,
+    const std::nothrow_t&) noexcept
+{
+    return allocate_aligned(size, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    free(ptr);
+}
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    free(ptr);
+}
+#endif
+
+// Enter a hot path, counting the run
+ESP32RaceChrono::HotPathScope::HotPathScope(hot_path_t path)
+    : previous(current_path)
+{
+    current_path = path;
+    hot_path_runs[path]++;
+}
+
+// Back to whatever ran before
+ESP32RaceChrono::HotPathScope::~HotPathScope()
+{
+    current_path = previous;
+}
+#endif
+
+// Constructor, nothing watched yet
+ESP32RaceChrono::MemoryStats::MemoryStats()
+    : task_count(0) {}
+
+// Add a task to the stack report, once
+bool ESP32RaceChrono::MemoryStats::watch_task(TaskHandle_t task,
+    const char* name)
+{
+    if (task == nullptr) { task = xTaskGetCurrentTaskHandle(); }
+    for (size_t i = 0; i < task_count; i++)
+    {
+        if (tasks[i] == task) { return true; }
+    }
+    if (task_count == RACECHRONO_MEMORY_TASKS_MAX) { return false; }
+    tasks[task_count] = task;
+    task_names[task_count] = name != nullptr ? name : pcTaskGetName(task);
+    task_count++;
+    return true;
+}
+
+// Read the heap, the minimum is kept by the allocator itself
+ESP32RaceChrono::HeapStats ESP32RaceChrono::MemoryStats::heap()
+{
+    HeapStats stats;
+    stats.free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    stats.min_free_bytes = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    stats.largest_free_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    return stats;
+}
+
+// ESP-IDF counts stacks in bytes
+uint32_t ESP32RaceChrono::MemoryStats::stack_high_water(size_t index)
+{
+    return uxTaskGetStackHighWaterMark(tasks[index]);
+}
+
+uint32_t ESP32RaceChrono::MemoryStats::hot_path_runs(hot_path_t path)
+{
+#ifdef RACECHRONO_MEMORY_STATS
+    return ::hot_path_runs[path];
+#else
+    (void) path;
+    return 0;
+#endif
+}
+
+uint32_t ESP32RaceChrono::MemoryStats::hot_path_allocations(hot_path_t path)
+{
+#ifdef RACECHRONO_MEMORY_STATS
+    return ::hot_path_allocations[path];
+#else
+    (void) path;
+    return 0;
+#endif
+}
+
+void ESP32RaceChrono::MemoryStats::reset_hot_paths()
+{
+#ifdef RACECHRONO_MEMORY_STATS
+    for (size_t i = 0; i < HOT_PATH_COUNT; i++)
+    {
+        ::hot_path_runs[i] = 0;
+        ::hot_path_allocations[i] = 0;
+    }
+#endif
+}
+
+void ESP32RaceChrono::MemoryStats::set_alloc_trap(bool enabled)
+{
+#ifdef RACECHRONO_MEMORY_STATS
+    alloc_trap = enabled;
+#else
+    (void) enabled;
+#endif
+}
+
+// Print the report, "heap", "stack" and "hot" lines
+void ESP32RaceChrono::MemoryStats::print(Print& out)
+{
+    HeapStats stats = heap();
+    out.printf("heap free %u min %u largest %u fragmentation %u%%\n",
+        (unsigned) stats.free_bytes, (unsigned) stats.min_free_bytes,
+        (unsigned) stats.largest_free_block,
+        (unsigned) stats.fragmentation_percent());
+    for (size_t i = 0; i < task_count; i++)
+    {
+        out.printf("stack %s unused %u\n", task_names[i],
+            (unsigned) stack_high_water(i));
+    }
+#ifdef RACECHRONO_MEMORY_STATS
+    for (size_t i = 0; i < HOT_PATH_COUNT; i++)
+    {
+        hot_path_t path = (hot_path_t) i;
+        out.printf("hot %s runs %u allocations %u\n", hot_path_name(path),
+            (unsigned) hot_path_runs(path),
+            (unsigned) hot_path_allocations(path));
+    }
+#endif
+}
+
+const char* ESP32RaceChrono::MemoryStats::hot_path_name(hot_path_t path)
+{
+    return path < HOT_PATH_COUNT ? HOT_PATH_NAMES[path] : "?";
+}
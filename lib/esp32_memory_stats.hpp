@@ -0,0 +1,112 @@
+// Heap and stack high-water marks, and allocations made on the per-value hot
+// paths, so field builds can tell how close they run to exhaustion
+
+#pragma once
+
+// Imports
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Number of tasks whose stacks can be watched
+#ifndef RACECHRONO_MEMORY_TASKS_MAX
+#define RACECHRONO_MEMORY_TASKS_MAX 8
+#endif
+
+// Namespace for RaceChrono connections via ESP32
+namespace ESP32RaceChrono
+{
+    // Code that runs for every value or frame and should never allocate
+    enum hot_path_t : uint8_t
+    {
+        HOT_PATH_MONITOR_NOTIFY, // Monitor value notification, callbacks included
+        HOT_PATH_CAN_UPDATE,     // CANSpoof::update()
+        HOT_PATH_SHIFT_LIGHT,    // Shift light frame encoding
+        HOT_PATH_COUNT,
+        HOT_PATH_NONE = HOT_PATH_COUNT
+    };
+
+    // Heap figures for 8-bit capable memory
+    struct HeapStats
+    {
+        size_t free_bytes;
+        size_t min_free_bytes;
+        size_t largest_free_block;
+
+        // Share of the free heap not usable in one block, 0-100
+        uint8_t fragmentation_percent() const
+        {
+            return free_bytes == 0 ? 0 :
+                (uint8_t) (100 - largest_free_block * 100 / free_bytes);
+        }
+    };
+
+    // Marks the code between construction and destruction as a hot path.
+    // Built with RACECHRONO_MEMORY_STATS, runs and the allocations made
+    // through operator new on the same task are counted, which covers
+    // std::vector, std::string and new but not malloc() from C code. The
+    // define has to be set for every file of the build, e.g. in build_flags
+    class HotPathScope
+    {
+#ifdef RACECHRONO_MEMORY_STATS
+    private:
+        hot_path_t previous;
+
+    public:
+        HotPathScope(hot_path_t path);
+        ~HotPathScope();
+#else
+    public:
+        HotPathScope(hot_path_t path) { (void) path; }
+#endif
+        HotPathScope(const HotPathScope&) = delete;
+        HotPathScope& operator=(const HotPathScope&) = delete;
+    };
+
+    // Memory report, heap and stacks are read when asked for
+    class MemoryStats
+    {
+    private:
+        TaskHandle_t tasks[RACECHRONO_MEMORY_TASKS_MAX];
+        const char* task_names[RACECHRONO_MEMORY_TASKS_MAX];
+        size_t task_count;
+
+    public:
+        // Constructor
+        MemoryStats();
+
+        // Watch a task's stack, nullptr for the calling task. The name
+        // defaults to the task's own. Returns false when the table is full
+        bool watch_task(TaskHandle_t task=nullptr, const char* name=nullptr);
+
+        // Current heap figures
+        HeapStats heap();
+
+        // Watched tasks
+        size_t watched_tasks() { return task_count; }
+        const char* task_name(size_t index) { return task_names[index]; }
+
+        // Bytes of a watched task's stack that were never used
+        uint32_t stack_high_water(size_t index);
+
+        // Times a hot path ran and allocations made on it, always 0 without
+        // RACECHRONO_MEMORY_STATS
+        static uint32_t hot_path_runs(hot_path_t path);
+        static uint32_t hot_path_allocations(hot_path_t path);
+
+        // Zero the hot path counters
+        static void reset_hot_paths();
+
+        // Abort on the first allocation made on a hot path, with the
+        // allocating call on the backtrace. Defaults to on when built with
+        // RACECHRONO_ALLOC_TRAP, meant for debug builds
+        static void set_alloc_trap(bool enabled);
+
+        // Print heap, stacks and hot paths, one line each
+        void print(Print& out);
+
+        // Short name of a hot path in reports
+        static const char* hot_path_name(hot_path_t path);
+    };
+}
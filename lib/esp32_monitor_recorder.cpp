@@ -0,0 +1,125 @@
+// Monitor API traffic recorder
+
+// Imports
+#include "esp32_monitor_recorder.hpp"
+
+namespace
+{
+    const char* const EVENT_NAMES[ESP32RaceChrono::TRACE_EVENT_COUNT] =
+        { "I5", "W5", "W6", "SUB", "DIS" };
+}
+
+// Allocate the ring, nothing is allocated while recording
+ESP32RaceChrono::MonitorRecorder::MonitorRecorder(size_t capacity)
+    : entries(capacity)
+    , next(0)
+    , count(0)
+    , overwritten_count(0)
+    , mux(portMUX_INITIALIZER_UNLOCKED) {}
+
+// Copy an event into the ring, overwriting the oldest when full
+void ESP32RaceChrono::MonitorRecorder::record(trace_event_t event,
+    const uint8_t* data, size_t len)
+{
+    if (entries.empty()) { return; }
+    int64_t time_us = esp_timer_get_time();
+    len = min(len, TRACE_DATA_MAX);
+    portENTER_CRITICAL(&mux);
+    TraceEntry& entry = entries[next];
+    entry.time_us = time_us;
+    entry.event = event;
+    entry.len = len;
+    if (len > 0) { memcpy(entry.data, data, len); }
+    next = (next + 1) % entries.size();
+    if (count < entries.size())
+    {
+        count++;
+    }
+    else
+    {
+        overwritten_count++;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+// Empty the ring
+void ESP32RaceChrono::MonitorRecorder::clear()
+{
+    portENTER_CRITICAL(&mux);
+    next = 0;
+    count = 0;
+    overwritten_count = 0;
+    portEXIT_CRITICAL(&mux);
+}
+
+// Copy out an event, oldest first
+ESP32RaceChrono::TraceEntry ESP32RaceChrono::MonitorRecorder::at(size_t index)
+{
+    portENTER_CRITICAL(&mux);
+    TraceEntry entry = entries[(next + entries.size() - count + index) %
+        entries.size()];
+    portEXIT_CRITICAL(&mux);
+    return entry;
+}
+
+// Print every event, slow, call when the trace is needed
+void ESP32RaceChrono::MonitorRecorder::dump(Print& out)
+{
+    out.printf("# racechrono monitor trace, %u overwritten\n",
+        (unsigned) overwritten_count);
+    size_t n = count;
+    for (size_t i = 0; i < n; i++)
+    {
+        TraceEntry entry = at(i);
+        out.printf("%lld %s ", (long long) entry.time_us,
+            event_name(entry.event));
+        for (uint8_t b = 0; b < entry.len; b++)
+        {
+            out.printf("%02x", entry.data[b]);
+        }
+        out.printf("\n");
+    }
+}
+
+// Parse "<time_us> <event> <hex data>", the data may be missing
+bool ESP32RaceChrono::MonitorRecorder::parse_line(const char* line,
+    TraceEntry& entry)
+{
+    long long time_us;
+    char name[8];
+    char hex[2 * TRACE_DATA_MAX + 2] = "";
+    if (line[0] == '#' ||
+        sscanf(line, "%lld %7s %41s", &time_us, name, hex) < 2)
+    {
+        return false;
+    }
+    entry.time_us = time_us;
+    entry.event = TRACE_EVENT_COUNT;
+    for (uint8_t e = 0; e < TRACE_EVENT_COUNT; e++)
+    {
+        if (strcmp(name, EVENT_NAMES[e]) == 0)
+        {
+            entry.event = (trace_event_t) e;
+        }
+    }
+    size_t hex_len = strlen(hex);
+    if (entry.event == TRACE_EVENT_COUNT || hex_len % 2 != 0 ||
+        hex_len / 2 > TRACE_DATA_MAX)
+    {
+        return false;
+    }
+    entry.len = hex_len / 2;
+    for (uint8_t b = 0; b < entry.len; b++)
+    {
+        unsigned value;
+        if (sscanf(hex + 2 * b, "%2x", &value) != 1) { return false; }
+        entry.data[b] = value;
+    }
+    return true;
+}
+
+// Name used in dumps
+const char* ESP32RaceChrono::MonitorRecorder::event_name(trace_event_t event)
+{
+    return event < TRACE_EVENT_COUNT ? EVENT_NAMES[event] : "?";
+}
@@ -0,0 +1,81 @@
+// Records Monitor API traffic into a RAM ring, so field timing issues can be
+// dumped over serial and replayed on the host
+
+#pragma once
+
+// Imports
+#include <vector>
+#include <Arduino.h>
+
+// Number of events kept, older ones are overwritten
+#ifndef RACECHRONO_RECORDER_CAPACITY
+#define RACECHRONO_RECORDER_CAPACITY 512
+#endif
+
+// Namespace for RaceChrono connections via ESP32
+namespace ESP32RaceChrono
+{
+    // What happened on the Monitor characteristics
+    enum trace_event_t : uint8_t
+    {
+        TRACE_INDICATE_CONFIG, // Indication sent on 0x0005
+        TRACE_WRITE_CONFIG,    // Write received on 0x0005
+        TRACE_WRITE_NOTIFY,    // Write received on 0x0006
+        TRACE_SUBSCRIBE,       // Indications enabled on 0x0005
+        TRACE_DISCONNECT,      // Central disconnected
+        TRACE_EVENT_COUNT
+    };
+
+    // Bytes kept per event, longer payloads are truncated
+    const size_t TRACE_DATA_MAX = 20;
+
+    // One recorded event
+    struct TraceEntry
+    {
+        int64_t time_us;
+        trace_event_t event;
+        uint8_t len;
+        uint8_t data[TRACE_DATA_MAX];
+    };
+
+    // Ring of trace entries, safe to record into from any task
+    class MonitorRecorder
+    {
+    private:
+        std::vector<TraceEntry> entries;
+        size_t next;
+        size_t count;
+        uint32_t overwritten_count;
+        portMUX_TYPE mux;
+
+    public:
+        // Constructor, allocates the whole ring up front
+        MonitorRecorder(size_t capacity=RACECHRONO_RECORDER_CAPACITY);
+
+        // Record an event with esp_timer_get_time() as its time
+        void record(trace_event_t event, const uint8_t* data, size_t len);
+
+        // Forget all recorded events
+        void clear();
+
+        // Number of events in the ring
+        size_t size() { return count; }
+
+        // Number of events lost because the ring was full
+        uint32_t overwritten() { return overwritten_count; }
+
+        // Get a recorded event, 0 is the oldest
+        TraceEntry at(size_t index);
+
+        // Print the ring oldest first, one event per line as
+        // "<time_us> <event> <hex data>"
+        void dump(Print& out);
+
+        // Parse a line printed by dump(), returns false for comments and
+        // malformed lines
+        static bool parse_line(const char* line, TraceEntry& entry);
+
+        // Short name of an event in dumps
+        static const char* event_name(trace_event_t event);
+    };
+}
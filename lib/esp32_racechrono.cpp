@@ -5,6 +5,19 @@
 #include "esp32_racechrono.hpp"
 
 
+// Replace the advertising schedule, applied from the next phase change
+void ESP32RaceChrono::set_advertising_policy(BLEServer* server,
+    const AdvertisingPolicy& policy)
+{
+    impl::ServerCallbacks::attach(server)->policy = policy;
+}
+
+// Re-escalate advertising on a wake event
+void ESP32RaceChrono::wake(BLEServer* server)
+{
+    impl::ServerCallbacks::attach(server)->wake();
+}
+
 // Class for an equation to monitor
 ESP32RaceChrono::Equation::Equation(std::string equation, float scale)
     : scale_inv(1.0f / scale)
@@ -21,12 +34,15 @@ void ESP32RaceChrono::Equation::update_from_raw(int32_t raw)
 // Create the service and configure advertising if necessary. Then add config
 // and notify characteristics for the Monitor API
 ESP32RaceChrono::Monitor::Monitor(BLEServer* server)
-    : SERVICE_UUID((uint16_t) 0x1FF8)
-    , MON_CONFIG_CHAR_UUID((uint16_t) 0x0005)
-    , MON_NOTIFY_CHAR_UUID((uint16_t) 0x0006)
+    : SERVICE_UUID(RaceChronoProtocol::SERVICE_UUID)
+    , MON_CONFIG_CHAR_UUID(RaceChronoProtocol::MONITOR_CONFIG_UUID)
+    , MON_NOTIFY_CHAR_UUID(RaceChronoProtocol::MONITOR_NOTIFY_UUID)
     , server(server)
-    , eqs()
     , state(impl::monitor_state_t::UNINITIALIZED)
+    , disconnect_ms(0)
+    , reconnect_ms(0)
+    , awaiting_first_value(false)
+    , eqs()
 {
     // Sanity checks
     assert(TIMEOUT_RESET_MS > TIMEOUT_REFRESH_MS);
@@ -38,7 +54,9 @@ ESP32RaceChrono::Monitor::Monitor(BLEServer* server)
         service = server->createService(SERVICE_UUID);
     }
     server->getAdvertising()->addServiceUUID(SERVICE_UUID);
-    server->startAdvertising();
+    server_callbacks = impl::ServerCallbacks::attach(server);
+    server_callbacks->set_monitor(this);
+    server_callbacks->advertise(impl::adv_phase_t::ADV_FAST);
 
     // Create the config and notify characteristics with callbacks
     config_ch = service->createCharacteristic(
@@ -48,13 +66,18 @@ ESP32RaceChrono::Monitor::Monitor(BLEServer* server)
     notify_ch = service->createCharacteristic(
         MON_NOTIFY_CHAR_UUID,
         BLECharacteristic::PROPERTY_WRITE_NR);
-    server_callbacks = new impl::ServerCallbacks();
     mon_config_callbacks = new impl::MonConfigCallbacks(this);
     mon_notify_callbacks = new impl::MonNotifyCallbacks(this);
-    server->setCallbacks(server_callbacks);
+    mon_cccd_callbacks = new impl::MonCccdCallbacks(this);
     config_ch->setCallbacks(mon_config_callbacks);
     notify_ch->setCallbacks(mon_notify_callbacks);
 
+    // CCCD on the config characteristic, lets us configure as soon as the app
+    // subscribes instead of waiting for the retry timer
+    BLE2902* config_cccd = new BLE2902();
+    config_cccd->setCallbacks(mon_cccd_callbacks);
+    config_ch->addDescriptor(config_cccd);
+
     // Start the configured service
     service->start();
     state = impl::monitor_state_t::STARTED;
@@ -65,12 +88,12 @@ ESP32RaceChrono::Monitor::Monitor(BLEServer* server)
 ESP32RaceChrono::Monitor::~Monitor()
 {
     server->removeService(service);
-    server->setCallbacks(nullptr);
+    server_callbacks->set_monitor(nullptr);
     config_ch->setCallbacks(nullptr);
     notify_ch->setCallbacks(nullptr);
-    delete server_callbacks;
     delete mon_config_callbacks;
     delete mon_notify_callbacks;
+    delete mon_cccd_callbacks;
 }
 
 // Add an equation to the active monitors
@@ -89,43 +112,19 @@ void ESP32RaceChrono::Monitor::configure_equations()
         return;
     }
 
-    // Constants and buffers
-    const int max_payload = 17; // 3 bytes header, 20 bytes max
-    uint8_t payload[24];
-
-    // Iterate over all added equations
+    // Send every equation in as many chunks as it takes, sliced in place
+    uint8_t payload[RaceChronoProtocol::CONFIG_CHUNK_MAX];
     for (unsigned eq_idx = 0; eq_idx < eqs.size(); eq_idx++)
     {
-        // Vars for this equation
-        auto eq = eqs[eq_idx];
-        const size_t equation_len = eq.equation.length();
-        uint8_t mon_config_seq_num = 0;
-
-        // Send as many messages as necessary to finish the equation
-        for (int i = 0; i < equation_len; i += max_payload)
+        const std::string& equation = eqs[eq_idx].equation;
+        size_t chunks = RaceChronoProtocol::config_chunk_count(
+            RaceChronoProtocol::MONITOR_ADD, equation.length());
+        for (size_t chunk = 0; chunk < chunks; chunk++)
         {
-            // Determine if we can complete the equation with this payload
-            size_t payload_len;
-            if (equation_len - i > max_payload) // Need another message
-            {
-                payload[0] = 2;
-                payload_len = 20;
-            }
-            else // Complete, last message for this equation
-            {
-                payload[0] = 3;
-                payload_len = 3 + (equation_len - i);
-            }
-
-            // Write payload
-            payload[1] = eq_idx;
-            payload[2] = mon_config_seq_num;
-            memcpy(payload + 3, eq.equation.substr(i).c_str(), payload_len - 3);
-
-            // Send it
-            config_ch->setValue(payload, payload_len);
-            config_ch->indicate();
-            mon_config_seq_num += 1;
+            uint8_t len = RaceChronoProtocol::encode_config_chunk(payload,
+                RaceChronoProtocol::MONITOR_ADD, eq_idx, equation.data(),
+                equation.length(), chunk);
+            indicate_config(payload, len);
         }
     }
 
@@ -133,13 +132,21 @@ void ESP32RaceChrono::Monitor::configure_equations()
     timeout_reset(false);
 }
 
+// Send a config message, every one goes through here so it can be traced
+void ESP32RaceChrono::Monitor::indicate_config(uint8_t* payload, size_t len)
+{
+    trace(TRACE_INDICATE_CONFIG, payload, len);
+    config_ch->setValue(payload, len);
+    config_ch->indicate();
+}
+
 // Request the API send an update for all equations
 void ESP32RaceChrono::Monitor::update_all()
 {
-    uint8_t payload[1];
-    payload[0] = 4; // Update all
-    config_ch->setValue(payload, sizeof(payload));
-    config_ch->indicate();
+    uint8_t payload[RaceChronoProtocol::CONFIG_CHUNK_MAX];
+    uint8_t len = RaceChronoProtocol::encode_config_chunk(payload,
+        RaceChronoProtocol::MONITOR_UPDATE_ALL, 0, nullptr, 0, 0);
+    indicate_config(payload, len);
 }
 
 // Request a reset of all equations
@@ -148,14 +155,14 @@ void ESP32RaceChrono::Monitor::reset()
     // Request RaceChrono to remove all equations if listening
     if (server->getConnectedCount() > 0)
     {
-        uint8_t payload[1];
-        payload[0] = 0; // Reset
-        config_ch->setValue(payload, sizeof(payload));
-        config_ch->indicate();
+        uint8_t payload[RaceChronoProtocol::CONFIG_CHUNK_MAX];
+        uint8_t len = RaceChronoProtocol::encode_config_chunk(payload,
+            RaceChronoProtocol::MONITOR_REMOVE_ALL, 0, nullptr, 0, 0);
+        indicate_config(payload, len);
     }
 
     // Reset all our stored values
-    for (auto eq : eqs) { eq.clear(); }
+    for (auto& eq : eqs) { eq.clear(); }
 
     // Reset our state to STARTED and re-configure equations
     state = impl::monitor_state_t::STARTED;
@@ -169,6 +176,54 @@ bool ESP32RaceChrono::Monitor::data_valid()
         state == impl::monitor_state_t::FORCED_REFRESH;
 }
 
+// Register a listener for value changes
+void ESP32RaceChrono::Monitor::add_value_callback(value_callback_t callback,
+    void* arg)
+{
+    value_callbacks.push_back(std::make_pair(callback, arg));
+}
+
+// Pass a changed value on to every listener
+void ESP32RaceChrono::Monitor::value_changed(size_t index, int64_t arrival_us)
+{
+    for (auto& cb : value_callbacks)
+    {
+        cb.first(cb.second, index, eqs[index].value, arrival_us);
+    }
+}
+
+// Connection dropped, forget the configuration and start timing the reconnect
+void ESP32RaceChrono::Monitor::disconnected()
+{
+    trace(TRACE_DISCONNECT, nullptr, 0);
+    for (auto& eq : eqs) { eq.clear(); }
+    state = impl::monitor_state_t::STARTED;
+    disconnect_ms = millis();
+    awaiting_first_value = true;
+    timeout_reset(false);
+}
+
+// App subscribed to the config characteristic, configure right away. This
+// runs on the BLE task, which also delivers the confirmations indicate()
+// waits for, so the equations are sent from the timer task
+void ESP32RaceChrono::Monitor::subscribed()
+{
+    state = impl::monitor_state_t::STARTED;
+    t_state.once_ms<ESP32RaceChrono::Monitor*>(0, impl::t_state_callback,
+        this);
+}
+
+// Value notification arrived, record the reconnect time for the first one
+void ESP32RaceChrono::Monitor::value_received()
+{
+    if (awaiting_first_value)
+    {
+        reconnect_ms = millis() - disconnect_ms;
+        awaiting_first_value = false;
+    }
+    timeout_reset();
+}
+
 // Timeout occured, transition state
 void ESP32RaceChrono::Monitor::timeout_state()
 {
@@ -192,6 +247,9 @@ void ESP32RaceChrono::Monitor::timeout_state()
             // No response from RaceChrono, reset
             reset();
             break;
+        case impl::monitor_state_t::UNINITIALIZED:
+            // Not subscribed, a stale timer has nothing to do
+            break;
     }
 }
 
@@ -208,6 +266,9 @@ void ESP32RaceChrono::Monitor::timeout_reset(bool update_state)
                 impl::t_state_callback, this);
             if (update_state) { state = impl::monitor_state_t::ACTIVE; }
             break;
+        case impl::monitor_state_t::UNINITIALIZED:
+            // Timers start once subscribed
+            break;
     }
 }
 
@@ -217,17 +278,197 @@ void ESP32RaceChrono::impl::t_state_callback(ESP32RaceChrono::Monitor* instance)
     instance->timeout_state();
 }
 
-// Server callback re-starts advertising after a disconnect
+// C-style callback for advertising timers
+void ESP32RaceChrono::impl::t_adv_callback(
+    ESP32RaceChrono::impl::ServerCallbacks* instance)
+{
+    instance->timeout_phase();
+}
+
+// C-style callback for posted connection events
+void ESP32RaceChrono::impl::t_event_callback(
+    ESP32RaceChrono::impl::ServerCallbacks* instance)
+{
+    instance->run_events();
+}
+
+// Server callbacks start with no known central
+ESP32RaceChrono::impl::ServerCallbacks::ServerCallbacks(BLEServer* server)
+    : server(server)
+    , mon(nullptr)
+    , has_peer(false)
+    , peer_addr_type(BLE_ADDR_TYPE_PUBLIC)
+    , phase(adv_phase_t::ADV_IDLE)
+    , interval(0)
+    , pending_events(0)
+    , policy() {}
+
+// Only one set of server callbacks exists, shared by the Monitor and CAN APIs
+ESP32RaceChrono::impl::ServerCallbacks*
+ESP32RaceChrono::impl::ServerCallbacks::attach(BLEServer* server)
+{
+    static ServerCallbacks* instance = nullptr;
+    if (instance == nullptr)
+    {
+        instance = new ServerCallbacks(server);
+        server->setCallbacks(instance);
+    }
+    return instance;
+}
+
+// Stop whatever is running and advertise in the requested phase
+void ESP32RaceChrono::impl::ServerCallbacks::advertise(adv_phase_t next)
+{
+    // Nothing to do while connected, and directed needs a known central
+    if (server->getConnectedCount() > 0) { next = adv_phase_t::ADV_IDLE; }
+    if (next == adv_phase_t::ADV_DIRECTED && !has_peer)
+    {
+        next = adv_phase_t::ADV_FAST;
+    }
+    t_phase.detach();
+    esp_ble_gap_stop_advertising();
+    phase = next;
+
+    BLEAdvertising* adv = server->getAdvertising();
+    switch (phase)
+    {
+        case adv_phase_t::ADV_DIRECTED:
+        {
+            // High duty cycle directed advertising carries no payload and
+            // ignores the interval, so drive the GAP API directly
+            esp_ble_adv_params_t params = {};
+            params.adv_int_min = policy.fast_interval;
+            params.adv_int_max = policy.fast_interval;
+            params.adv_type = ADV_TYPE_DIRECT_IND_HIGH;
+            params.own_addr_type = BLE_ADDR_TYPE_PUBLIC;
+            memcpy(params.peer_addr, peer_addr, sizeof(esp_bd_addr_t));
+            params.peer_addr_type = peer_addr_type;
+            params.channel_map = ADV_CHNL_ALL;
+            params.adv_filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY;
+            esp_ble_gap_start_advertising(&params);
+            t_phase.attach_ms<ServerCallbacks*>(DIRECTED_MS, t_adv_callback,
+                this);
+            break;
+        }
+        case adv_phase_t::ADV_FAST:
+            interval = policy.fast_interval;
+            adv->setMinInterval(interval);
+            adv->setMaxInterval(interval);
+            adv->start();
+            t_phase.attach_ms<ServerCallbacks*>(policy.fast_ms,
+                t_adv_callback, this);
+            break;
+        case adv_phase_t::ADV_BACKOFF:
+            adv->setMinInterval(interval);
+            adv->setMaxInterval(interval);
+            adv->start();
+            if (interval < policy.max_interval)
+            {
+                t_phase.attach_ms<ServerCallbacks*>(policy.backoff_step_ms,
+                    t_adv_callback, this);
+            }
+            break;
+        case adv_phase_t::ADV_IDLE:
+            break;
+    }
+}
+
+// Phase timer expired without a connection, fall back to the next phase
+void ESP32RaceChrono::impl::ServerCallbacks::timeout_phase()
+{
+    switch (phase)
+    {
+        case adv_phase_t::ADV_DIRECTED:
+            advertise(adv_phase_t::ADV_FAST);
+            break;
+        case adv_phase_t::ADV_FAST:
+            interval = policy.backoff_interval;
+            advertise(adv_phase_t::ADV_BACKOFF);
+            break;
+        case adv_phase_t::ADV_BACKOFF:
+            // Double the interval, saturating at the policy maximum
+            interval = (interval > policy.max_interval / 2) ?
+                policy.max_interval : interval * 2;
+            advertise(adv_phase_t::ADV_BACKOFF);
+            break;
+        case adv_phase_t::ADV_IDLE:
+            break;
+    }
+}
+
+// Only the first of several events arms the timer, the rest are picked up
+// by the same run
+void ESP32RaceChrono::impl::ServerCallbacks::post(adv_event_t event)
+{
+    if (pending_events.fetch_or(event) == 0)
+    {
+        t_event.once_ms<ServerCallbacks*>(0, t_event_callback, this);
+    }
+}
+
+// Handle the posted events. advertise() falls back to idle while connected,
+// so a disconnect handled last is right whichever way round they came
+void ESP32RaceChrono::impl::ServerCallbacks::run_events()
+{
+    uint8_t events = pending_events.exchange(0);
+    if (events & ADV_EVENT_CONNECT)
+    {
+        advertise(adv_phase_t::ADV_IDLE);
+    }
+    if (events & ADV_EVENT_DISCONNECT)
+    {
+        advertise(adv_phase_t::ADV_DIRECTED);
+    }
+    if ((events & ADV_EVENT_WAKE) && phase == adv_phase_t::ADV_BACKOFF)
+    {
+        advertise(adv_phase_t::ADV_FAST);
+    }
+}
+
+// Wake event while backed off, go back to fast advertising. Sensor updates
+// call this for every value while disconnected, so only a backed off phase
+// is worth waking the timer task for
+void ESP32RaceChrono::impl::ServerCallbacks::wake()
+{
+    if (phase == adv_phase_t::ADV_BACKOFF) { post(ADV_EVENT_WAKE); }
+}
+
+// Remember the central so we can advertise directly to it after a drop. A
+// resolvable private address changes before the next connect, so only
+// public and static random addresses are kept
+void ESP32RaceChrono::impl::ServerCallbacks::onConnect(BLEServer* server,
+    esp_ble_gatts_cb_param_t* param)
+{
+    const uint8_t* addr = param->connect.remote_bda;
+    bool resolvable = param->connect.ble_addr_type == BLE_ADDR_TYPE_RANDOM &&
+        (addr[0] & 0xC0) == 0x40;
+    if (!resolvable)
+    {
+        memcpy(peer_addr, addr, sizeof(esp_bd_addr_t));
+        peer_addr_type = param->connect.ble_addr_type;
+    }
+    has_peer = !resolvable;
+    post(ADV_EVENT_CONNECT);
+}
+
+// Server callback re-starts advertising after a disconnect, directed to the
+// last central first
 void ESP32RaceChrono::impl::ServerCallbacks::onDisconnect(BLEServer* server)
 {
-    server->startAdvertising();
+    if (mon != nullptr) { mon->disconnected(); }
+    post(ADV_EVENT_DISCONNECT);
 }
 
 // Monitor Config characteristic callback
 void ESP32RaceChrono::impl::MonConfigCallbacks::onWrite(BLECharacteristic* ch)
 {
+    mon->trace(TRACE_WRITE_CONFIG, ch->getData(), ch->getLength());
+
     // Reset timers on any successful equation registration
-    if (ch->getLength() == 2 && ch->getData()[0] == 0)
+    RaceChronoProtocol::ConfigResult result;
+    if (RaceChronoProtocol::decode_config_result(ch->getData(),
+            ch->getLength(), result) &&
+        result.result == RaceChronoProtocol::MONITOR_RESULT_OK)
     {
         mon->timeout_reset();
     }
@@ -243,22 +484,45 @@ void ESP32RaceChrono::impl::MonNotifyCallbacks::onWrite(BLECharacteristic* ch)
     //     Serial.print(ch->getData()[i]);
     // }
     // Serial.println();
-    uint8_t* raw = ch->getData();
-    for (int i = 0; i < ch->getLength(); i += 5)
+    int64_t arrival_us = esp_timer_get_time();
+    HotPathScope hot_path(HOT_PATH_MONITOR_NOTIFY);
+    mon->trace(TRACE_WRITE_NOTIFY, ch->getData(), ch->getLength());
+    const uint8_t* raw = ch->getData();
+    size_t count = RaceChronoProtocol::monitor_value_count(ch->getLength());
+    for (size_t i = 0; i < count; i++)
     {
-        // uint8 ID, int32 value
-        int monitor_id = (int) raw[i];
-        int val_raw = raw[i+1]<<24 | raw[i+2]<<16 | raw[i+3]<<8 | raw[i+4];
+        uint8_t monitor_id = RaceChronoProtocol::monitor_value_id(raw, i);
+        int32_t val_raw = RaceChronoProtocol::monitor_value_raw(raw, i);
+        if (monitor_id >= mon->eqs.size())
+        {
+            continue;
+        }
+        float previous = mon->eqs[monitor_id].value;
         mon->eqs[monitor_id].update_from_raw(val_raw);
+        float value = mon->eqs[monitor_id].value;
+        if (value != previous && !(isnan(value) && isnan(previous)))
+        {
+            mon->value_changed(monitor_id, arrival_us);
+        }
+    }
+    mon->value_received();
+}
+
+// Config CCCD callback, start configuring once indications are enabled
+void ESP32RaceChrono::impl::MonCccdCallbacks::onWrite(BLEDescriptor* desc)
+{
+    if (static_cast<BLE2902*>(desc)->getIndications())
+    {
+        mon->trace(TRACE_SUBSCRIBE, nullptr, 0);
+        mon->subscribed();
     }
-    mon->timeout_reset();
 }
 
 // Spoof CAN messages to pass sensor data to RaceChrono
 ESP32RaceChrono::CANSpoof::CANSpoof(BLEServer* server)
-    : SERVICE_UUID((uint16_t) 0x1FF8)
-    , CAN_MAIN_CHAR_UUID((uint16_t) 0x0001)
-    , CAN_FILTER_CHAR_UUID((uint16_t) 0x0002)
+    : SERVICE_UUID(RaceChronoProtocol::SERVICE_UUID)
+    , CAN_MAIN_CHAR_UUID(RaceChronoProtocol::CAN_MAIN_UUID)
+    , CAN_FILTER_CHAR_UUID(RaceChronoProtocol::CAN_FILTER_UUID)
     , server(server)
 {
     // Establish service if necessary
@@ -268,18 +532,16 @@ ESP32RaceChrono::CANSpoof::CANSpoof(BLEServer* server)
         service = server->createService(SERVICE_UUID);
     }
     server->getAdvertising()->addServiceUUID(SERVICE_UUID);
-    server->startAdvertising();
+    server_callbacks = impl::ServerCallbacks::attach(server);
+    server_callbacks->advertise(impl::adv_phase_t::ADV_FAST);
 
-    // Create the main and filter characteristic and set the server callback
+    // Create the main and filter characteristic, frames are only notified
     main_ch = service->createCharacteristic(
         CAN_MAIN_CHAR_UUID,
-        BLECharacteristic::PROPERTY_READ |
         BLECharacteristic::PROPERTY_NOTIFY);
     filter_ch = service->createCharacteristic(
         CAN_FILTER_CHAR_UUID,
         BLECharacteristic::PROPERTY_WRITE);
-    server_callbacks = new impl::ServerCallbacks();
-    server->setCallbacks(server_callbacks);
 
     // Start the configured service
     service->start();
@@ -289,27 +551,27 @@ ESP32RaceChrono::CANSpoof::CANSpoof(BLEServer* server)
 ESP32RaceChrono::CANSpoof::~CANSpoof()
 {
     server->removeService(service);
-    server->setCallbacks(nullptr);
-    delete server_callbacks;
 }
 
 // Send RaceChrono a new sensor value
 void ESP32RaceChrono::CANSpoof::update(uint32_t id, uint8_t data)
 {
-    // If disconnected, do nothing
-    if (server->getConnectedCount() == 0) { return; }
+    HotPathScope hot_path(HOT_PATH_CAN_UPDATE);
+
+    // If disconnected, treat sensor activity as a wake event and do nothing
+    if (server->getConnectedCount() == 0)
+    {
+        server_callbacks->wake();
+        return;
+    }
 
     // 4-byte CAN ID + 1-byte data
-    uint8_t payload[5];
-
-    // ID is explicitly little endian, only 1 byte of data for now
-    payload[0] = id >> 0;
-    payload[1] = id >> 8;
-    payload[2] = id >> 16;
-    payload[3] = id >> 24;
-    payload[4] = data;
-
-    // Publish update on the main characteristic
-    main_ch->setValue(payload, sizeof(payload));
-    main_ch->notify();
+    uint8_t payload[RaceChronoProtocol::CAN_FRAME_MAX];
+    uint8_t len = RaceChronoProtocol::encode_can_frame(payload, id, &data, 1);
+
+    // Publish update on the main characteristic. The stack copies the payload
+    // into its own TX queue, so notify straight from the stack buffer instead
+    // of copying it into the characteristic value first.
+    esp_ble_gatts_send_indicate(server->getGattsIf(), server->getConnId(),
+        main_ch->getHandle(), len, payload, false);
 }
@@ -3,13 +3,18 @@
 #pragma once
 
 // Imports
+#include <atomic>
 #include <string>
 #include <vector>
 #include <Arduino.h>
 #include <BLEDevice.h>
 #include <BLEUtils.h>
 #include <BLEServer.h>
+#include <BLE2902.h>
 #include <Ticker.h>
+#include "esp32_memory_stats.hpp"
+#include "esp32_monitor_recorder.hpp"
+#include "racechrono_protocol.hpp"
 
 // Namespace for RaceChrono connections via ESP32
 namespace ESP32RaceChrono
@@ -26,12 +31,57 @@ namespace ESP32RaceChrono
             FORCED_REFRESH
         };
 
+        // Advertising phases after boot or a disconnect
+        enum adv_phase_t
+        {
+            ADV_IDLE,
+            ADV_DIRECTED,
+            ADV_FAST,
+            ADV_BACKOFF
+        };
+
+        // Connection events, handled on the timer task in this order
+        enum adv_event_t : uint8_t
+        {
+            ADV_EVENT_CONNECT = 1,
+            ADV_EVENT_DISCONNECT = 2,
+            ADV_EVENT_WAKE = 4
+        };
+
         // Callback classes
         class ServerCallbacks;
         class MonConfigCallbacks;
         class MonNotifyCallbacks;
+        class MonCccdCallbacks;
     }
 
+    // Advertising schedule used while no central is connected. Intervals are
+    // in units of 0.625 ms. After boot, a disconnect or a wake event the
+    // device advertises at fast_interval for fast_ms, then starts backing off
+    // from backoff_interval, doubling it every backoff_step_ms up to
+    // max_interval
+    struct AdvertisingPolicy
+    {
+        uint16_t fast_interval = 32; // 20 ms
+        uint32_t fast_ms = 30000;
+        uint16_t backoff_interval = 244; // 152.5 ms
+        uint16_t max_interval = 3200; // 2 s
+        uint32_t backoff_step_ms = 60000;
+    };
+
+    // Replace the advertising schedule for the server
+    void set_advertising_policy(BLEServer* server,
+        const AdvertisingPolicy& policy);
+
+    // Wake event (ignition, sensor activity), re-escalate to fast advertising
+    // if nobody is connected
+    void wake(BLEServer* server);
+
+    // Called from the BLE task when a monitored value changes, with the
+    // equation index, the new value and esp_timer_get_time() at its arrival
+    typedef void (*value_callback_t)(void* arg, size_t index, float value,
+        int64_t arrival_us);
+
     // Equation for an individual monitor
     class Equation
     {
@@ -71,6 +121,7 @@ namespace ESP32RaceChrono
         impl::ServerCallbacks* server_callbacks;
         impl::MonConfigCallbacks* mon_config_callbacks;
         impl::MonNotifyCallbacks* mon_notify_callbacks;
+        impl::MonCccdCallbacks* mon_cccd_callbacks;
 
         // State and timers
         static const unsigned TIMEOUT_REFRESH_MS = 1500;
@@ -79,13 +130,43 @@ namespace ESP32RaceChrono
         impl::monitor_state_t state;
         Ticker t_state;
 
+        // Reconnect timing, from disconnect to first received value
+        uint32_t disconnect_ms;
+        uint32_t reconnect_ms;
+        bool awaiting_first_value;
+
+        // Listeners for value changes
+        std::vector<std::pair<value_callback_t, void*>> value_callbacks;
+
         // Add all configured equations to RaceChrono monitors
         void configure_equations();
 
+        // Send a message on the config characteristic
+        void indicate_config(uint8_t* payload, size_t len);
+
     public:
         // Requested equations
         std::vector<Equation> eqs;
 
+#ifdef RACECHRONO_MONITOR_RECORDER
+        // Traffic trace, print it with recorder.dump(Serial). The define has
+        // to be set for every file of the build, e.g. in build_flags
+        MonitorRecorder recorder;
+#endif
+
+        // Record traffic when built with RACECHRONO_MONITOR_RECORDER, public
+        // for callback access
+        void trace(trace_event_t event, const uint8_t* data, size_t len)
+        {
+#ifdef RACECHRONO_MONITOR_RECORDER
+            recorder.record(event, data, len);
+#else
+            (void) event;
+            (void) data;
+            (void) len;
+#endif
+        }
+
         // Constructor
         Monitor(BLEServer* server);
 
@@ -104,6 +185,26 @@ namespace ESP32RaceChrono
         // Returns true if any of the equations contain valid data
         bool data_valid();
 
+        // Get notified as soon as a value changes, before the next loop()
+        void add_value_callback(value_callback_t callback, void* arg);
+
+        // Milliseconds from the last disconnect to the first value received
+        // after reconnecting, 0 if no reconnect has completed yet
+        uint32_t last_reconnect_ms() { return reconnect_ms; }
+
+        // Called on disconnect, public for callback access
+        void disconnected();
+
+        // Called when the app subscribes to indications, public for callback
+        // access
+        void subscribed();
+
+        // Called when a value notification arrives, public for callback access
+        void value_received();
+
+        // Called when an equation's value changed, public for callback access
+        void value_changed(size_t index, int64_t arrival_us);
+
         // Called when the state timer expires, public for callback access
         void timeout_state();
 
@@ -147,10 +248,67 @@ namespace ESP32RaceChrono
         // C-style function for timer callbacks
         void t_state_callback(ESP32RaceChrono::Monitor* instance);
 
-        // Server callbacks
+        // C-style function for advertising timers
+        void t_adv_callback(ServerCallbacks* instance);
+
+        // C-style function for posted connection events
+        void t_event_callback(ServerCallbacks* instance);
+
+        // Server callbacks, shared by every API on the server. Remembers the
+        // last central and walks the advertising phases after a disconnect:
+        // high duty cycle directed to the last central, then fast and finally
+        // backed off undirected advertising. Without bonding there is no IRK
+        // to resolve a private address with, so a central that connected from
+        // a resolvable private address is not advertised to directly.
+        // Connect, disconnect and wake arrive on the BLE and loop tasks and
+        // are posted to the timer task, where every phase change runs
         class ServerCallbacks : public BLEServerCallbacks
         {
+        private:
+            // Directed advertising lasts at most 1.28 s per the spec
+            static const unsigned DIRECTED_MS = 1280;
+
+            BLEServer* server;
+            Monitor* mon;
+            bool has_peer;
+            esp_bd_addr_t peer_addr;
+            esp_ble_addr_type_t peer_addr_type;
+            std::atomic<adv_phase_t> phase;
+            uint16_t interval;
+            Ticker t_phase;
+            std::atomic<uint8_t> pending_events;
+            Ticker t_event;
+
+            ServerCallbacks(BLEServer* server);
+
+            // Hand an event to the timer task
+            void post(adv_event_t event);
+
         public:
+            // Get the callbacks for a server, creating and registering them
+            // on first use
+            static ServerCallbacks* attach(BLEServer* server);
+
+            // Advertising schedule while disconnected
+            AdvertisingPolicy policy;
+
+            // Route connection events to a monitor
+            void set_monitor(Monitor* mon) { this->mon = mon; }
+
+            // Re-escalate to fast advertising unless connected or already
+            // advertising fast
+            void wake();
+
+            // Start advertising in the given phase
+            void advertise(adv_phase_t phase);
+
+            // Called when the phase timer expires
+            void timeout_phase();
+
+            // Called on the timer task to handle posted events
+            void run_events();
+
+            void onConnect(BLEServer* server, esp_ble_gatts_cb_param_t* param);
             void onDisconnect(BLEServer* server);
         };
 
@@ -176,5 +334,16 @@ namespace ESP32RaceChrono
             MonNotifyCallbacks(Monitor* mon) : mon(mon) {}
             void onWrite(BLECharacteristic* ch);
         };
+
+        // Config characteristic CCCD callbacks
+        class MonCccdCallbacks : public BLEDescriptorCallbacks
+        {
+        private:
+            Monitor* mon;
+
+        public:
+            MonCccdCallbacks(Monitor* mon) : mon(mon) {}
+            void onWrite(BLEDescriptor* desc);
+        };
     }
 }
@@ -0,0 +1,275 @@
+// Shift light on a WS2812 strip driven by RaceChrono monitor values
+
+// Imports
+#include "esp32_shift_light.hpp"
+
+ESP32RaceChrono::ShiftLight*
+    ESP32RaceChrono::ShiftLight::instances[RMT_CHANNEL_MAX] = {};
+
+// Configure the RMT channel and allocate items for a whole frame up front
+ESP32RaceChrono::ShiftLight::ShiftLight(uint8_t pin, uint16_t led_count,
+    rmt_channel_t channel)
+    : channel(channel)
+    , led_count(led_count)
+    , items(led_count * 24)
+    , mon(nullptr)
+    , eq_index(0)
+    , value(NAN)
+    , warning(false)
+    , flash_on(false)
+    , rendering(false)
+    , pending(false)
+    , flashing(false)
+    , arrival_us(0)
+    , sent_arrival_us(0)
+    , tx_end_us(0)
+    , last_latency(0)
+    , max_latency(0)
+{
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t) pin, channel);
+    config.clk_div = RMT_CLK_DIV;
+    rmt_config(&config);
+    rmt_driver_install(channel, 0, 0);
+
+    // One callback serves every channel, register it with the first strip
+    bool first = true;
+    for (auto instance : instances) { first &= instance == nullptr; }
+    instances[channel] = this;
+    if (first)
+    {
+        rmt_register_tx_end_callback(impl::rmt_tx_end_callback, nullptr);
+    }
+    render();
+}
+
+// Stop timers and release the channel
+ESP32RaceChrono::ShiftLight::~ShiftLight()
+{
+    t_retry.detach();
+    t_flash.detach();
+    rmt_wait_tx_done(channel, portMAX_DELAY);
+    instances[channel] = nullptr;
+    rmt_driver_uninstall(channel);
+}
+
+// Replace the pattern
+void ESP32RaceChrono::ShiftLight::set_pattern(const ShiftLightPattern& pattern)
+{
+    this->pattern = pattern;
+    render();
+}
+
+// Listen to one equation of the monitor
+void ESP32RaceChrono::ShiftLight::attach(Monitor* mon, size_t eq_index)
+{
+    this->mon = mon;
+    this->eq_index = eq_index;
+    mon->add_value_callback(impl::shift_light_value_callback, this);
+}
+
+// Show a value directly
+void ESP32RaceChrono::ShiftLight::show(float value)
+{
+    arrival_us = esp_timer_get_time();
+    this->value = value;
+    update_flashing(value);
+    render();
+}
+
+// Overlay the warning on the end LEDs
+void ESP32RaceChrono::ShiftLight::set_warning(bool active)
+{
+    if (warning.exchange(active) != active)
+    {
+        update_flashing(value);
+        render();
+    }
+}
+
+// A monitored value changed, show it right away if it is ours
+void ESP32RaceChrono::ShiftLight::value_changed(size_t index, float value,
+    int64_t arrival_us)
+{
+    if (index != eq_index)
+    {
+        return;
+    }
+    this->arrival_us = arrival_us;
+    this->value = value;
+    update_flashing(value);
+    render();
+}
+
+// Run the flash timer only while something flashes
+void ESP32RaceChrono::ShiftLight::update_flashing(float value)
+{
+    bool needed = warning || (!isnan(value) && value >= pattern.flash);
+    if (needed && !flashing)
+    {
+        flashing = true;
+        flash_on = true;
+        t_flash.attach_ms<ShiftLight*>(pattern.flash_period_ms,
+            impl::t_shift_light_flash_callback, this);
+    }
+    else if (!needed && flashing)
+    {
+        flashing = false;
+        t_flash.detach();
+    }
+}
+
+// Flash phase changed
+void ESP32RaceChrono::ShiftLight::toggle_flash()
+{
+    flash_on = !flash_on;
+    render();
+}
+
+// Color of one LED for a value
+uint32_t ESP32RaceChrono::ShiftLight::led_color(uint16_t led, float value)
+{
+    bool is_end = led == 0 || led == led_count - 1;
+    if (warning && is_end)
+    {
+        return flash_on ? pattern.warning_color : 0;
+    }
+    if (isnan(value) || value < pattern.start)
+    {
+        return 0;
+    }
+    if (value >= pattern.flash)
+    {
+        return flash_on ? pattern.flash_color : 0;
+    }
+
+    // LEDs light up evenly from start to shift
+    float step = led_count > 1
+        ? (pattern.shift - pattern.start) / (led_count - 1) : 0.0f;
+    if (value < pattern.start + step * led)
+    {
+        return 0;
+    }
+    if (!pattern.gradient)
+    {
+        if (led * 3 < led_count) { return pattern.low_color; }
+        if (led * 3 < led_count * 2) { return pattern.mid_color; }
+        return pattern.high_color;
+    }
+
+    // Blend low to mid over the first half of the strip, mid to high over
+    // the second half
+    uint32_t t = led_count > 1 ? led * 510 / (led_count - 1) : 0;
+    uint32_t from = t < 255 ? pattern.low_color : pattern.mid_color;
+    uint32_t to = t < 255 ? pattern.mid_color : pattern.high_color;
+    uint32_t w = t < 255 ? t : t - 255;
+    uint32_t color = 0;
+    for (int shift = 0; shift <= 16; shift += 8)
+    {
+        uint32_t a = (from >> shift) & 0xFF;
+        uint32_t b = (to >> shift) & 0xFF;
+        color |= ((a * (255 - w) + b * w) / 255) << shift;
+    }
+    return color;
+}
+
+// Encode one LED as GRB, most significant bit first
+void ESP32RaceChrono::ShiftLight::encode(rmt_item32_t* item, uint32_t color)
+{
+    uint32_t r = ((color >> 16) & 0xFF) * pattern.brightness / 255;
+    uint32_t g = ((color >> 8) & 0xFF) * pattern.brightness / 255;
+    uint32_t b = (color & 0xFF) * pattern.brightness / 255;
+    uint32_t grb = g << 16 | r << 8 | b;
+    for (int bit = 23; bit >= 0; bit--, item++)
+    {
+        bool one = (grb >> bit) & 1;
+        item->level0 = 1;
+        item->duration0 = one ? T1H_TICKS : T0H_TICKS;
+        item->level1 = 0;
+        item->duration1 = one ? T1L_TICKS : T0L_TICKS;
+    }
+}
+
+// Encode and send a frame without waiting for it to go out
+void ESP32RaceChrono::ShiftLight::render()
+{
+    HotPathScope hot_path(HOT_PATH_SHIFT_LIGHT);
+
+    // Whoever is encoding picks the change up, a change that lands just as
+    // it finishes gets another pass
+    pending = true;
+    while (pending && !rendering.exchange(true))
+    {
+        bool busy = false;
+        while (pending.exchange(false))
+        {
+            // Previous frame still going out or within the latch time, the
+            // retry timer sends the latest state
+            if (rmt_wait_tx_done(channel, 0) != ESP_OK ||
+                esp_timer_get_time() - tx_end_us < RESET_US)
+            {
+                pending = true;
+                busy = true;
+                t_retry.once_ms<ShiftLight*>(RETRY_MS,
+                    impl::t_shift_light_retry_callback, this);
+                break;
+            }
+            float v = value;
+            for (uint16_t led = 0; led < led_count; led++)
+            {
+                encode(&items[led * 24], led_color(led, v));
+            }
+            sent_arrival_us = arrival_us;
+            rmt_write_items(channel, items.data(), items.size(), false);
+        }
+        rendering = false;
+        if (busy)
+        {
+            return;
+        }
+    }
+}
+
+// Frame is on the strip, measure from the arrival of its value
+void ESP32RaceChrono::ShiftLight::tx_done()
+{
+    tx_end_us = esp_timer_get_time();
+    if (sent_arrival_us != 0)
+    {
+        last_latency = (uint32_t) (esp_timer_get_time() - sent_arrival_us);
+        if (last_latency > max_latency)
+        {
+            max_latency = last_latency;
+        }
+        sent_arrival_us = 0;
+    }
+}
+
+// Route monitor callbacks to the shift light
+void ESP32RaceChrono::impl::shift_light_value_callback(void* arg, size_t index,
+    float value, int64_t arrival_us)
+{
+    static_cast<ShiftLight*>(arg)->value_changed(index, value, arrival_us);
+}
+
+// Retry sending a frame
+void ESP32RaceChrono::impl::t_shift_light_retry_callback(ShiftLight* instance)
+{
+    instance->render();
+}
+
+// Toggle flash phase
+void ESP32RaceChrono::impl::t_shift_light_flash_callback(ShiftLight* instance)
+{
+    instance->toggle_flash();
+}
+
+// End of transmit interrupt for any RMT channel
+void ESP32RaceChrono::impl::rmt_tx_end_callback(
+    rmt_channel_t channel, void* arg)
+{
+    ShiftLight* instance = ShiftLight::instances[channel];
+    if (instance)
+    {
+        instance->tx_done();
+    }
+}
@@ -0,0 +1,138 @@
+// Shift light and warning LEDs on a WS2812 strip, driven by monitored values
+// through the ESP32 RMT peripheral
+
+#pragma once
+
+// Imports
+#include <atomic>
+#include <vector>
+#include <Arduino.h>
+#include <Ticker.h>
+#include <driver/rmt.h>
+#include "esp32_racechrono.hpp"
+
+// Namespace for RaceChrono connections via ESP32
+namespace ESP32RaceChrono
+{
+    // How a value maps to the strip. Colors are 0xRRGGBB. Below start every
+    // LED is off, from start to shift the LEDs light up one by one, and at
+    // flash and above the whole strip flashes
+    struct ShiftLightPattern
+    {
+        float start = 4000.0f;
+        float shift = 7000.0f;
+        float flash = 7200.0f;
+        uint32_t low_color = 0x00FF00;
+        uint32_t mid_color = 0xFFFF00;
+        uint32_t high_color = 0xFF0000;
+        uint32_t flash_color = 0x0000FF;
+        uint32_t warning_color = 0xFF0000;
+        bool gradient = false; // Blend colors along the strip, not in thirds
+        uint16_t flash_period_ms = 100;
+        uint8_t brightness = 64;
+    };
+
+    // Internal usage, forward declarations
+    class ShiftLight;
+    namespace impl
+    {
+        // C-style functions for monitor, timer and RMT callbacks
+        void shift_light_value_callback(void* arg, size_t index, float value,
+            int64_t arrival_us);
+        void t_shift_light_retry_callback(ShiftLight* instance);
+        void t_shift_light_flash_callback(ShiftLight* instance);
+        void rmt_tx_end_callback(rmt_channel_t channel, void* arg);
+    }
+
+    // Shift light on an addressable LED strip. Frames are encoded into RMT
+    // items and sent without waiting, so the caller is never blocked by the
+    // strip timing
+    class ShiftLight
+    {
+    private:
+        // WS2812 bit timing in 25 ns RMT ticks (80 MHz / 2)
+        static const uint8_t RMT_CLK_DIV = 2;
+        static const uint16_t T0H_TICKS = 16;
+        static const uint16_t T0L_TICKS = 34;
+        static const uint16_t T1H_TICKS = 32;
+        static const uint16_t T1L_TICKS = 18;
+        static const uint32_t RETRY_MS = 1;
+        static const int64_t RESET_US = 80; // Low time that latches a frame
+
+        // Instances by channel, for the shared RMT end of transmit callback
+        static ShiftLight* instances[RMT_CHANNEL_MAX];
+        friend void impl::rmt_tx_end_callback(rmt_channel_t channel,
+            void* arg);
+
+        rmt_channel_t channel;
+        uint16_t led_count;
+        std::vector<rmt_item32_t> items;
+        ShiftLightPattern pattern;
+
+        // Latest state to show, written from the BLE and timer tasks
+        Monitor* mon;
+        size_t eq_index;
+        std::atomic<float> value;
+        std::atomic<bool> warning;
+        std::atomic<bool> flash_on;
+        std::atomic<bool> rendering;
+        std::atomic<bool> pending;
+        Ticker t_retry;
+        Ticker t_flash;
+        bool flashing;
+
+        // Value arrival to end of LED transmission
+        int64_t arrival_us;
+        int64_t sent_arrival_us;
+        volatile int64_t tx_end_us;
+        volatile uint32_t last_latency;
+        volatile uint32_t max_latency;
+
+        // Color of one LED for the current value, 0xRRGGBB
+        uint32_t led_color(uint16_t led, float value);
+
+        // Encode one LED, GRB order, into 24 items
+        void encode(rmt_item32_t* item, uint32_t color);
+
+        // Start or stop the flash timer when the state needs it
+        void update_flashing(float value);
+
+    public:
+        // Constructor
+        ShiftLight(uint8_t pin, uint16_t led_count,
+            rmt_channel_t channel=RMT_CHANNEL_0);
+
+        // Destructor
+        ~ShiftLight();
+
+        // Replace the pattern, shown from the next frame
+        void set_pattern(const ShiftLightPattern& pattern);
+
+        // Follow an equation of the monitor, the strip is updated from the
+        // BLE task as soon as the value arrives
+        void attach(Monitor* mon, size_t eq_index);
+
+        // Show a value, e.g. one not coming from the monitor
+        void show(float value);
+
+        // Blink the first and last LED in the warning color
+        void set_warning(bool active);
+
+        // Microseconds from value arrival to the end of the LED frame
+        uint32_t last_latency_us() { return last_latency; }
+        uint32_t max_latency_us() { return max_latency; }
+
+        // Encode and send the latest state, or retry shortly if the previous
+        // frame is still going out. Public for callback access
+        void render();
+
+        // Called for monitored values, public for callback access
+        void value_changed(size_t index, float value, int64_t arrival_us);
+
+        // Called when the flash timer expires, public for callback access
+        void toggle_flash();
+
+        // Called from the RMT interrupt, public for callback access
+        void tx_done();
+    };
+}
@@ -0,0 +1,419 @@
+// Wire formats of every RaceChrono DIY BLE characteristic, shared by the
+// ESP32 library and the nRF52 examples. Header only, allocation free and
+// without Arduino dependencies, so it also builds for host tests. Each sketch
+// folder holds a copy, edit this one and copy it over, ctest fails until the
+// copies match.
+
+#pragma once
+
+// Imports
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Namespace for the RaceChrono DIY API wire formats
+namespace RaceChronoProtocol
+{
+    // 16-bit UUIDs of the service and its characteristics
+    const uint16_t SERVICE_UUID = 0x1FF8;
+    const uint16_t CAN_MAIN_UUID = 0x0001;
+    const uint16_t CAN_FILTER_UUID = 0x0002;
+    const uint16_t GPS_MAIN_UUID = 0x0003;
+    const uint16_t GPS_TIME_UUID = 0x0004;
+    const uint16_t MONITOR_CONFIG_UUID = 0x0005;
+    const uint16_t MONITOR_NOTIFY_UUID = 0x0006;
+
+    // Byte order helpers, everything but the CAN packet id is big-endian
+    constexpr uint16_t read_be16(const uint8_t* p)
+    {
+        return (uint16_t) (p[0] << 8 | p[1]);
+    }
+
+    constexpr uint32_t read_be32(const uint8_t* p)
+    {
+        return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 |
+            (uint32_t) p[2] << 8 | p[3];
+    }
+
+    constexpr uint32_t read_le32(const uint8_t* p)
+    {
+        return (uint32_t) p[3] << 24 | (uint32_t) p[2] << 16 |
+            (uint32_t) p[1] << 8 | p[0];
+    }
+
+    inline void write_be16(uint8_t* p, uint16_t value)
+    {
+        p[0] = value >> 8;
+        p[1] = value;
+    }
+
+    inline void write_be32(uint8_t* p, uint32_t value)
+    {
+        p[0] = value >> 24;
+        p[1] = value >> 16;
+        p[2] = value >> 8;
+        p[3] = value;
+    }
+
+    inline void write_le32(uint8_t* p, uint32_t value)
+    {
+        p[0] = value;
+        p[1] = value >> 8;
+        p[2] = value >> 16;
+        p[3] = value >> 24;
+    }
+
+    // CAN main (0x0001): 32-bit packet id, little-endian, then the payload,
+    // longer payloads than fit a 20 byte notification are cut
+    const uint8_t CAN_HEADER_LEN = 4;
+    const uint8_t CAN_PAYLOAD_MAX = 16;
+    const uint8_t CAN_FRAME_MAX = CAN_HEADER_LEN + CAN_PAYLOAD_MAX;
+
+    // Encoded length of a CAN frame
+    constexpr uint8_t can_frame_len(size_t payload_len)
+    {
+        return CAN_HEADER_LEN +
+            (payload_len < CAN_PAYLOAD_MAX ? payload_len : CAN_PAYLOAD_MAX);
+    }
+
+    // Write a CAN frame into out (CAN_FRAME_MAX long), returns its length
+    inline uint8_t encode_can_frame(uint8_t* out, uint32_t packet_id,
+        const uint8_t* payload, size_t payload_len)
+    {
+        uint8_t len = can_frame_len(payload_len);
+        write_le32(out, packet_id);
+        memcpy(out + CAN_HEADER_LEN, payload, len - CAN_HEADER_LEN);
+        return len;
+    }
+
+    // Read a CAN frame, the payload points into data. Returns false if it
+    // is too short.
+    inline bool decode_can_frame(const uint8_t* data, size_t len,
+        uint32_t& packet_id, const uint8_t*& payload, uint8_t& payload_len)
+    {
+        if (len < CAN_HEADER_LEN || len > CAN_FRAME_MAX) { return false; }
+        packet_id = read_le32(data);
+        payload = data + CAN_HEADER_LEN;
+        payload_len = len - CAN_HEADER_LEN;
+        return true;
+    }
+
+    // CAN filter (0x0002), written by the app
+    enum can_filter_cmd_t : uint8_t
+    {
+        CAN_FILTER_DENY_ALL = 0,  // cmd
+        CAN_FILTER_ALLOW_ALL = 1, // cmd, interval_ms (16)
+        CAN_FILTER_ADD_PID = 2    // cmd, interval_ms (16), packet_id (32)
+    };
+
+    struct CanFilterCommand
+    {
+        can_filter_cmd_t cmd;
+        uint16_t interval_ms;
+        uint32_t packet_id;
+    };
+
+    const uint8_t CAN_FILTER_MAX = 7;
+
+    // Encoded length of a filter command, 0 for unknown commands
+    constexpr uint8_t can_filter_len(uint8_t cmd)
+    {
+        return cmd == CAN_FILTER_DENY_ALL ? 1 :
+            cmd == CAN_FILTER_ALLOW_ALL ? 3 :
+            cmd == CAN_FILTER_ADD_PID ? 7 : 0;
+    }
+
+    // Write a filter command into out (CAN_FILTER_MAX long), returns its
+    // length
+    inline uint8_t encode_can_filter(uint8_t* out, const CanFilterCommand& command)
+    {
+        out[0] = command.cmd;
+        write_be16(out + 1, command.interval_ms);
+        write_be32(out + 3, command.packet_id);
+        return can_filter_len(command.cmd);
+    }
+
+    // Read a filter command, returns false for unknown commands and wrong
+    // lengths
+    inline bool decode_can_filter(const uint8_t* data, size_t len,
+        CanFilterCommand& command)
+    {
+        if (len < 1 || can_filter_len(data[0]) != len) { return false; }
+        command.cmd = (can_filter_cmd_t) data[0];
+        command.interval_ms = len >= 3 ? read_be16(data + 1) : 0;
+        command.packet_id = len >= 7 ? read_be32(data + 3) : 0;
+        return true;
+    }
+
+    // GPS main (0x0003), 20 bytes:
+    //   sync bits (3) and time since the hour in 2 ms units (21)
+    //   fix quality (2) and satellites (6)
+    //   latitude and longitude in 1e-7 degrees (32 each)
+    //   altitude, 0.1 m above -500 m, or 1 m with the top bit set (16)
+    //   speed, 0.01 units, or 0.1 units with the top bit set (16)
+    //   bearing in 0.01 degrees (16), HDOP and VDOP in 0.1 (8 each)
+    const uint8_t GPS_MAIN_LEN = 20;
+    const uint8_t GPS_TIME_LEN = 3;
+    const uint8_t GPS_DOP_UNKNOWN = 0xFF;
+
+    struct GpsFix
+    {
+        uint8_t sync_bits;
+        uint32_t time_since_hour;
+        uint8_t fix_quality;
+        uint8_t satellites;
+        int32_t latitude;
+        int32_t longitude;
+        uint16_t altitude;
+        uint16_t speed;
+        uint16_t bearing;
+        uint8_t hdop;
+        uint8_t vdop;
+    };
+
+    // Round a non-negative value, negative values become 0
+    constexpr uint32_t round_positive(float value)
+    {
+        return value > 0.0f ? (uint32_t) (value + 0.5f) : 0;
+    }
+
+    // Encode an altitude in meters
+    constexpr uint16_t gps_altitude(float meters)
+    {
+        return meters > 6000.0f ?
+            (uint16_t) ((round_positive(meters + 500.0f) & 0x7FFF) | 0x8000) :
+            (uint16_t) (round_positive((meters + 500.0f) * 10.0f) & 0x7FFF);
+    }
+
+    // Encode a speed
+    constexpr uint16_t gps_speed(float speed)
+    {
+        return speed > 600.0f ?
+            (uint16_t) ((round_positive(speed * 10.0f) & 0x7FFF) | 0x8000) :
+            (uint16_t) (round_positive(speed * 100.0f) & 0x7FFF);
+    }
+
+    // Encode the time since the start of the hour
+    constexpr uint32_t gps_time_since_hour(uint8_t minute, uint8_t seconds,
+        uint16_t milliseconds)
+    {
+        return minute * 30000UL + seconds * 500UL + milliseconds / 2;
+    }
+
+    // Encode the date and hour of the GPS time characteristic, year since 2000
+    constexpr uint32_t gps_date_and_hour(uint8_t year, uint8_t month,
+        uint8_t day, uint8_t hour)
+    {
+        return year * 8928UL + (month - 1) * 744UL + (day - 1) * 24UL + hour;
+    }
+
+    // Write a GPS fix into out (GPS_MAIN_LEN long), returns its length
+    inline uint8_t encode_gps_main(uint8_t* out, const GpsFix& fix)
+    {
+        out[0] = (fix.sync_bits & 0x7) << 5 | ((fix.time_since_hour >> 16) & 0x1F);
+        out[1] = fix.time_since_hour >> 8;
+        out[2] = fix.time_since_hour;
+        out[3] = (fix.fix_quality < 3 ? fix.fix_quality : 3) << 6 |
+            (fix.satellites < 0x3F ? fix.satellites : 0x3F);
+        write_be32(out + 4, fix.latitude);
+        write_be32(out + 8, fix.longitude);
+        write_be16(out + 12, fix.altitude);
+        write_be16(out + 14, fix.speed);
+        write_be16(out + 16, fix.bearing);
+        out[18] = fix.hdop;
+        out[19] = fix.vdop;
+        return GPS_MAIN_LEN;
+    }
+
+    // Read a GPS fix, returns false if the length is wrong
+    inline bool decode_gps_main(const uint8_t* data, size_t len, GpsFix& fix)
+    {
+        if (len != GPS_MAIN_LEN) { return false; }
+        fix.sync_bits = data[0] >> 5;
+        fix.time_since_hour = (uint32_t) (data[0] & 0x1F) << 16 |
+            read_be16(data + 1);
+        fix.fix_quality = data[3] >> 6;
+        fix.satellites = data[3] & 0x3F;
+        fix.latitude = (int32_t) read_be32(data + 4);
+        fix.longitude = (int32_t) read_be32(data + 8);
+        fix.altitude = read_be16(data + 12);
+        fix.speed = read_be16(data + 14);
+        fix.bearing = read_be16(data + 16);
+        fix.hdop = data[18];
+        fix.vdop = data[19];
+        return true;
+    }
+
+    // Write the GPS time (0x0004) into out (GPS_TIME_LEN long): sync bits
+    // (3) and date and hour (21). Returns its length.
+    inline uint8_t encode_gps_time(uint8_t* out, uint8_t sync_bits,
+        uint32_t date_and_hour)
+    {
+        out[0] = (sync_bits & 0x7) << 5 | ((date_and_hour >> 16) & 0x1F);
+        out[1] = date_and_hour >> 8;
+        out[2] = date_and_hour;
+        return GPS_TIME_LEN;
+    }
+
+    // Read the GPS time, returns false if the length is wrong
+    inline bool decode_gps_time(const uint8_t* data, size_t len,
+        uint8_t& sync_bits, uint32_t& date_and_hour)
+    {
+        if (len != GPS_TIME_LEN) { return false; }
+        sync_bits = data[0] >> 5;
+        date_and_hour = (uint32_t) (data[0] & 0x1F) << 16 | read_be16(data + 1);
+        return true;
+    }
+
+    // Monitor config (0x0005), commands indicated by the device: command,
+    // monitor id, chunk sequence number, then a part of the equation for
+    // adds. Commands for all monitors are the command byte alone.
+    enum monitor_cmd_t : uint8_t
+    {
+        MONITOR_REMOVE_ALL = 0,
+        MONITOR_REMOVE = 1,
+        MONITOR_ADD_INCOMPLETE = 2,
+        MONITOR_ADD = 3,
+        MONITOR_UPDATE_ALL = 4,
+        MONITOR_UPDATE = 5
+    };
+
+    const uint8_t CONFIG_HEADER_LEN = 3;
+    const uint8_t CONFIG_PART_MAX = 17;
+    const uint8_t CONFIG_CHUNK_MAX = CONFIG_HEADER_LEN + CONFIG_PART_MAX;
+
+    // Whether a command carries an equation
+    constexpr bool is_add(uint8_t cmd)
+    {
+        return cmd == MONITOR_ADD || cmd == MONITOR_ADD_INCOMPLETE;
+    }
+
+    // Whether a command is about a single monitor
+    constexpr bool has_monitor_id(uint8_t cmd)
+    {
+        return cmd != MONITOR_REMOVE_ALL && cmd != MONITOR_UPDATE_ALL;
+    }
+
+    // Number of indications needed for a command, an empty add still takes one
+    constexpr size_t config_chunk_count(uint8_t cmd, size_t equation_len)
+    {
+        return !is_add(cmd) || equation_len == 0 ? 1 :
+            (equation_len + CONFIG_PART_MAX - 1) / CONFIG_PART_MAX;
+    }
+
+    // Length of one chunk of a command
+    constexpr uint8_t config_chunk_len(uint8_t cmd, size_t equation_len,
+        size_t chunk)
+    {
+        return !has_monitor_id(cmd) ? 1 : CONFIG_HEADER_LEN + (!is_add(cmd) ||
+            chunk * CONFIG_PART_MAX >= equation_len ? 0 :
+            equation_len - chunk * CONFIG_PART_MAX < CONFIG_PART_MAX ?
+            equation_len - chunk * CONFIG_PART_MAX : CONFIG_PART_MAX);
+    }
+
+    // Write one chunk of a command into out (CONFIG_CHUNK_MAX long), returns
+    // its length. Every chunk but the last of an add is sent as
+    // MONITOR_ADD_INCOMPLETE, the equation is sliced in place.
+    inline uint8_t encode_config_chunk(uint8_t* out, uint8_t cmd,
+        uint8_t monitor_id, const char* equation, size_t equation_len,
+        size_t chunk)
+    {
+        uint8_t len = config_chunk_len(cmd, equation_len, chunk);
+        if (is_add(cmd))
+        {
+            memcpy(out + CONFIG_HEADER_LEN,
+                equation + chunk * CONFIG_PART_MAX, len - CONFIG_HEADER_LEN);
+            cmd = chunk + 1 >= config_chunk_count(cmd, equation_len) ?
+                MONITOR_ADD : MONITOR_ADD_INCOMPLETE;
+        }
+        out[0] = cmd;
+        if (len > 1)
+        {
+            out[1] = monitor_id;
+            out[2] = chunk;
+        }
+        return len;
+    }
+
+    // Read a config chunk, the equation part points into data. Monitor id
+    // and chunk are 0 for commands about all monitors. Returns false if it
+    // is too short or too long.
+    inline bool decode_config_chunk(const uint8_t* data, size_t len,
+        uint8_t& cmd, uint8_t& monitor_id, uint8_t& chunk,
+        const char*& part, uint8_t& part_len)
+    {
+        if (len < 1 || len > CONFIG_CHUNK_MAX ||
+            (len < CONFIG_HEADER_LEN && has_monitor_id(data[0])))
+        {
+            return false;
+        }
+        cmd = data[0];
+        monitor_id = len > 1 ? data[1] : 0;
+        chunk = len > 2 ? data[2] : 0;
+        // A chunk without an equation leaves part at its end, never past it
+        size_t part_offset = len > CONFIG_HEADER_LEN ? CONFIG_HEADER_LEN : len;
+        part = (const char*) data + part_offset;
+        part_len = len - part_offset;
+        return true;
+    }
+
+    // Monitor config results, written by the app: result, monitor id, then
+    // the equation exception type for MONITOR_RESULT_EQUATION_EXCEPTION
+    enum monitor_result_t : uint8_t
+    {
+        MONITOR_RESULT_OK = 0,
+        MONITOR_RESULT_OUT_OF_SEQUENCE = 1,
+        MONITOR_RESULT_EQUATION_EXCEPTION = 2
+    };
+
+    struct ConfigResult
+    {
+        uint8_t result;
+        uint8_t monitor_id;
+        uint16_t exception_type;
+    };
+
+    // Read a config result, returns false if it is too short
+    inline bool decode_config_result(const uint8_t* data, size_t len,
+        ConfigResult& result)
+    {
+        if (len < 2) { return false; }
+        result.result = data[0];
+        result.monitor_id = data[1];
+        result.exception_type = len >= 4 ? read_be16(data + 2) : 0;
+        return true;
+    }
+
+    // Monitor notify (0x0006), written by the app: any number of monitor id
+    // (8) and raw value (32 signed) pairs, trailing partial pairs are ignored
+    const uint8_t MONITOR_VALUE_LEN = 5;
+
+    // Number of values in a notification
+    constexpr size_t monitor_value_count(size_t len)
+    {
+        return len / MONITOR_VALUE_LEN;
+    }
+
+    // Monitor id of a value
+    constexpr uint8_t monitor_value_id(const uint8_t* data, size_t index)
+    {
+        return data[index * MONITOR_VALUE_LEN];
+    }
+
+    // Raw value of a value
+    constexpr int32_t monitor_value_raw(const uint8_t* data, size_t index)
+    {
+        return (int32_t) read_be32(data + index * MONITOR_VALUE_LEN + 1);
+    }
+
+    // Write one value at index into a notification, returns the length up
+    // to and including it
+    inline size_t encode_monitor_value(uint8_t* out, size_t index,
+        uint8_t monitor_id, int32_t raw)
+    {
+        uint8_t* p = out + index * MONITOR_VALUE_LEN;
+        p[0] = monitor_id;
+        write_be32(p + 1, (uint32_t) raw);
+        return (index + 1) * MONITOR_VALUE_LEN;
+    }
+}
@@ -0,0 +1,117 @@
+// Host tests for the GPS device's weighted max-min airtime planner, frames
+// fed on virtual time
+
+#include <gtest/gtest.h>
+#include <host_clock.hpp>
+#include "../examples/canbus-gps-device/main/AirtimePlanner.h"
+
+class AirtimePlannerTest : public ::testing::Test
+{
+protected:
+    PacketIdInfo info;
+    AirtimePlanner* planner = nullptr;
+
+    void SetUp() override
+    {
+        host_clock::use_virtual_time(1000000);
+        planner = new AirtimePlanner(&info);
+    }
+
+    void TearDown() override
+    {
+        delete planner;
+        host_clock::use_real_time();
+    }
+
+    // Receive each id at its rate for one plan period, then plan
+    void feed(const uint32_t* packetIds, const uint16_t* ratesPerSecond, size_t count)
+    {
+        for (uint32_t ms = 0; ms < 2000; ms++)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                if (ms * ratesPerSecond[i] / 1000 != (ms + 1) * ratesPerSecond[i] / 1000)
+                {
+                    info.findItem(packetIds[i], true)->markReceived();
+                }
+            }
+            host_clock::advance_ms(1);
+        }
+        planner->plan();
+    }
+
+    uint16_t interval(uint32_t packetId)
+    {
+        return info.findItem(packetId, false)->getNotifyInterval();
+    }
+};
+
+TEST_F(AirtimePlannerTest, LinkWithRoomLeavesDefaultsAlone)
+{
+    // 3 notifications every 15 ms with 20 % headroom, 160/s
+    planner->setLinkCapacity(15, 3);
+    EXPECT_FLOAT_EQ(160.f, planner->getCapacityPerSecond());
+    info.setDefaultNotifyInterval(5);
+    const uint32_t ids[] = { 0x100, 0x200 };
+    const uint16_t rates[] = { 50, 50 };
+    feed(ids, rates, 2);
+    EXPECT_FLOAT_EQ(100.f, planner->getDemandPerSecond());
+    EXPECT_EQ(0.f, planner->getShareRate());
+    EXPECT_EQ(5, interval(0x100));
+    EXPECT_EQ(5, interval(0x200));
+}
+
+TEST_F(AirtimePlannerTest, SaturatedLinkIsSharedByWeight)
+{
+    planner->setLinkCapacity(15, 3);
+    planner->setPriority(0x100, 2);
+    const uint32_t ids[] = { 0x100, 0x200, 0x300 };
+    const uint16_t rates[] = { 200, 200, 10 };
+    feed(ids, rates, 3);
+
+    // The slow id keeps its full rate, the other two split the remaining
+    // 150/s two to one
+    EXPECT_FLOAT_EQ(410.f, planner->getDemandPerSecond());
+    EXPECT_FLOAT_EQ(50.f, planner->getShareRate());
+    EXPECT_EQ(10, interval(0x100));
+    EXPECT_EQ(20, interval(0x200));
+    EXPECT_EQ(0, interval(0x300));
+}
+
+TEST_F(AirtimePlannerTest, RequestedIntervalsAreNotChanged)
+{
+    planner->setLinkCapacity(15, 3);
+    info.setNotifyInterval(0x100, 25);
+    const uint32_t ids[] = { 0x100, 0x200, 0x300 };
+    const uint16_t rates[] = { 100, 100, 100 };
+    feed(ids, rates, 3);
+
+    // The app's id takes its 40/s off the top, the others share 120/s
+    EXPECT_EQ(25, interval(0x100));
+    EXPECT_TRUE(info.findItem(0x100, false)->isExplicit());
+    EXPECT_FLOAT_EQ(60.f, planner->getShareRate());
+    EXPECT_EQ(17, interval(0x200));
+    EXPECT_EQ(17, interval(0x300));
+}
+
+TEST_F(AirtimePlannerTest, ConnectionIntervalChangeReplans)
+{
+    planner->setLinkCapacity(15, 3);
+    const uint32_t ids[] = { 0x100, 0x200 };
+    const uint16_t rates[] = { 100, 100 };
+    feed(ids, rates, 2);
+    EXPECT_EQ(13, interval(0x100));
+
+    // The central slows the link down, intervals follow right away with the
+    // rates already measured
+    planner->setLinkCapacity(30, 3);
+    EXPECT_FLOAT_EQ(80.f, planner->getCapacityPerSecond());
+    EXPECT_FLOAT_EQ(40.f, planner->getShareRate());
+    EXPECT_EQ(25, interval(0x100));
+    EXPECT_EQ(25, interval(0x200));
+
+    // And back up, nothing is throttled once the link has room
+    planner->setLinkCapacity(7, 6);
+    EXPECT_EQ(0.f, planner->getShareRate());
+    EXPECT_EQ(0, interval(0x100));
+}
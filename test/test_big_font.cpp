@@ -0,0 +1,79 @@
+// Host tests for the remote display's run-length coded big digit font
+
+#include <stdint.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../examples/remote-display-device/main/BigFont.h"
+
+static const uint16_t COLOR = 0xFFFF;
+static const uint16_t BACKGROUND = 0x0001;
+static const char CHARACTERS[] = " -.0123456789:";
+
+TEST(BigFont, HasEveryCharacterAValueUses)
+{
+    EXPECT_EQ(24, getBigFontWidth());
+    EXPECT_EQ(40, getBigFontHeight());
+    for (const char* c = CHARACTERS; *c; c++)
+    {
+        const BigGlyph* glyph = getBigGlyph(*c);
+        ASSERT_NE(nullptr, glyph) << *c;
+        EXPECT_EQ(*c, glyph->c);
+    }
+    EXPECT_EQ(nullptr, getBigGlyph('A'));
+    EXPECT_EQ(nullptr, getBigGlyph('\0'));
+}
+
+TEST(BigFont, RunsCoverTheGlyphExactly)
+{
+    for (const char* c = CHARACTERS; *c; c++)
+    {
+        const BigGlyph* glyph = getBigGlyph(*c);
+        const uint8_t* runs = getBigGlyphRuns(glyph);
+        uint32_t pixels = 0;
+        for (uint16_t i = 0; i < glyph->length; i++)
+        {
+            pixels += runs[i];
+        }
+        EXPECT_EQ((uint32_t)getBigFontWidth() * getBigFontHeight(), pixels) << *c;
+    }
+}
+
+TEST(BigFont, DecodesForegroundOnlyWhereRunsSayAndNeverPastTheEnd)
+{
+    uint32_t size = getBigFontWidth() * getBigFontHeight();
+    std::vector<uint16_t> pixels(size + 1, 0x1234);
+    decodeBigGlyph(getBigGlyph(' '), pixels.data(), COLOR, BACKGROUND);
+    for (uint32_t i = 0; i < size; i++)
+    {
+        ASSERT_EQ(BACKGROUND, pixels[i]) << i;
+    }
+    EXPECT_EQ(0x1234, pixels[size]);
+
+    // An 8 lights more pixels than a 1, both start on the background
+    uint32_t lit[2] = {0, 0};
+    const char digits[] = "18";
+    for (int d = 0; d < 2; d++)
+    {
+        decodeBigGlyph(getBigGlyph(digits[d]), pixels.data(), COLOR, BACKGROUND);
+        EXPECT_EQ(BACKGROUND, pixels[0]);
+        for (uint32_t i = 0; i < size; i++)
+        {
+            ASSERT_TRUE(pixels[i] == COLOR || pixels[i] == BACKGROUND) << i;
+            lit[d] += pixels[i] == COLOR;
+        }
+        EXPECT_EQ(0x1234, pixels[size]);
+    }
+    EXPECT_GT(lit[0], 0u);
+    EXPECT_GT(lit[1], lit[0]);
+}
+
+TEST(BigFont, MissingGlyphDecodesBlank)
+{
+    uint32_t size = getBigFontWidth() * getBigFontHeight();
+    std::vector<uint16_t> pixels(size, COLOR);
+    decodeBigGlyph(nullptr, pixels.data(), COLOR, BACKGROUND);
+    for (uint32_t i = 0; i < size; i++)
+    {
+        ASSERT_EQ(BACKGROUND, pixels[i]) << i;
+    }
+}
@@ -0,0 +1,83 @@
+// Host tests for the remote display's monitor config chunking
+
+#include <string>
+#include <gtest/gtest.h>
+#include "../examples/remote-display-device/main/ConfigCommand.h"
+
+// Reassemble an equation from its chunks, checking the header of each one
+static std::string reassemble(const std::string& equation, int monitorId)
+{
+    std::string out;
+    int count = getConfigChunkCount(CMD_TYPE_ADD, equation.size());
+    for (int chunk = 0; chunk < count; chunk++)
+    {
+        uint8_t bytes[CONFIG_CHUNK_MAX];
+        uint8_t len = buildConfigChunk(bytes, CMD_TYPE_ADD, monitorId,
+            equation.c_str(), equation.size(), chunk);
+        EXPECT_LE(len, CONFIG_CHUNK_MAX);
+        EXPECT_EQ(bytes[0], chunk + 1 == count ?
+            CMD_TYPE_ADD : CMD_TYPE_ADD_INCOMPLETE);
+        EXPECT_EQ(bytes[1], monitorId);
+        EXPECT_EQ(bytes[2], chunk);
+        out.append(reinterpret_cast<char*>(bytes + CONFIG_HEADER_LEN),
+            len - CONFIG_HEADER_LEN);
+    }
+    return out;
+}
+
+TEST(ConfigCommand, ShortEquationIsOneCompleteChunk)
+{
+    std::string equation = "speed*10.0";
+    ASSERT_EQ(getConfigChunkCount(CMD_TYPE_ADD, equation.size()), 1);
+    EXPECT_EQ(reassemble(equation, 3), equation);
+}
+
+TEST(ConfigCommand, ExactMultipleHasNoEmptyTail)
+{
+    std::string equation(CONFIG_PAYLOAD_PART_MAX * 4, 'x');
+    EXPECT_EQ(getConfigChunkCount(CMD_TYPE_ADD, equation.size()), 4);
+    EXPECT_EQ(reassemble(equation, 1), equation);
+}
+
+TEST(ConfigCommand, LongEquationsRoundTrip)
+{
+    for (size_t len : { 1, 16, 17, 18, 250, 512, 777 })
+    {
+        std::string equation;
+        for (size_t i = 0; i < len; i++)
+        {
+            equation += static_cast<char>('a' + i % 26);
+        }
+        EXPECT_EQ(reassemble(equation, 7), equation) << len;
+    }
+}
+
+TEST(ConfigCommand, ResumeProducesSameChunk)
+{
+    // A retry of chunk n must be identical to the first attempt
+    std::string equation(400, 'q');
+    equation[17 * 5] = '!';
+    uint8_t first[CONFIG_CHUNK_MAX];
+    uint8_t retry[CONFIG_CHUNK_MAX];
+    uint8_t len = buildConfigChunk(first, CMD_TYPE_ADD, 2, equation.c_str(),
+        equation.size(), 5);
+    ASSERT_EQ(buildConfigChunk(retry, CMD_TYPE_ADD, 2, equation.c_str(),
+        equation.size(), 5), len);
+    EXPECT_EQ(memcmp(first, retry, len), 0);
+    EXPECT_EQ(first[CONFIG_HEADER_LEN], '!');
+}
+
+TEST(ConfigCommand, EmptyAndNonAddCommands)
+{
+    uint8_t bytes[CONFIG_CHUNK_MAX];
+    EXPECT_EQ(getConfigChunkCount(CMD_TYPE_ADD, 0), 1);
+    EXPECT_EQ(buildConfigChunk(bytes, CMD_TYPE_ADD, 0, "", 0, 0),
+        CONFIG_HEADER_LEN);
+    EXPECT_EQ(bytes[0], CMD_TYPE_ADD);
+
+    EXPECT_EQ(getConfigChunkCount(CMD_TYPE_REMOVE, 0), 1);
+    EXPECT_EQ(buildConfigChunk(bytes, CMD_TYPE_REMOVE, 9, nullptr, 0, 0),
+        CONFIG_HEADER_LEN);
+    EXPECT_EQ(bytes[0], CMD_TYPE_REMOVE);
+    EXPECT_EQ(bytes[1], 9);
+}
@@ -0,0 +1,128 @@
+// Host tests for the memory report and the hot path allocation counting,
+// built with -DRACECHRONO_MEMORY_STATS
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <host_ble.hpp>
+#include "../lib/esp32_racechrono.hpp"
+
+using namespace ESP32RaceChrono;
+
+// Keeps allocations observable, the compiler may drop a new and delete pair
+static int* volatile sink;
+
+// Collects printed text
+class StringPrint : public Print
+{
+public:
+    std::string text;
+
+    size_t write(uint8_t c) override
+    {
+        text.push_back((char)c);
+        return 1;
+    }
+};
+
+class Esp32MemoryStatsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        MemoryStats::set_alloc_trap(false);
+        MemoryStats::reset_hot_paths();
+    }
+};
+
+TEST_F(Esp32MemoryStatsTest, CountsAllocationsOfTheInnermostHotPath)
+{
+    sink = new int(1);
+    delete sink;
+    {
+        HotPathScope can(HOT_PATH_CAN_UPDATE);
+        {
+            HotPathScope light(HOT_PATH_SHIFT_LIGHT);
+            std::vector<int> values(16);
+            sink = values.data();
+        }
+        sink = new int(2);
+        delete sink;
+    }
+    EXPECT_EQ(1u, MemoryStats::hot_path_runs(HOT_PATH_CAN_UPDATE));
+    EXPECT_EQ(1u, MemoryStats::hot_path_allocations(HOT_PATH_CAN_UPDATE));
+    EXPECT_EQ(1u, MemoryStats::hot_path_runs(HOT_PATH_SHIFT_LIGHT));
+    EXPECT_EQ(1u, MemoryStats::hot_path_allocations(HOT_PATH_SHIFT_LIGHT));
+    EXPECT_EQ(0u, MemoryStats::hot_path_runs(HOT_PATH_MONITOR_NOTIFY));
+}
+
+TEST_F(Esp32MemoryStatsTest, MonitorAndCanPathsDoNotAllocate)
+{
+    BLEServer* server = BLEDevice::createServer();
+    Monitor mon(server);
+    CANSpoof can(server);
+    mon.add("channel(device(gps), speed)*3.6");
+    mon.add("channel(device(obd), rpm)");
+    mon.add("channel(device(gps), bearing)");
+    BLECharacteristic* config_ch = host_ble::find_characteristic(server, 0x0005);
+    BLECharacteristic* notify_ch = host_ble::find_characteristic(server, 0x0006);
+    host_ble::connect(server);
+    host_ble::subscribe(config_ch);
+    for (uint8_t id = 0; id < 3; id++)
+    {
+        const uint8_t ok[] = { 0, id };
+        host_ble::write(config_ch, ok, sizeof(ok));
+    }
+
+    // Any allocation from here on aborts the test
+    MemoryStats::reset_hot_paths();
+    MemoryStats::set_alloc_trap(true);
+    for (int i = 0; i < 100; i++)
+    {
+        uint8_t values[3 * RaceChronoProtocol::MONITOR_VALUE_LEN];
+        for (uint8_t id = 0; id < 3; id++)
+        {
+            RaceChronoProtocol::encode_monitor_value(values, id, id, i * 100 + id);
+        }
+        host_ble::write(notify_ch, values, sizeof(values));
+        can.update(0x700 + i % 4, (uint8_t)i);
+    }
+    MemoryStats::set_alloc_trap(false);
+    EXPECT_EQ(100u, MemoryStats::hot_path_runs(HOT_PATH_MONITOR_NOTIFY));
+    EXPECT_EQ(0u, MemoryStats::hot_path_allocations(HOT_PATH_MONITOR_NOTIFY));
+    EXPECT_EQ(100u, MemoryStats::hot_path_runs(HOT_PATH_CAN_UPDATE));
+    EXPECT_EQ(0u, MemoryStats::hot_path_allocations(HOT_PATH_CAN_UPDATE));
+    EXPECT_FLOAT_EQ(9901.0f, mon.eqs[1].value);
+}
+
+TEST_F(Esp32MemoryStatsTest, TrapAbortsOnHotPathAllocation)
+{
+    EXPECT_DEATH(
+        {
+            MemoryStats::set_alloc_trap(true);
+            HotPathScope hot_path(HOT_PATH_MONITOR_NOTIFY);
+            sink = new int(3);
+        }, "");
+}
+
+TEST_F(Esp32MemoryStatsTest, ReportsHeapAndStacks)
+{
+    host_heap::set(200000, 150000, 50000);
+    MemoryStats stats;
+    ASSERT_TRUE(stats.watch_task());
+    ASSERT_TRUE(stats.watch_task());
+    EXPECT_EQ(1u, stats.watched_tasks());
+    host_task::set_stack_high_water(xTaskGetCurrentTaskHandle(), 1234);
+
+    HeapStats heap = stats.heap();
+    EXPECT_EQ(150000u, heap.min_free_bytes);
+    EXPECT_EQ(75, heap.fragmentation_percent());
+    EXPECT_EQ(1234u, stats.stack_high_water(0));
+
+    StringPrint out;
+    stats.print(out);
+    EXPECT_NE(std::string::npos, out.text.find(
+        "heap free 200000 min 150000 largest 50000 fragmentation 75%\n"));
+    EXPECT_NE(std::string::npos, out.text.find("stack loopTask unused 1234\n"));
+    EXPECT_NE(std::string::npos, out.text.find("hot monitor_notify runs 0 allocations 0\n"));
+}
@@ -0,0 +1,239 @@
+// Host tests for the Monitor's timeouts and advertising schedule, run on
+// virtual time so every Ticker fires at its exact millisecond
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <host_ble.hpp>
+#include <host_clock.hpp>
+#include "../lib/esp32_racechrono.hpp"
+
+using namespace RaceChronoProtocol;
+
+struct ConfigMessage
+{
+    uint32_t time_ms;
+    std::vector<uint8_t> data;
+};
+
+class Esp32MonitorTest : public ::testing::Test
+{
+protected:
+    // Server callbacks are a singleton bound to the first server, so every
+    // test shares one
+    static BLEServer* server;
+
+    std::unique_ptr<ESP32RaceChrono::Monitor> mon;
+    BLECharacteristic* config_ch = nullptr;
+    BLECharacteristic* notify_ch = nullptr;
+    std::vector<ConfigMessage> sent;
+
+    static void SetUpTestSuite()
+    {
+        server = BLEDevice::createServer();
+    }
+
+    static void on_indication(void* arg, uint16_t uuid, const uint8_t* data,
+        size_t len)
+    {
+        if (uuid == MONITOR_CONFIG_UUID)
+        {
+            ((Esp32MonitorTest*) arg)->sent.push_back(
+                ConfigMessage{millis(), std::vector<uint8_t>(data, data + len)});
+        }
+    }
+
+    void SetUp() override
+    {
+        host_clock::use_virtual_time();
+        host_ble::set_indication_listener(on_indication, this);
+        mon.reset(new ESP32RaceChrono::Monitor(server));
+        mon->add("channel(device(gps), speed)");
+        config_ch = host_ble::find_characteristic(server, MONITOR_CONFIG_UUID);
+        notify_ch = host_ble::find_characteristic(server, MONITOR_NOTIFY_UUID);
+        host_ble::connect(server);
+    }
+
+    void TearDown() override
+    {
+        if (server->getConnectedCount() > 0) { host_ble::disconnect(server); }
+        // Connection events run on the timer task, leave none for the next
+        // test
+        host_clock::advance_ms(0);
+        mon.reset();
+        host_ble::set_indication_listener(nullptr, nullptr);
+        host_clock::use_real_time();
+    }
+
+    // Subscribe and acknowledge the equation, leaving the monitor active
+    void configure()
+    {
+        host_ble::subscribe(config_ch);
+        host_clock::advance_ms(0);
+        const uint8_t ok[] = { MONITOR_RESULT_OK, 0 };
+        host_ble::write(config_ch, ok, sizeof(ok));
+        sent.clear();
+    }
+
+    void send_value()
+    {
+        uint8_t value[MONITOR_VALUE_LEN];
+        encode_monitor_value(value, 0, 0, 1000);
+        host_ble::write(notify_ch, value, sizeof(value));
+    }
+};
+
+BLEServer* Esp32MonitorTest::server = nullptr;
+
+TEST_F(Esp32MonitorTest, RetriesConfigurationUntilAcknowledged)
+{
+    // Sent from the timer task, not from the subscription callback
+    host_ble::subscribe(config_ch);
+    EXPECT_TRUE(sent.empty());
+    host_clock::advance_ms(0);
+    ASSERT_EQ(2u, sent.size());
+    EXPECT_EQ(0u, sent[0].time_ms);
+
+    // Configuring re-arms the refresh timer, so retries come every refresh
+    // period rather than every init period
+    host_clock::advance_ms(1499);
+    EXPECT_EQ(2u, sent.size());
+    host_clock::advance_ms(1);
+    ASSERT_EQ(4u, sent.size());
+    EXPECT_EQ(1500u, sent[2].time_ms);
+    EXPECT_EQ(MONITOR_ADD_INCOMPLETE, sent[2].data[0]);
+    host_clock::advance_ms(1500);
+    ASSERT_EQ(6u, sent.size());
+    EXPECT_EQ(3000u, sent[4].time_ms);
+    EXPECT_FALSE(mon->data_valid());
+
+    const uint8_t ok[] = { MONITOR_RESULT_OK, 0 };
+    host_ble::write(config_ch, ok, sizeof(ok));
+    EXPECT_TRUE(mon->data_valid());
+}
+
+TEST_F(Esp32MonitorTest, RefreshesThenResetsWithoutValues)
+{
+    configure();
+    host_clock::advance_ms(200);
+    send_value();
+
+    host_clock::advance_ms(1499);
+    EXPECT_TRUE(sent.empty());
+    host_clock::advance_ms(1);
+    ASSERT_EQ(1u, sent.size());
+    EXPECT_EQ(1700u, sent[0].time_ms);
+    EXPECT_EQ(std::vector<uint8_t>{MONITOR_UPDATE_ALL}, sent[0].data);
+    EXPECT_TRUE(mon->data_valid());
+
+    host_clock::advance_ms(1499);
+    EXPECT_EQ(1u, sent.size());
+    host_clock::advance_ms(1);
+    ASSERT_EQ(4u, sent.size());
+    EXPECT_EQ(3200u, sent[1].time_ms);
+    EXPECT_EQ(std::vector<uint8_t>{MONITOR_REMOVE_ALL}, sent[1].data);
+    EXPECT_EQ(MONITOR_ADD, sent[3].data[0]);
+    EXPECT_FALSE(mon->data_valid());
+}
+
+TEST_F(Esp32MonitorTest, ValuesKeepMonitorActiveForASession)
+{
+    configure();
+    // 30 minutes of one value a second, then a value that answers the
+    // refresh request just before the reset
+    for (int i = 0; i < 30 * 60; i++)
+    {
+        host_clock::advance_ms(1000);
+        send_value();
+    }
+    EXPECT_TRUE(sent.empty());
+    host_clock::advance_ms(2999);
+    ASSERT_EQ(1u, sent.size());
+    EXPECT_EQ(MONITOR_UPDATE_ALL, sent[0].data[0]);
+    send_value();
+    host_clock::advance_ms(1499);
+    EXPECT_EQ(1u, sent.size());
+    EXPECT_TRUE(mon->data_valid());
+}
+
+TEST_F(Esp32MonitorTest, ReconnectTimeIsExact)
+{
+    configure();
+    host_clock::advance_ms(500);
+    host_ble::disconnect(server);
+    host_clock::advance_ms(800);
+    host_ble::connect(server);
+    configure();
+    host_clock::advance_ms(1545);
+    send_value();
+    EXPECT_EQ(2345u, mon->last_reconnect_ms());
+}
+
+TEST_F(Esp32MonitorTest, AdvertisingBacksOffAfterDisconnect)
+{
+    BLEAdvertising* adv = server->getAdvertising();
+    ESP32RaceChrono::AdvertisingPolicy policy;
+    host_ble::disconnect(server);
+
+    // Directed to the last central first, fast undirected after 1.28 s
+    host_clock::advance_ms(0);
+    EXPECT_TRUE(host_ble::is_advertising_directed());
+    host_clock::advance_ms(1280);
+    EXPECT_FALSE(host_ble::is_advertising_directed());
+    EXPECT_EQ(policy.fast_interval, adv->getMinInterval());
+    host_clock::advance_ms(policy.fast_ms - 1);
+    EXPECT_EQ(policy.fast_interval, adv->getMinInterval());
+    host_clock::advance_ms(1);
+    EXPECT_EQ(policy.backoff_interval, adv->getMinInterval());
+
+    // Doubles every step until it saturates
+    const uint16_t steps[] = { 488, 976, 1952, 3200 };
+    for (uint16_t interval : steps)
+    {
+        host_clock::advance_ms(policy.backoff_step_ms);
+        EXPECT_EQ(interval, adv->getMinInterval());
+        EXPECT_EQ(interval, adv->getMaxInterval());
+    }
+    host_clock::advance_ms(10 * policy.backoff_step_ms);
+    EXPECT_EQ(policy.max_interval, adv->getMinInterval());
+    EXPECT_TRUE(adv->isAdvertising());
+}
+
+TEST_F(Esp32MonitorTest, ResolvablePrivateCentralGetsNoDirectedAdvertising)
+{
+    // Without an IRK the address cannot be followed to the next connect
+    BLEAdvertising* adv = server->getAdvertising();
+    ESP32RaceChrono::AdvertisingPolicy policy;
+    host_ble::disconnect(server);
+    const esp_bd_addr_t rpa = { 0x4A, 0x11, 0x22, 0x33, 0x44, 0x55 };
+    host_ble::connect(server, rpa, BLE_ADDR_TYPE_RANDOM);
+    host_ble::disconnect(server);
+    host_clock::advance_ms(0);
+    EXPECT_FALSE(host_ble::is_advertising_directed());
+    EXPECT_EQ(policy.fast_interval, adv->getMinInterval());
+
+    // A static random address stays the same, so it is advertised to
+    const esp_bd_addr_t static_random = { 0xCA, 0x11, 0x22, 0x33, 0x44, 0x55 };
+    host_ble::connect(server, static_random, BLE_ADDR_TYPE_RANDOM);
+    host_ble::disconnect(server);
+    host_clock::advance_ms(0);
+    EXPECT_TRUE(host_ble::is_advertising_directed());
+}
+
+TEST_F(Esp32MonitorTest, WakeRunsOnTheTimerTask)
+{
+    BLEAdvertising* adv = server->getAdvertising();
+    ESP32RaceChrono::AdvertisingPolicy policy;
+    host_ble::disconnect(server);
+    host_clock::advance_ms(1280 + policy.fast_ms);
+    EXPECT_EQ(policy.backoff_interval, adv->getMinInterval());
+
+    // Posted from the caller, the phase only changes when the timer runs
+    ESP32RaceChrono::wake(server);
+    ESP32RaceChrono::wake(server);
+    EXPECT_EQ(policy.backoff_interval, adv->getMinInterval());
+    host_clock::advance_ms(0);
+    EXPECT_EQ(policy.fast_interval, adv->getMinInterval());
+    EXPECT_TRUE(adv->isAdvertising());
+}
@@ -0,0 +1,100 @@
+// Host tests for the remote display's integer value formatting
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <gtest/gtest.h>
+#include "../examples/remote-display-device/main/FixedFormat.h"
+
+static std::string fixed(int32_t raw, uint8_t rawDecimals, uint8_t decimals)
+{
+    char out[FIXED_FORMAT_MAX];
+    uint8_t len = formatFixed(out, raw, rawDecimals, decimals);
+    EXPECT_LT(len, FIXED_FORMAT_MAX);
+    EXPECT_EQ(len, strlen(out));
+    return out;
+}
+
+static std::string lapTime(int32_t raw, uint8_t rawDecimals)
+{
+    char out[FIXED_FORMAT_MAX];
+    uint8_t len = formatLapTime(out, raw, rawDecimals);
+    EXPECT_LT(len, FIXED_FORMAT_MAX);
+    EXPECT_EQ(len, strlen(out));
+    return out;
+}
+
+TEST(FixedFormat, UnsignedWritesEveryDigitWithoutTerminator)
+{
+    char out[16];
+    memset(out, 'x', sizeof(out));
+    ASSERT_EQ(1, formatUnsigned(out, 0));
+    EXPECT_EQ('0', out[0]);
+    EXPECT_EQ('x', out[1]);
+    ASSERT_EQ(2, formatUnsigned(out, 10));
+    EXPECT_EQ("10", std::string(out, 2));
+    ASSERT_EQ(10, formatUnsigned(out, UINT32_MAX));
+    EXPECT_EQ("4294967295", std::string(out, 10));
+}
+
+TEST(FixedFormat, RoundsHalfAwayFromZero)
+{
+    EXPECT_EQ("123.45", fixed(12345, 2, 2));
+    EXPECT_EQ("123.5", fixed(12345, 2, 1));
+    EXPECT_EQ("123", fixed(12349, 2, 0));
+    EXPECT_EQ("124", fixed(12350, 2, 0));
+    EXPECT_EQ("-124", fixed(-12350, 2, 0));
+    EXPECT_EQ("-123", fixed(-12349, 2, 0));
+    EXPECT_EQ("1.0", fixed(995, 3, 1));
+}
+
+TEST(FixedFormat, NegativeRoundingToZeroHasNoSign)
+{
+    EXPECT_EQ("0.0", fixed(-4, 2, 1));
+    EXPECT_EQ("-0.1", fixed(-5, 2, 1));
+    EXPECT_EQ("0", fixed(-49, 2, 0));
+    EXPECT_EQ("0", fixed(0, 0, 0));
+}
+
+TEST(FixedFormat, ShowsMoreDecimalsThanCarried)
+{
+    EXPECT_EQ("12.300", fixed(123, 1, 3));
+    EXPECT_EQ("7.000000000", fixed(7, 0, FIXED_DECIMALS_MAX));
+    EXPECT_EQ("2147483647.000000000", fixed(INT32_MAX, 0, FIXED_DECIMALS_MAX));
+
+    // Decimals beyond the maximum are clamped
+    EXPECT_EQ("7.000000000", fixed(7, 0, FIXED_DECIMALS_MAX + 3));
+}
+
+TEST(FixedFormat, Int32MinFitsTheBuffer)
+{
+    EXPECT_EQ("-2147483648", fixed(INT32_MIN, 0, 0));
+    EXPECT_EQ("-2.147483648", fixed(INT32_MIN, 9, 9));
+    EXPECT_EQ("-2.15", fixed(INT32_MIN, 9, 2));
+    EXPECT_EQ("-2147483648.000000000", fixed(INT32_MIN, 0, FIXED_DECIMALS_MAX));
+}
+
+TEST(FixedFormat, LapTimeRoundsToTenths)
+{
+    EXPECT_EQ("0:00.0", lapTime(0, 3));
+    EXPECT_EQ("0:59.9", lapTime(59949, 3));
+    EXPECT_EQ("1:23.5", lapTime(83456, 3));
+    EXPECT_EQ("1:15.0", lapTime(75, 0));
+    EXPECT_EQ("1:15.3", lapTime(753, 1));
+}
+
+TEST(FixedFormat, LapTimeTenthsCarryIntoMinutes)
+{
+    EXPECT_EQ("1:00.0", lapTime(5996, 2));
+    EXPECT_EQ("1:00.0", lapTime(59950, 3));
+    EXPECT_EQ("10:00.0", lapTime(599999, 3));
+}
+
+TEST(FixedFormat, NegativeLapTimes)
+{
+    EXPECT_EQ("0:00.0", lapTime(-4, 2));
+    EXPECT_EQ("-0:00.1", lapTime(-5, 2));
+    EXPECT_EQ("-1:00.0", lapTime(-5996, 2));
+    EXPECT_EQ("-35791:23.6", lapTime(INT32_MIN, 3));
+    EXPECT_EQ("-35791394:08.0", lapTime(INT32_MIN, 0));
+}
@@ -0,0 +1,38 @@
+// Host tests for the remote display's table sine and cosine used by the gauge
+
+#include <math.h>
+#include <stdlib.h>
+#include <gtest/gtest.h>
+#include "../examples/remote-display-device/main/FixedTrig.h"
+
+TEST(FixedTrig, CardinalAnglesAreExact)
+{
+    EXPECT_EQ(0, fixedSin(0));
+    EXPECT_EQ(FIXED_ONE, fixedSin(FIXED_ANGLE_TURN / 4));
+    EXPECT_EQ(0, fixedSin(FIXED_ANGLE_TURN / 2));
+    EXPECT_EQ(-FIXED_ONE, fixedSin(FIXED_ANGLE_TURN * 3 / 4));
+    EXPECT_EQ(FIXED_ONE, fixedCos(0));
+    EXPECT_EQ(-FIXED_ONE, fixedCos(FIXED_ANGLE_TURN / 2));
+}
+
+TEST(FixedTrig, MatchesLibmOverATurn)
+{
+    for (int32_t angle = 0; angle < FIXED_ANGLE_TURN; angle++)
+    {
+        double radians = angle * 2.0 * M_PI / FIXED_ANGLE_TURN;
+        EXPECT_LE(abs(fixedSin(angle) - (int)lround(sin(radians) * FIXED_ONE)), 1) << angle;
+        EXPECT_LE(abs(fixedCos(angle) - (int)lround(cos(radians) * FIXED_ONE)), 1) << angle;
+    }
+}
+
+TEST(FixedTrig, AnyAngleWraps)
+{
+    // The gauge sweep starts at a negative angle
+    for (int32_t angle = -FIXED_ANGLE_TURN; angle < FIXED_ANGLE_TURN; angle += 7)
+    {
+        EXPECT_EQ(fixedSin(angle), fixedSin(angle + FIXED_ANGLE_TURN)) << angle;
+        EXPECT_EQ(fixedSin(angle), fixedSin(angle - 3 * FIXED_ANGLE_TURN)) << angle;
+        EXPECT_EQ(fixedSin(angle), (int16_t)-fixedSin(-angle)) << angle;
+        EXPECT_EQ(fixedCos(angle), fixedCos(-angle)) << angle;
+    }
+}
@@ -0,0 +1,115 @@
+// Host tests for the GPS device's on-device lap timer, replaying a circular track
+
+#include <math.h>
+#include <memory>
+#include <gtest/gtest.h>
+#include "../examples/canbus-gps-device/main/LapTimer.h"
+
+static const double ORIGIN_LATITUDE = 48.0;
+static const double ORIGIN_LONGITUDE = 11.0;
+static const double RADIUS_M = 200.0;
+static const double METERS_PER_DEGREE = 111319.5;
+
+// Convert meters east and north of the track center to 1e-7 degrees
+static void toFix(double x, double y, int32_t& latitude, int32_t& longitude)
+{
+    double metersPerLongitude = METERS_PER_DEGREE * cos(ORIGIN_LATITUDE * M_PI / 180.0);
+    latitude = (int32_t)lround((ORIGIN_LATITUDE + y / METERS_PER_DEGREE) * 1e7);
+    longitude = (int32_t)lround((ORIGIN_LONGITUDE + x / metersPerLongitude) * 1e7);
+}
+
+class LapTimerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // Line across the track at the east end, laps run counter-clockwise
+        timer.reset(new LapTimer());
+        int32_t latitude1, longitude1, latitude2, longitude2;
+        toFix(RADIUS_M - 10, 0, latitude1, longitude1);
+        toFix(RADIUS_M + 10, 0, latitude2, longitude2);
+        timer->setLine(latitude1, longitude1, latitude2, longitude2);
+    }
+
+    // Drive at a constant speed for a time, feeding 5 Hz fixes, returns laps completed
+    int drive(double speed, uint32_t durationMs)
+    {
+        int laps = 0;
+        for (uint32_t endMs = timeMs + durationMs; timeMs < endMs; timeMs += 200)
+        {
+            angle += speed * 0.2 / RADIUS_M;
+            int32_t latitude, longitude;
+            toFix(RADIUS_M * cos(angle), RADIUS_M * sin(angle), latitude, longitude);
+            if (timer->update(timeMs, latitude, longitude))
+            {
+                laps++;
+            }
+        }
+        return laps;
+    }
+
+    std::unique_ptr<LapTimer> timer;
+    uint32_t timeMs = 1000;
+    double angle = -0.3;
+};
+
+TEST_F(LapTimerTest, CrossingTimeIsInterpolated)
+{
+    // 30 m/s puts the crossings between fixes, never on one
+    double lapMs = 2 * M_PI * RADIUS_M / 30.0 * 1000.0;
+    EXPECT_EQ(drive(30.0, 2000), 0);
+    EXPECT_TRUE(timer->isTiming());
+    EXPECT_FALSE(timer->hasReference());
+    EXPECT_EQ(drive(30.0, (uint32_t)(lapMs * 2)), 2);
+    EXPECT_EQ(timer->getLapCount(), 2);
+    EXPECT_NEAR(timer->getLastLapMs(), lapMs, 5.0);
+    EXPECT_NEAR(timer->getBestLapMs(), lapMs, 5.0);
+}
+
+TEST_F(LapTimerTest, DeltaAgainstSlowerReference)
+{
+    double lapM = 2 * M_PI * RADIUS_M;
+    drive(30.0, 2000);
+    drive(30.0, (uint32_t)(lapM / 30.0 * 1000.0));
+    ASSERT_TRUE(timer->hasReference());
+
+    // Halfway around the next lap at 32 m/s
+    drive(32.0, (uint32_t)(lapM / 2 / 32.0 * 1000.0));
+    ASSERT_TRUE(timer->hasDelta());
+    double distanceM = timer->getDistanceM();
+    double expectedMs = (distanceM / 32.0 - distanceM / 30.0) * 1000.0;
+    EXPECT_NEAR(timer->getDeltaMs(), expectedMs, 20.0);
+    EXPECT_LT(timer->getDeltaMs(), -600);
+
+    // The faster lap becomes the reference, its first step was still at 30 m/s
+    uint32_t previousBestMs = timer->getBestLapMs();
+    drive(32.0, (uint32_t)(lapM / 2 / 32.0 * 1000.0) + 400);
+    EXPECT_LT(timer->getBestLapMs(), previousBestMs);
+    EXPECT_NEAR(timer->getBestLapMs(), lapM / 32.0 * 1000.0, 15.0);
+}
+
+TEST_F(LapTimerTest, RepeatedFixAndGap)
+{
+    drive(30.0, 2000);
+    ASSERT_TRUE(timer->isTiming());
+    uint32_t elapsedMs = timer->getElapsedMs();
+
+    // RMC and GGA of the same epoch only count once
+    int32_t latitude, longitude;
+    toFix(RADIUS_M * cos(angle), RADIUS_M * sin(angle), latitude, longitude);
+    EXPECT_FALSE(timer->update(timeMs - 200, latitude, longitude));
+    EXPECT_EQ(timer->getElapsedMs(), elapsedMs);
+
+    // A lost fix stops timing until the next crossing
+    timeMs += 5000;
+    drive(30.0, 1000);
+    EXPECT_FALSE(timer->isTiming());
+    EXPECT_FALSE(timer->hasDelta());
+}
+
+TEST(LapTimer, NoLineNoLaps)
+{
+    std::unique_ptr<LapTimer> timer(new LapTimer());
+    EXPECT_FALSE(timer->update(1000, 480000000, 110000000));
+    EXPECT_FALSE(timer->isTiming());
+}
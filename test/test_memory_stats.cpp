@@ -0,0 +1,114 @@
+// Host tests for the nRF52 examples' memory report, built with
+// MEMORY_STATS_COUNT_ALLOCATIONS
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <host_clock.hpp>
+#include "../examples/canbus-gps-device/main/MemoryStats.h"
+
+// Keeps allocations observable, the compiler may drop a new and delete pair
+static int* volatile sink;
+
+// Collects printed text
+class StringPrint : public Print
+{
+public:
+    std::string text;
+
+    size_t write(uint8_t c) override
+    {
+        text.push_back((char)c);
+        return 1;
+    }
+};
+
+class MemoryStatsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        MemoryStats::setAllocTrap(false);
+        MemoryStats::resetHotPaths();
+        host_clock::use_virtual_time();
+    }
+
+    void TearDown() override { host_clock::use_real_time(); }
+};
+
+TEST_F(MemoryStatsTest, CountsAllocationsOfTheTaskOnTheHotPath)
+{
+    // Waits for its turn, allocates and hands back
+    static TaskHandle_t loopTask;
+    loopTask = xTaskGetCurrentTaskHandle();
+    TaskHandle_t worker = nullptr;
+    xTaskCreate([](void*)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        sink = new int(2);
+        delete sink;
+        xTaskNotifyGive(loopTask);
+    }, "worker", 256, nullptr, TASK_PRIO_LOW, &worker);
+
+    sink = new int(1);
+    delete sink;
+    {
+        HotPathScope hotPath(HOT_PATH_CAN_FRAME);
+        std::vector<int> values(16);
+        sink = values.data();
+        // Another task allocating meanwhile is not charged to this path
+        xTaskNotifyGive(worker);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    sink = new int(3);
+    delete sink;
+    EXPECT_EQ(1u, MemoryStats::getHotPathRuns(HOT_PATH_CAN_FRAME));
+    EXPECT_EQ(1u, MemoryStats::getHotPathAllocations(HOT_PATH_CAN_FRAME));
+    EXPECT_EQ(0u, MemoryStats::getHotPathRuns(HOT_PATH_DISPLAY_FRAME));
+}
+
+TEST_F(MemoryStatsTest, TrapHaltsOnHotPathAllocation)
+{
+    EXPECT_DEATH(
+        {
+            MemoryStats::setAllocTrap(true);
+            HotPathScope hotPath(HOT_PATH_DISPLAY_FRAME);
+            sink = new int(4);
+        }, "");
+}
+
+TEST_F(MemoryStatsTest, TracksMinimumFreeHeapOncePerSecond)
+{
+    MemoryStats stats;
+    host_heap::set(40000, 10000);
+    stats.loop();
+    EXPECT_EQ(30000u, stats.getHeapMinFree());
+
+    // Samples in between are skipped
+    host_heap::set(40000, 25000);
+    host_clock::advance_ms(999);
+    stats.loop();
+    host_heap::set(40000, 20000);
+    host_clock::advance_ms(1);
+    stats.loop();
+    EXPECT_EQ(20000u, stats.getHeapMinFree());
+    EXPECT_EQ(20000u, stats.getHeapFree());
+}
+
+TEST_F(MemoryStatsTest, ReportsStacksInBytes)
+{
+    host_heap::set(40000, 10000);
+    MemoryStats stats;
+    ASSERT_TRUE(stats.watchTask());
+    ASSERT_TRUE(stats.watchTask(xTaskGetCurrentTaskHandle()));
+    EXPECT_EQ(1u, stats.getTaskCount());
+    host_task::set_stack_high_water(xTaskGetCurrentTaskHandle(), 100);
+    EXPECT_EQ(400u, stats.getStackHighWater(0));
+    EXPECT_STREQ("loop", stats.getTaskName(0));
+
+    StringPrint out;
+    stats.print(out);
+    EXPECT_NE(std::string::npos, out.text.find("Heap free 30000 min 30000 largest 30000"));
+    EXPECT_NE(std::string::npos, out.text.find("  Stack loop unused 400\r\n"));
+    EXPECT_NE(std::string::npos, out.text.find("  Hot path CAN frame runs 0 allocations 0\r\n"));
+}
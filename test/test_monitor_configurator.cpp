@@ -0,0 +1,199 @@
+// Host tests for the remote display's monitor configuration state machine,
+// answering for the app on virtual time
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <host_clock.hpp>
+#include "../examples/remote-display-device/main/MonitorConfigurator.h"
+
+struct Indication
+{
+    uint8_t cmd;
+    uint8_t monitorId;
+    uint8_t chunk;
+};
+
+static std::vector<Indication> indications;
+static bool confirmed = true;
+
+static bool onSend(const uint8_t* bytes, uint8_t len)
+{
+    if (!confirmed)
+    {
+        return false;
+    }
+    indications.push_back(Indication{bytes[0], len > 1 ? bytes[1] : (uint8_t)0, len > 2 ? bytes[2] : (uint8_t)0});
+    return true;
+}
+
+class MonitorConfiguratorTest : public ::testing::Test
+{
+protected:
+    MonitorConfigurator configurator;
+
+    MonitorConfiguratorTest()
+        : configurator(onSend) {}
+
+    void SetUp() override
+    {
+        host_clock::use_virtual_time();
+        indications.clear();
+        confirmed = true;
+    }
+
+    void TearDown() override
+    {
+        host_clock::use_real_time();
+    }
+
+    void answer(uint8_t result, uint8_t monitorId, uint16_t exceptionType = 0)
+    {
+        uint8_t data[] = {result, monitorId, (uint8_t)(exceptionType >> 8), (uint8_t)exceptionType};
+        configurator.handleResult(data, sizeof(data));
+    }
+
+    // Step until nothing is left to send
+    void drain()
+    {
+        while (configurator.step())
+        {
+        }
+    }
+};
+
+TEST_F(MonitorConfiguratorTest, AddIsActiveOnceTheAppAccepts)
+{
+    ASSERT_TRUE(configurator.add(3, "speed*10.0"));
+    EXPECT_FALSE(configurator.isDone());
+    drain();
+    ASSERT_EQ(1u, indications.size());
+    EXPECT_EQ(CMD_TYPE_ADD, indications[0].cmd);
+    EXPECT_EQ(3, indications[0].monitorId);
+    EXPECT_EQ(MONITOR_SLOT_AWAITING_RESULT, configurator.getState(3));
+    EXPECT_FALSE(configurator.isDone());
+
+    answer(CMD_RESULT_OK, 3);
+    EXPECT_EQ(MONITOR_SLOT_ACTIVE, configurator.getState(3));
+    EXPECT_EQ(1, configurator.getActiveCount());
+    EXPECT_TRUE(configurator.isDone());
+}
+
+TEST_F(MonitorConfiguratorTest, EveryOneByteIdTheSketchUsesIsAccepted)
+{
+    EXPECT_TRUE(configurator.add(CONFIGURATOR_MONITORS_MAX - 1, "1"));
+    EXPECT_FALSE(configurator.add(CONFIGURATOR_MONITORS_MAX, "1"));
+    EXPECT_EQ(1, configurator.getWantedCount());
+}
+
+TEST_F(MonitorConfiguratorTest, UnansweredAddIsRetriedThenFails)
+{
+    configurator.add(0, "1");
+    drain();
+    ASSERT_EQ(1u, indications.size());
+
+    // Nothing is resent until the result deadline has passed
+    host_clock::advance_ms(CONFIGURATOR_RESULT_TIMEOUT_MS);
+    EXPECT_FALSE(configurator.step());
+    for (int retry = 1; retry <= CONFIGURATOR_RETRIES_MAX; retry++)
+    {
+        host_clock::advance_ms(CONFIGURATOR_RESULT_TIMEOUT_MS + 1);
+        drain();
+        ASSERT_EQ(1u + retry, indications.size());
+        EXPECT_EQ(CMD_TYPE_ADD, indications.back().cmd);
+    }
+
+    host_clock::advance_ms(CONFIGURATOR_RESULT_TIMEOUT_MS + 1);
+    EXPECT_FALSE(configurator.step());
+    EXPECT_EQ(MONITOR_SLOT_FAILED, configurator.getState(0));
+    EXPECT_TRUE(configurator.isDone());
+}
+
+TEST_F(MonitorConfiguratorTest, UnconfirmedChunkIsResent)
+{
+    std::string equation(CONFIG_CHUNK_MAX * 2, 'x');
+    configurator.add(5, equation.c_str());
+    ASSERT_TRUE(configurator.step());
+    confirmed = false;
+    EXPECT_FALSE(configurator.step());
+    confirmed = true;
+    ASSERT_TRUE(configurator.step());
+    ASSERT_EQ(2u, indications.size());
+    EXPECT_EQ(0, indications[0].chunk);
+    EXPECT_EQ(1, indications[1].chunk);
+}
+
+TEST_F(MonitorConfiguratorTest, OutOfSequenceRestartsFromTheFirstChunk)
+{
+    std::string equation(CONFIG_CHUNK_MAX * 2, 'x');
+    int chunkCount = getConfigChunkCount(CMD_TYPE_ADD, equation.size());
+    ASSERT_GT(chunkCount, 2);
+    configurator.add(7, equation.c_str());
+    ASSERT_TRUE(configurator.step());
+    ASSERT_TRUE(configurator.step());
+
+    // The app lost track mid-equation
+    answer(CMD_RESULT_PAYLOAD_OUT_OF_SEQUENCE, 7);
+    EXPECT_EQ(MONITOR_SLOT_REMOVED, configurator.getState(7));
+    indications.clear();
+    drain();
+    ASSERT_EQ((size_t)chunkCount, indications.size());
+    for (int chunk = 0; chunk < chunkCount; chunk++)
+    {
+        EXPECT_EQ(chunk, indications[chunk].chunk);
+        EXPECT_EQ(7, indications[chunk].monitorId);
+    }
+    EXPECT_EQ(CMD_TYPE_ADD, indications.back().cmd);
+
+    answer(CMD_RESULT_OK, 7);
+    EXPECT_EQ(MONITOR_SLOT_ACTIVE, configurator.getState(7));
+}
+
+TEST_F(MonitorConfiguratorTest, EquationExceptionFailsWithoutRetry)
+{
+    configurator.add(2, "nonsense(");
+    drain();
+    answer(CMD_RESULT_EQUATION_EXCEPTION, 2, 0x0102);
+    EXPECT_EQ(MONITOR_SLOT_FAILED, configurator.getState(2));
+    EXPECT_EQ(0x0102, configurator.getExceptionType(2));
+    EXPECT_TRUE(configurator.isDone());
+
+    host_clock::advance_ms(CONFIGURATOR_RESULT_TIMEOUT_MS + 1);
+    EXPECT_FALSE(configurator.step());
+    EXPECT_EQ(1u, indications.size());
+
+    // Asking again starts over with a clean slate
+    configurator.add(2, "1");
+    EXPECT_EQ(0, configurator.getExceptionType(2));
+    EXPECT_TRUE(configurator.step());
+    EXPECT_EQ(2u, indications.size());
+}
+
+TEST_F(MonitorConfiguratorTest, RemovesAreSentBeforeAdds)
+{
+    configurator.add(9, "1");
+    drain();
+    answer(CMD_RESULT_OK, 9);
+    indications.clear();
+
+    configurator.add(1, "2");
+    configurator.remove(9);
+    drain();
+    ASSERT_EQ(2u, indications.size());
+    EXPECT_EQ(CMD_TYPE_REMOVE, indications[0].cmd);
+    EXPECT_EQ(9, indications[0].monitorId);
+    EXPECT_EQ(CMD_TYPE_ADD, indications[1].cmd);
+    EXPECT_EQ(1, indications[1].monitorId);
+    EXPECT_EQ(MONITOR_SLOT_REMOVED, configurator.getState(9));
+    EXPECT_EQ(1, configurator.getWantedCount());
+}
+
+TEST_F(MonitorConfiguratorTest, ResultsForOtherMonitorsAreIgnored)
+{
+    configurator.add(4, "1");
+    drain();
+    answer(CMD_RESULT_OK, 5);
+    EXPECT_EQ(MONITOR_SLOT_AWAITING_RESULT, configurator.getState(4));
+    EXPECT_EQ(MONITOR_SLOT_REMOVED, configurator.getState(5));
+    EXPECT_EQ(0, configurator.getActiveCount());
+}
@@ -0,0 +1,133 @@
+// Host tests for the Monitor API traffic recorder, built with
+// -DRACECHRONO_MONITOR_RECORDER against the host ESP32 stand-in
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <host_ble.hpp>
+#include <host_clock.hpp>
+#include "../lib/esp32_racechrono.hpp"
+
+using ESP32RaceChrono::MonitorRecorder;
+using ESP32RaceChrono::TraceEntry;
+
+// Collects printed text
+class StringPrint : public Print
+{
+public:
+    std::string text;
+
+    size_t write(uint8_t c) override
+    {
+        text.push_back((char)c);
+        return 1;
+    }
+};
+
+// Split dumped text into parsed entries
+static std::vector<TraceEntry> parseDump(const std::string& text)
+{
+    std::vector<TraceEntry> entries;
+    size_t start = 0;
+    while (start < text.size())
+    {
+        size_t end = text.find('\n', start);
+        std::string line = text.substr(start, end - start);
+        TraceEntry entry;
+        if (MonitorRecorder::parse_line(line.c_str(), entry))
+        {
+            entries.push_back(entry);
+        }
+        start = end == std::string::npos ? text.size() : end + 1;
+    }
+    return entries;
+}
+
+TEST(MonitorRecorderTest, RingKeepsNewestEvents)
+{
+    MonitorRecorder recorder(3);
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        recorder.record(ESP32RaceChrono::TRACE_WRITE_NOTIFY, &i, 1);
+    }
+    ASSERT_EQ(3u, recorder.size());
+    EXPECT_EQ(2u, recorder.overwritten());
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(i + 2, recorder.at(i).data[0]);
+    }
+    EXPECT_LE(recorder.at(0).time_us, recorder.at(2).time_us);
+}
+
+TEST(MonitorRecorderTest, DumpParsesBack)
+{
+    MonitorRecorder recorder(16);
+    const uint8_t add[] = { 3, 0, 0, 's', 'p', 'e', 'e', 'd' };
+    uint8_t longWrite[32];
+    for (uint8_t i = 0; i < sizeof(longWrite); i++)
+    {
+        longWrite[i] = i * 7;
+    }
+    recorder.record(ESP32RaceChrono::TRACE_SUBSCRIBE, nullptr, 0);
+    recorder.record(ESP32RaceChrono::TRACE_INDICATE_CONFIG, add, sizeof(add));
+    recorder.record(ESP32RaceChrono::TRACE_WRITE_NOTIFY, longWrite, sizeof(longWrite));
+    recorder.record(ESP32RaceChrono::TRACE_DISCONNECT, nullptr, 0);
+
+    StringPrint out;
+    recorder.dump(out);
+    std::vector<TraceEntry> entries = parseDump(out.text);
+    ASSERT_EQ(recorder.size(), entries.size());
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        TraceEntry expected = recorder.at(i);
+        EXPECT_EQ(expected.time_us, entries[i].time_us);
+        EXPECT_EQ(expected.event, entries[i].event);
+        ASSERT_EQ(expected.len, entries[i].len);
+        EXPECT_EQ(0, memcmp(expected.data, entries[i].data, expected.len));
+    }
+    // Payloads are cut to what fits an entry
+    EXPECT_EQ(ESP32RaceChrono::TRACE_DATA_MAX, entries[2].len);
+
+    TraceEntry entry;
+    EXPECT_FALSE(MonitorRecorder::parse_line("# comment", entry));
+    EXPECT_FALSE(MonitorRecorder::parse_line("12 XX 00", entry));
+    EXPECT_FALSE(MonitorRecorder::parse_line("12 W6 0", entry));
+}
+
+TEST(MonitorRecorderTest, MonitorTracesSession)
+{
+    BLEServer* server = BLEDevice::createServer();
+    ESP32RaceChrono::Monitor mon(server);
+    mon.add("channel(device(gps), speed)");
+    BLECharacteristic* configCh = host_ble::find_characteristic(server, 0x0005);
+    BLECharacteristic* notifyCh = host_ble::find_characteristic(server, 0x0006);
+    ASSERT_NE(nullptr, configCh);
+    ASSERT_NE(nullptr, notifyCh);
+
+    host_ble::connect(server);
+    host_ble::subscribe(configCh);
+    host_clock::run_due();
+    const uint8_t result[] = { 0, 0 };
+    host_ble::write(configCh, result, sizeof(result));
+    const uint8_t value[] = { 0, 0, 0, 0x03, 0xE8 };
+    host_ble::write(notifyCh, value, sizeof(value));
+    host_ble::disconnect(server);
+
+    std::vector<ESP32RaceChrono::trace_event_t> events;
+    for (size_t i = 0; i < mon.recorder.size(); i++)
+    {
+        events.push_back(mon.recorder.at(i).event);
+    }
+    // The 27 character equation goes out in two chunks
+    std::vector<ESP32RaceChrono::trace_event_t> expected = {
+        ESP32RaceChrono::TRACE_SUBSCRIBE,
+        ESP32RaceChrono::TRACE_INDICATE_CONFIG,
+        ESP32RaceChrono::TRACE_INDICATE_CONFIG,
+        ESP32RaceChrono::TRACE_WRITE_CONFIG,
+        ESP32RaceChrono::TRACE_WRITE_NOTIFY,
+        ESP32RaceChrono::TRACE_DISCONNECT,
+    };
+    EXPECT_EQ(expected, events);
+    EXPECT_EQ(2, mon.recorder.at(1).data[0]);
+    EXPECT_EQ(3, mon.recorder.at(2).data[0]);
+}
@@ -0,0 +1,38 @@
+// Host tests for the GPS device's reference counted notification buffers
+
+#include <gtest/gtest.h>
+#include "../examples/canbus-gps-device/main/NotifyBufferPool.h"
+
+TEST(NotifyBufferPoolTest, ExhaustsAndRecovers)
+{
+    NotifyBufferPool pool;
+    NotifyBuffer* buffers[NOTIFY_BUFFER_POOL_SIZE];
+    for (uint8_t i = 0; i < NOTIFY_BUFFER_POOL_SIZE; i++)
+    {
+        buffers[i] = pool.acquire();
+        ASSERT_NE(nullptr, buffers[i]);
+    }
+    EXPECT_EQ(nullptr, pool.acquire());
+    EXPECT_EQ(1u, pool.getExhaustedCount());
+    EXPECT_EQ(0, pool.getMinFreeCount());
+
+    pool.release(buffers[3]);
+    EXPECT_EQ(buffers[3], pool.acquire());
+    EXPECT_EQ(0, pool.getFreeCount());
+}
+
+TEST(NotifyBufferPoolTest, LastReferenceReturnsTheBuffer)
+{
+    NotifyBufferPool pool;
+    NotifyBuffer* buffer = pool.acquire();
+    pool.retain(buffer);
+    pool.release(buffer);
+    EXPECT_EQ(NOTIFY_BUFFER_POOL_SIZE - 1, pool.getFreeCount());
+    pool.release(buffer);
+    EXPECT_EQ(NOTIFY_BUFFER_POOL_SIZE, pool.getFreeCount());
+
+    // A stray extra release does not hand the buffer out twice
+    pool.release(buffer);
+    EXPECT_EQ(NOTIFY_BUFFER_POOL_SIZE, pool.getFreeCount());
+    EXPECT_EQ(NOTIFY_BUFFER_POOL_SIZE - 1, pool.getMinFreeCount());
+}
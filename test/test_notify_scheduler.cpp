@@ -0,0 +1,154 @@
+// Host tests for the GPS device's notification scheduling, a link saturated
+// with CAN-Bus frames simulated on virtual time
+
+#include <vector>
+#include <gtest/gtest.h>
+#include <host_bluefruit.hpp>
+#include <host_clock.hpp>
+#include "../examples/canbus-gps-device/main/NotifyScheduler.h"
+#include "../lib/racechrono_protocol.hpp"
+
+struct Sent
+{
+    uint16_t uuid;
+    uint32_t sequence;
+};
+
+class NotifySchedulerTest : public ::testing::Test
+{
+protected:
+    NotifyBufferPool pool;
+    NotifyScheduler scheduler;
+    BLECharacteristic canCh;
+    BLECharacteristic gpsCh;
+    std::vector<Sent> sent;
+    bool subscribed = true;
+
+    NotifySchedulerTest()
+        : scheduler(&pool)
+        , canCh(RaceChronoProtocol::CAN_MAIN_UUID)
+        , gpsCh(RaceChronoProtocol::GPS_MAIN_UUID) {}
+
+    static bool onSend(void* arg, uint16_t uuid, const uint8_t* data, uint16_t len)
+    {
+        NotifySchedulerTest* test = (NotifySchedulerTest*)arg;
+        if (!test->subscribed)
+        {
+            return false;
+        }
+        uint32_t sequence;
+        memcpy(&sequence, data, sizeof(sequence));
+        test->sent.push_back(Sent{uuid, sequence});
+        return true;
+    }
+
+    void SetUp() override
+    {
+        host_clock::use_virtual_time();
+        host_bluefruit::set_connected(true);
+        host_bluefruit::set_send_listener(onSend, this);
+        scheduler.reset();
+    }
+
+    void TearDown() override
+    {
+        host_bluefruit::set_send_listener(nullptr, nullptr);
+        host_bluefruit::set_connected(false);
+        host_clock::use_real_time();
+    }
+
+    // Queue a value tagged with a sequence number, false if the pool is empty
+    bool enqueue(NotifyClass notifyClass, BLECharacteristic* ch, uint32_t sequence)
+    {
+        NotifyBuffer* buffer = pool.acquire();
+        if (!buffer)
+        {
+            return false;
+        }
+        memcpy(buffer->data, &sequence, sizeof(sequence));
+        buffer->len = sizeof(sequence);
+        scheduler.enqueue(notifyClass, ch, buffer);
+        return true;
+    }
+};
+
+TEST_F(NotifySchedulerTest, GpsLatencyStaysBoundedUnderCanSaturation)
+{
+    // 15 ms connection interval carries 4 notifications per event, 267/s.
+    // The bus offers 2000 frames/s and the GPS a 25 Hz fix for a minute.
+    scheduler.setConnectionInterval(15);
+    uint32_t gpsFixes = 0;
+    for (uint32_t us = 0; us < 60 * 1000 * 1000; us += 500)
+    {
+        enqueue(NOTIFY_CLASS_CAN, &canCh, us);
+        if (us % 40000 == 0)
+        {
+            ASSERT_TRUE(enqueue(NOTIFY_CLASS_GPS_FIX, &gpsCh, gpsFixes));
+            gpsFixes++;
+        }
+        scheduler.service();
+        host_clock::advance_us(500);
+    }
+
+    uint32_t gpsSent = 0;
+    uint32_t canSent = 0;
+    for (const Sent& s : sent)
+    {
+        if (s.uuid == RaceChronoProtocol::GPS_MAIN_UUID)
+        {
+            EXPECT_EQ(gpsSent, s.sequence);
+            gpsSent++;
+        }
+        else
+        {
+            canSent++;
+        }
+    }
+
+    // Every fix goes out, within one connection event of its arrival
+    EXPECT_EQ(gpsFixes, gpsSent);
+    EXPECT_EQ(0u, scheduler.getDropCount(NOTIFY_CLASS_GPS_FIX));
+    EXPECT_LT(scheduler.getMaxLatencyMs(NOTIFY_CLASS_GPS_FIX), 15u);
+
+    // CAN fills the budget it is given and drops its oldest frames
+    EXPECT_NEAR(60 * 200, canSent, 60 * 2);
+    EXPECT_GT(scheduler.getDropCount(NOTIFY_CLASS_CAN), 0u);
+    EXPECT_EQ(0u, pool.getExhaustedCount());
+}
+
+TEST_F(NotifySchedulerTest, WaitingCanFramesArePromoted)
+{
+    // CAN is two classes below a GPS fix, a frame that waited three promote
+    // intervals overtakes a fresh fix
+    scheduler.setEventBudget(1);
+    ASSERT_TRUE(enqueue(NOTIFY_CLASS_CAN, &canCh, 1));
+    host_clock::advance_ms(150);
+    ASSERT_TRUE(enqueue(NOTIFY_CLASS_GPS_FIX, &gpsCh, 2));
+    scheduler.service();
+    ASSERT_EQ(1u, sent.size());
+    EXPECT_EQ(RaceChronoProtocol::CAN_MAIN_UUID, sent[0].uuid);
+
+    host_clock::advance_ms(15);
+    scheduler.service();
+    ASSERT_EQ(2u, sent.size());
+    EXPECT_EQ(RaceChronoProtocol::GPS_MAIN_UUID, sent[1].uuid);
+}
+
+TEST_F(NotifySchedulerTest, UnsentValuesReturnTheirBuffers)
+{
+    subscribed = false;
+    for (uint32_t i = 0; i < NOTIFY_BUFFER_POOL_SIZE; i++)
+    {
+        ASSERT_TRUE(enqueue(NOTIFY_CLASS_CAN, &canCh, i));
+    }
+    EXPECT_EQ(NOTIFY_BUFFER_POOL_SIZE - NOTIFY_QUEUE_MAX, pool.getFreeCount());
+    scheduler.service();
+    EXPECT_TRUE(sent.empty());
+    EXPECT_EQ(NOTIFY_BUFFER_POOL_SIZE, pool.getFreeCount());
+    EXPECT_EQ(NOTIFY_BUFFER_POOL_SIZE, scheduler.getDropCount(NOTIFY_CLASS_CAN));
+
+    // A reset drops whatever is still queued
+    ASSERT_TRUE(enqueue(NOTIFY_CLASS_GPS_FIX, &gpsCh, 0));
+    scheduler.reset();
+    EXPECT_EQ(NOTIFY_BUFFER_POOL_SIZE, pool.getFreeCount());
+}
@@ -0,0 +1,101 @@
+// Host tests for the GPS device's per packet id throttling, run on virtual
+// time so notify intervals can be asserted to the millisecond
+
+#include <vector>
+#include <gtest/gtest.h>
+#include <host_clock.hpp>
+#include "../examples/canbus-gps-device/main/PacketIdInfo.h"
+
+class PacketIdInfoTest : public ::testing::Test
+{
+protected:
+    PacketIdInfo info;
+
+    // Start past zero, an item that was never notified counts from time 0
+    void SetUp() override { host_clock::use_virtual_time(1000000); }
+    void TearDown() override { host_clock::use_real_time(); }
+
+    // Feed one id every periodMs for durationMs, returns the notify times
+    std::vector<uint32_t> run(uint32_t packetId, uint32_t periodMs, uint32_t durationMs)
+    {
+        std::vector<uint32_t> notified;
+        PacketIdInfoItem* item = info.findItem(packetId, true);
+        for (uint32_t elapsedMs = 0; elapsedMs < durationMs; elapsedMs += periodMs)
+        {
+            item->markReceived();
+            if (item->shouldNotify())
+            {
+                item->markNotified();
+                notified.push_back(millis());
+            }
+            host_clock::advance_ms(periodMs);
+        }
+        return notified;
+    }
+};
+
+TEST_F(PacketIdInfoTest, ThrottlesToIntervalOverASession)
+{
+    info.setDefaultNotifyInterval(100);
+    // 100 Hz for 30 minutes, the interval has to be passed, not just reached
+    std::vector<uint32_t> notified = run(0x123, 10, 30 * 60 * 1000);
+    ASSERT_EQ(18000u, notified.size());
+    EXPECT_EQ(1000u, notified[0]);
+    EXPECT_EQ(1110u, notified[1]);
+    for (size_t i = 2; i < notified.size(); i++)
+    {
+        ASSERT_EQ(100u, notified[i] - notified[i - 1]) << "at " << i;
+    }
+}
+
+TEST_F(PacketIdInfoTest, FramesOffTheIntervalGridSettleIntoACycle)
+{
+    info.setDefaultNotifyInterval(100);
+    // Frames every 30 ms never land on an interval boundary, the schedule
+    // runs 120, 120, 90 ms, 110 ms on average
+    std::vector<uint32_t> notified = run(0x123, 30, 60 * 1000);
+    ASSERT_EQ(546u, notified.size());
+    const uint32_t cycle[] = { 120, 120, 90 };
+    for (size_t i = 2; i < notified.size(); i++)
+    {
+        ASSERT_EQ(cycle[i % 3], notified[i] - notified[i - 1]) << "at " << i;
+    }
+}
+
+TEST_F(PacketIdInfoTest, ResynchronizesAfterSilence)
+{
+    info.setNotifyInterval(0x123, 100);
+    run(0x123, 10, 1000);
+    host_clock::advance_ms(505);
+    std::vector<uint32_t> notified = run(0x123, 10, 1000);
+    ASSERT_EQ(10u, notified.size());
+    // The gap is longer than the interval allows for, so the schedule
+    // restarts from the first frame after it
+    EXPECT_EQ(2505u, notified[0]);
+    EXPECT_EQ(2615u, notified[1]);
+    EXPECT_EQ(2715u, notified[2]);
+}
+
+TEST_F(PacketIdInfoTest, ZeroIntervalNotifiesEveryFrame)
+{
+    std::vector<uint32_t> notified = run(0x456, 5, 1000);
+    EXPECT_EQ(200u, notified.size());
+}
+
+TEST_F(PacketIdInfoTest, RequestedIdsShareTheTableLimit)
+{
+    for (uint32_t packetId = 0; packetId < MAP_MAX_ITEMS - 1; packetId++)
+    {
+        info.findItem(packetId, true);
+    }
+    EXPECT_TRUE(info.setNotifyInterval(0x10000, 50));
+    EXPECT_FALSE(info.setNotifyInterval(0x10001, 50));
+    EXPECT_EQ(MAP_MAX_ITEMS, info.getItemCount());
+    EXPECT_EQ(nullptr, info.findItem(0x10001, false));
+
+    // Ids already in the table can still be changed
+    EXPECT_TRUE(info.setNotifyInterval(0x10000, 100));
+    EXPECT_TRUE(info.setNotifyInterval(5, 100));
+    EXPECT_EQ(100, info.findItem(5, false)->getNotifyInterval());
+    EXPECT_EQ(MAP_MAX_ITEMS, info.getItemCount());
+}
@@ -0,0 +1,167 @@
+// Host tests for the shared RaceChrono DIY protocol codec, round-tripping
+// every characteristic's format
+
+#include <string>
+#include <gtest/gtest.h>
+#include "../lib/racechrono_protocol.hpp"
+
+using namespace RaceChronoProtocol;
+
+// Sizes and encodings that firmware relies on at compile time
+static_assert(can_frame_len(3) == 7, "CAN frame length");
+static_assert(can_frame_len(40) == CAN_FRAME_MAX, "CAN frame cut");
+static_assert(can_filter_len(CAN_FILTER_ADD_PID) == CAN_FILTER_MAX, "filter length");
+static_assert(config_chunk_count(MONITOR_ADD, 35) == 3, "chunk count");
+static_assert(config_chunk_len(MONITOR_ADD, 35, 2) == CONFIG_HEADER_LEN + 1, "last chunk");
+static_assert(config_chunk_len(MONITOR_UPDATE_ALL, 0, 0) == 1, "update all");
+static_assert(gps_altitude(100.0f) == 6000, "altitude");
+static_assert(gps_speed(700.0f) == (7000 | 0x8000), "high speed");
+
+TEST(RaceChronoProtocolTest, CanFrameRoundTrip)
+{
+    const uint8_t payload[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+    uint8_t frame[CAN_FRAME_MAX];
+    uint8_t len = encode_can_frame(frame, 0x12345678, payload, sizeof(payload));
+    ASSERT_EQ(4 + sizeof(payload), len);
+    // Packet id is little-endian
+    EXPECT_EQ(0x78, frame[0]);
+    EXPECT_EQ(0x12, frame[3]);
+
+    uint32_t packetId;
+    const uint8_t* decoded;
+    uint8_t decodedLen;
+    ASSERT_TRUE(decode_can_frame(frame, len, packetId, decoded, decodedLen));
+    EXPECT_EQ(0x12345678u, packetId);
+    ASSERT_EQ(sizeof(payload), decodedLen);
+    EXPECT_EQ(0, memcmp(payload, decoded, decodedLen));
+    EXPECT_FALSE(decode_can_frame(frame, 3, packetId, decoded, decodedLen));
+
+    uint8_t longPayload[32] = { 0 };
+    EXPECT_EQ(CAN_FRAME_MAX, encode_can_frame(frame, 1, longPayload, sizeof(longPayload)));
+}
+
+TEST(RaceChronoProtocolTest, CanFilterRoundTrip)
+{
+    const CanFilterCommand commands[] = {
+        { CAN_FILTER_DENY_ALL, 0, 0 },
+        { CAN_FILTER_ALLOW_ALL, 250, 0 },
+        { CAN_FILTER_ADD_PID, 100, 0x1FFFFFFF },
+    };
+    for (const CanFilterCommand& command : commands)
+    {
+        uint8_t bytes[CAN_FILTER_MAX];
+        uint8_t len = encode_can_filter(bytes, command);
+        CanFilterCommand decoded;
+        ASSERT_TRUE(decode_can_filter(bytes, len, decoded));
+        EXPECT_EQ(command.cmd, decoded.cmd);
+        EXPECT_EQ(command.interval_ms, decoded.interval_ms);
+        EXPECT_EQ(command.packet_id, decoded.packet_id);
+        EXPECT_FALSE(decode_can_filter(bytes, len + 1, decoded));
+    }
+    const uint8_t unknown[] = { 9 };
+    CanFilterCommand decoded;
+    EXPECT_FALSE(decode_can_filter(unknown, sizeof(unknown), decoded));
+    EXPECT_FALSE(decode_can_filter(unknown, 0, decoded));
+}
+
+TEST(RaceChronoProtocolTest, GpsRoundTrip)
+{
+    GpsFix fix;
+    fix.sync_bits = 5;
+    fix.time_since_hour = gps_time_since_hour(59, 59, 998);
+    fix.fix_quality = 2;
+    fix.satellites = 14;
+    fix.latitude = -337123456;
+    fix.longitude = 1511234567;
+    fix.altitude = gps_altitude(-12.3f);
+    fix.speed = gps_speed(123.45f);
+    fix.bearing = round_positive(359.99f * 100.0f);
+    fix.hdop = 9;
+    fix.vdop = GPS_DOP_UNKNOWN;
+
+    uint8_t bytes[GPS_MAIN_LEN];
+    ASSERT_EQ(GPS_MAIN_LEN, encode_gps_main(bytes, fix));
+    GpsFix decoded;
+    ASSERT_TRUE(decode_gps_main(bytes, sizeof(bytes), decoded));
+    EXPECT_EQ(fix.sync_bits, decoded.sync_bits);
+    EXPECT_EQ(1799999u, decoded.time_since_hour);
+    EXPECT_EQ(fix.fix_quality, decoded.fix_quality);
+    EXPECT_EQ(fix.satellites, decoded.satellites);
+    EXPECT_EQ(fix.latitude, decoded.latitude);
+    EXPECT_EQ(fix.longitude, decoded.longitude);
+    EXPECT_EQ(4877, decoded.altitude);
+    EXPECT_EQ(12345, decoded.speed);
+    EXPECT_EQ(35999, decoded.bearing);
+    EXPECT_EQ(fix.hdop, decoded.hdop);
+    EXPECT_EQ(fix.vdop, decoded.vdop);
+
+    uint8_t sync;
+    uint32_t dateAndHour;
+    ASSERT_EQ(GPS_TIME_LEN, encode_gps_time(bytes, 6, gps_date_and_hour(24, 12, 31, 23)));
+    ASSERT_TRUE(decode_gps_time(bytes, GPS_TIME_LEN, sync, dateAndHour));
+    EXPECT_EQ(6, sync);
+    EXPECT_EQ(24 * 8928u + 11 * 744 + 30 * 24 + 23, dateAndHour);
+}
+
+TEST(RaceChronoProtocolTest, ConfigChunksRoundTrip)
+{
+    const std::string equation = "channel(device(gps), speed)*3.6+channel(device(lap), delta)";
+    std::string out;
+    size_t chunks = config_chunk_count(MONITOR_ADD, equation.size());
+    for (size_t chunk = 0; chunk < chunks; chunk++)
+    {
+        uint8_t bytes[CONFIG_CHUNK_MAX];
+        uint8_t len = encode_config_chunk(bytes, MONITOR_ADD, 7, equation.data(), equation.size(), chunk);
+        uint8_t cmd, monitorId, sequence, partLen;
+        const char* part;
+        ASSERT_TRUE(decode_config_chunk(bytes, len, cmd, monitorId, sequence, part, partLen));
+        EXPECT_EQ(chunk + 1 == chunks ? MONITOR_ADD : MONITOR_ADD_INCOMPLETE, cmd);
+        EXPECT_EQ(7, monitorId);
+        EXPECT_EQ(chunk, sequence);
+        out.append(part, partLen);
+    }
+    EXPECT_EQ(equation, out);
+
+    // Commands about every monitor are a single byte
+    uint8_t bytes[CONFIG_CHUNK_MAX];
+    ASSERT_EQ(1, encode_config_chunk(bytes, MONITOR_UPDATE_ALL, 0, nullptr, 0, 0));
+    EXPECT_EQ(MONITOR_UPDATE_ALL, bytes[0]);
+    ASSERT_EQ(CONFIG_HEADER_LEN, encode_config_chunk(bytes, MONITOR_REMOVE, 3, nullptr, 0, 0));
+    EXPECT_EQ(3, bytes[1]);
+    const uint8_t truncated[] = { MONITOR_REMOVE, 3 };
+    uint8_t cmd, monitorId, sequence, partLen;
+    const char* part;
+    EXPECT_FALSE(decode_config_chunk(truncated, sizeof(truncated), cmd, monitorId, sequence, part, partLen));
+}
+
+TEST(RaceChronoProtocolTest, ConfigResults)
+{
+    ConfigResult result;
+    const uint8_t ok[] = { MONITOR_RESULT_OK, 4 };
+    ASSERT_TRUE(decode_config_result(ok, sizeof(ok), result));
+    EXPECT_EQ(MONITOR_RESULT_OK, result.result);
+    EXPECT_EQ(4, result.monitor_id);
+    EXPECT_EQ(0, result.exception_type);
+    const uint8_t exception[] = { MONITOR_RESULT_EQUATION_EXCEPTION, 1, 0x01, 0x02 };
+    ASSERT_TRUE(decode_config_result(exception, sizeof(exception), result));
+    EXPECT_EQ(0x0102, result.exception_type);
+    EXPECT_FALSE(decode_config_result(ok, 1, result));
+}
+
+TEST(RaceChronoProtocolTest, MonitorValuesRoundTrip)
+{
+    const int32_t values[] = { 0, -1, 123456, INT32_MIN };
+    uint8_t bytes[sizeof(values) / sizeof(values[0]) * MONITOR_VALUE_LEN + 2];
+    size_t len = 0;
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        len = encode_monitor_value(bytes, i, (uint8_t)(i * 3), values[i]);
+    }
+    // Trailing partial values are ignored
+    ASSERT_EQ(4u, monitor_value_count(len + 2));
+    for (size_t i = 0; i < 4; i++)
+    {
+        EXPECT_EQ(i * 3, monitor_value_id(bytes, i));
+        EXPECT_EQ(values[i], monitor_value_raw(bytes, i));
+    }
+}
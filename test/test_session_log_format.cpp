@@ -0,0 +1,173 @@
+// Host tests for the GPS device's session log block format
+
+#include <string.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../examples/canbus-gps-device/main/SessionLogFormat.h"
+
+struct Frame
+{
+    uint32_t timeUs;
+    uint32_t packetId;
+    bool gps;
+    std::vector<uint8_t> data;
+};
+
+// Encode frames into as many blocks as needed
+static std::vector<std::vector<uint8_t>> encode(const std::vector<Frame>& frames)
+{
+    std::vector<std::vector<uint8_t>> blocks;
+    SessionLogEncoder encoder;
+    blocks.emplace_back(LOG_BLOCK_SIZE);
+    encoder.begin(blocks.back().data(), 0);
+    for (const Frame& frame : frames)
+    {
+        for (int attempt = 0; attempt < 2; attempt++)
+        {
+            bool added = frame.gps ?
+                encoder.addGps(frame.timeUs, frame.data.data(), frame.data.size()) :
+                encoder.addCan(frame.timeUs, frame.packetId, frame.data.data(), frame.data.size());
+            if (added)
+            {
+                break;
+            }
+            EXPECT_EQ(attempt, 0);
+            encoder.finish();
+            blocks.emplace_back(LOG_BLOCK_SIZE);
+            encoder.begin(blocks.back().data(), blocks.size() - 1);
+        }
+    }
+    encoder.finish();
+    return blocks;
+}
+
+// Decode all blocks back into frames
+static std::vector<Frame> decode(const std::vector<std::vector<uint8_t>>& blocks)
+{
+    std::vector<Frame> frames;
+    SessionLogDecoder decoder;
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+        EXPECT_TRUE(decoder.begin(blocks[i].data(), blocks[i].size()));
+        EXPECT_EQ(decoder.getSequence(), i);
+        SessionLogRecord record;
+        uint16_t count = 0;
+        while (decoder.next(record))
+        {
+            frames.push_back({ record.timeUs, record.packetId, record.type == LOG_RECORD_GPS,
+                std::vector<uint8_t>(record.data, record.data + record.len) });
+            count++;
+        }
+        EXPECT_EQ(count, decoder.getRecordCount());
+    }
+    return frames;
+}
+
+static void expectSame(const std::vector<Frame>& expected, const std::vector<Frame>& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        EXPECT_EQ(expected[i].timeUs, actual[i].timeUs) << i;
+        EXPECT_EQ(expected[i].packetId, actual[i].packetId) << i;
+        EXPECT_EQ(expected[i].gps, actual[i].gps) << i;
+        EXPECT_EQ(expected[i].data, actual[i].data) << i;
+    }
+}
+
+TEST(SessionLogFormat, CrcMatchesReference)
+{
+    const char* text = "123456789";
+    EXPECT_EQ(getSessionLogCrc((const uint8_t*)text, strlen(text)), 0xCBF43926u);
+    EXPECT_EQ(getSessionLogCrc((const uint8_t*)text + 4, 5,
+        getSessionLogCrc((const uint8_t*)text, 4)), 0xCBF43926u);
+}
+
+TEST(SessionLogFormat, BusTrafficRoundTrips)
+{
+    // A few ids at 4000 frames/s with a GPS fix every 200 ms, across a timer wrap
+    std::vector<Frame> frames;
+    uint32_t timeUs = 0xFFFFFFFFu - 3000000;
+    for (int i = 0; i < 40000; i++)
+    {
+        timeUs += 200 + (i * 37) % 150;
+        if (i % 800 == 0)
+        {
+            frames.push_back({ timeUs, 0, true, std::vector<uint8_t>(20, (uint8_t)i) });
+        }
+        uint32_t packetId = 0x100 + (i * 7) % 40;
+        std::vector<uint8_t> data(1 + i % 8);
+        for (size_t b = 0; b < data.size(); b++)
+        {
+            data[b] = (uint8_t)(i >> b);
+        }
+        frames.push_back({ timeUs, packetId, false, data });
+    }
+    std::vector<std::vector<uint8_t>> blocks = encode(frames);
+    EXPECT_GT(blocks.size(), 1u);
+    expectSame(frames, decode(blocks));
+}
+
+TEST(SessionLogFormat, DictionaryOverflowStillDecodes)
+{
+    std::vector<Frame> frames;
+    for (uint32_t i = 0; i < 600; i++)
+    {
+        frames.push_back({ i * 1000, 0x18DA0000u + i % 300, false, { (uint8_t)i } });
+    }
+    std::vector<std::vector<uint8_t>> blocks = encode(frames);
+    ASSERT_EQ(blocks.size(), 1u);
+    expectSame(frames, decode(blocks));
+}
+
+TEST(SessionLogFormat, SlowlyChangingFramesCompress)
+{
+    // 40 ids with a rolling counter, one slow signal and constant bytes, 1 kHz each
+    std::vector<Frame> frames;
+    uint32_t timeUs = 0;
+    for (int i = 0; i < 20000; i++)
+    {
+        timeUs += 25;
+        int id = i % 40;
+        int tick = i / 40;
+        std::vector<uint8_t> data = { (uint8_t)tick, (uint8_t)(tick / 50 + id), 0x12, 0x34,
+            (uint8_t)id, 0, 0, (uint8_t)(tick % 16 == 0 ? 0xFF : 0) };
+        frames.push_back({ timeUs, 0x200u + id, false, data });
+    }
+    SessionLogEncoder encoder;
+    std::vector<uint8_t> block(LOG_BLOCK_SIZE);
+    encoder.begin(block.data(), 0);
+    size_t count = 0;
+    while (count < frames.size() && encoder.addCan(frames[count].timeUs, frames[count].packetId,
+        frames[count].data.data(), frames[count].data.size()))
+    {
+        count++;
+    }
+    // 17 bytes uncompressed, the mask record takes 5 or 6
+    EXPECT_LT(encoder.getUsed() * 100 / encoder.getRawBytes(), 45u);
+    encoder.finish();
+    frames.resize(count);
+    expectSame(frames, decode({ block }));
+}
+
+TEST(SessionLogFormat, LengthChangeAndLongFramesRoundTrip)
+{
+    std::vector<Frame> frames;
+    for (uint32_t i = 0; i < 300; i++)
+    {
+        std::vector<uint8_t> data(i % 3 == 0 ? 8 : (i % 3 == 1 ? 4 : 48), (uint8_t)(i / 30));
+        frames.push_back({ i * 100, 0x300u + i % 3, false, data });
+        frames.push_back({ i * 100 + 50, 0x300u + i % 3, false, data });
+    }
+    expectSame(frames, decode(encode(frames)));
+}
+
+TEST(SessionLogFormat, CorruptBlockIsRejected)
+{
+    std::vector<std::vector<uint8_t>> blocks = encode({ { 5, 0x123, false, { 1, 2, 3 } } });
+    SessionLogDecoder decoder;
+    ASSERT_TRUE(decoder.begin(blocks[0].data(), blocks[0].size()));
+    blocks[0][LOG_HEADER_SIZE + 2] ^= 0x01;
+    EXPECT_FALSE(decoder.begin(blocks[0].data(), blocks[0].size()));
+    EXPECT_FALSE(decoder.begin(blocks[0].data(), LOG_HEADER_SIZE - 1));
+}
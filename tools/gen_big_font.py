@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""
+Generate the run-length encoded large-digit font of the remote display device.
+
+Glyphs are rasterized from 7-segment outlines with beveled segment ends, then
+stored as alternating background/foreground run lengths, starting with
+background. Runs longer than 255 pixels continue after a zero-length run of
+the other kind.
+
+Usage: gen_big_font.py > examples/remote-display-device/main/BigFontData.h
+"""
+
+WIDTH = 24
+HEIGHT = 40
+THICKNESS = 5
+MARGIN = 2
+
+SEGMENTS = {
+    '0': 'abcdef', '1': 'bc', '2': 'abdeg', '3': 'abcdg', '4': 'bcfg',
+    '5': 'acdfg', '6': 'acdefg', '7': 'abc', '8': 'abcdefg', '9': 'abcdfg',
+    '-': 'g', ' ': '',
+}
+
+
+def in_horizontal(x, y, x0, x1, cy):
+    d = abs(y - cy)
+    return d <= THICKNESS / 2 and x0 + d <= x <= x1 - d
+
+
+def in_vertical(x, y, y0, y1, cx):
+    d = abs(x - cx)
+    return d <= THICKNESS / 2 and y0 + d <= y <= y1 - d
+
+
+def segment_lit(segment, x, y):
+    half = THICKNESS / 2
+    left = MARGIN + half
+    right = WIDTH - 1 - MARGIN - half
+    top = MARGIN + half
+    bottom = HEIGHT - 1 - MARGIN - half
+    middle = (top + bottom) / 2
+    gap = 1
+    if segment == 'a':
+        return in_horizontal(x, y, left + gap, right - gap, top)
+    if segment == 'g':
+        return in_horizontal(x, y, left + gap, right - gap, middle)
+    if segment == 'd':
+        return in_horizontal(x, y, left + gap, right - gap, bottom)
+    if segment == 'f':
+        return in_vertical(x, y, top + gap, middle - gap, left)
+    if segment == 'b':
+        return in_vertical(x, y, top + gap, middle - gap, right)
+    if segment == 'e':
+        return in_vertical(x, y, middle + gap, bottom - gap, left)
+    if segment == 'c':
+        return in_vertical(x, y, middle + gap, bottom - gap, right)
+    return False
+
+
+def dot_lit(x, y, cy):
+    cx = (WIDTH - 1) / 2
+    return abs(x - cx) <= THICKNESS / 2 and abs(y - cy) <= THICKNESS / 2
+
+
+def pixel_lit(c, x, y):
+    if c == ':':
+        return dot_lit(x, y, HEIGHT * 0.3) or dot_lit(x, y, HEIGHT * 0.7)
+    if c == '.':
+        return dot_lit(x, y, HEIGHT - 1 - MARGIN - THICKNESS / 2)
+    return any(segment_lit(s, x, y) for s in SEGMENTS[c])
+
+
+def encode(c):
+    runs = []
+    lit = False
+    length = 0
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            if pixel_lit(c, x, y) != lit:
+                runs.append(length)
+                lit = not lit
+                length = 0
+            length += 1
+    runs.append(length)
+    data = []
+    for i, run in enumerate(runs):
+        while run > 255:
+            data += [255, 0]
+            run -= 255
+        data.append(run)
+    return data
+
+
+def main():
+    chars = sorted(set(SEGMENTS) | {':', '.'})
+    print('/*')
+    print(' * BigFontData.h')
+    print(' *')
+    print(' * Generated by tools/gen_big_font.py, do not edit')
+    print(' */')
+    print()
+    print('#ifndef BIGFONTDATA_H_')
+    print('#define BIGFONTDATA_H_')
+    print()
+    print('#define BIG_FONT_WIDTH %d' % WIDTH)
+    print('#define BIG_FONT_HEIGHT %d' % HEIGHT)
+    print()
+    offsets = []
+    print('static const uint8_t BIG_FONT_RUNS[] = {')
+    offset = 0
+    for c in chars:
+        data = encode(c)
+        offsets.append((c, offset, len(data)))
+        print("    // '%s'" % c)
+        for i in range(0, len(data), 16):
+            print('    ' + ', '.join(str(v) for v in data[i:i + 16]) + ',')
+        offset += len(data)
+    print('};')
+    print()
+    print('static const BigGlyph BIG_FONT_GLYPHS[] = {')
+    for c, offset, length in offsets:
+        print("    { '%s', %d, %d }," % (c, offset, length))
+    print('};')
+    print()
+    print('#endif')
+
+
+if __name__ == '__main__':
+    main()
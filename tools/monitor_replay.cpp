@@ -0,0 +1,291 @@
+// Replay a Monitor API trace recorded on the ESP32 through the real Monitor
+// code on the host.
+//
+// The equations are recovered from the recorded add messages, a Monitor is
+// built with them on the host BLE stand-in and the app's side of the trace
+// (subscribes, config results, value notifications, disconnects) is played
+// back in order. Config messages the host Monitor sends are compared against
+// the recorded ones, and the value notification path is timed.
+//
+// Usage: monitor_replay [-n repeat] trace.txt
+//
+// The trace is the output of Monitor::recorder.dump(), built with
+// -DRACECHRONO_MONITOR_RECORDER. Playback runs on virtual time following the
+// trace's timestamps, so the Monitor's retries and timeouts fire where they
+// would have on the device.
+//
+// Build: g++ -std=c++17 -O2 -Ihost/esp32 -Ihost/common -o monitor_replay
+//            tools/monitor_replay.cpp lib/esp32_racechrono.cpp
+//            lib/esp32_monitor_recorder.cpp host/esp32/host_esp32.cpp
+//            host/common/host_clock.cpp
+
+#include <chrono>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <host_ble.hpp>
+#include <host_clock.hpp>
+#include "../lib/esp32_racechrono.hpp"
+
+using ESP32RaceChrono::MonitorRecorder;
+using ESP32RaceChrono::TraceEntry;
+
+static const uint16_t CONFIG_UUID = 0x0005;
+static const uint16_t NOTIFY_UUID = 0x0006;
+
+struct Replay
+{
+    std::vector<std::string> sent;
+    size_t changes = 0;
+};
+
+static void onIndication(void* arg, uint16_t uuid, const uint8_t* data, size_t len)
+{
+    if (uuid == CONFIG_UUID)
+    {
+        ((Replay*)arg)->sent.push_back(std::string((const char*)data, len));
+    }
+}
+
+static void onValue(void* arg, size_t index, float value, int64_t arrivalUs)
+{
+    (void)index;
+    (void)value;
+    (void)arrivalUs;
+    ((Replay*)arg)->changes++;
+}
+
+static std::vector<TraceEntry> readTrace(const char* path)
+{
+    std::vector<TraceEntry> entries;
+    FILE* file = fopen(path, "r");
+    if (!file)
+    {
+        perror(path);
+        exit(1);
+    }
+    char line[256];
+    unsigned lineNumber = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        lineNumber++;
+        TraceEntry entry;
+        if (MonitorRecorder::parse_line(line, entry))
+        {
+            entries.push_back(entry);
+        }
+        else if (line[0] != '#' && line[0] != '\n')
+        {
+            fprintf(stderr, "%s:%u: skipping malformed line\n", path, lineNumber);
+        }
+    }
+    fclose(file);
+    return entries;
+}
+
+// Rebuild the equations from the chunked add messages (2 = more follows,
+// 3 = last chunk), the first complete copy of each id wins
+static std::vector<std::string> recoverEquations(const std::vector<TraceEntry>& entries)
+{
+    std::map<uint8_t, std::string> partial;
+    std::map<uint8_t, std::string> complete;
+    for (const TraceEntry& entry : entries)
+    {
+        if (entry.event != ESP32RaceChrono::TRACE_INDICATE_CONFIG || entry.len < 3 ||
+            (entry.data[0] != 2 && entry.data[0] != 3) || complete.count(entry.data[1]))
+        {
+            continue;
+        }
+        std::string& equation = partial[entry.data[1]];
+        if (entry.data[2] == 0)
+        {
+            equation.clear();
+        }
+        equation.append((const char*)entry.data + 3, entry.len - 3);
+        if (entry.data[0] == 3)
+        {
+            complete[entry.data[1]] = equation;
+        }
+    }
+    std::vector<std::string> equations;
+    for (auto& it : complete)
+    {
+        equations.resize(it.first + 1);
+        equations[it.first] = it.second;
+    }
+    return equations;
+}
+
+// Longest gap between consecutive events of a kind, and the longest time from
+// an equation add to the app's next config result
+static void printTiming(const std::vector<TraceEntry>& entries)
+{
+    int64_t lastNotifyUs = -1;
+    int64_t maxNotifyGapUs = 0;
+    int64_t pendingAddUs = -1;
+    int64_t maxConfigUs = 0;
+    for (const TraceEntry& entry : entries)
+    {
+        if (entry.event == ESP32RaceChrono::TRACE_WRITE_NOTIFY)
+        {
+            if (lastNotifyUs >= 0)
+            {
+                maxNotifyGapUs = std::max(maxNotifyGapUs, entry.time_us - lastNotifyUs);
+            }
+            lastNotifyUs = entry.time_us;
+        }
+        else if (entry.event == ESP32RaceChrono::TRACE_DISCONNECT)
+        {
+            lastNotifyUs = -1;
+            pendingAddUs = -1;
+        }
+        else if (entry.event == ESP32RaceChrono::TRACE_INDICATE_CONFIG && entry.len > 0 &&
+            entry.data[0] == 3 && pendingAddUs < 0)
+        {
+            pendingAddUs = entry.time_us;
+        }
+        else if (entry.event == ESP32RaceChrono::TRACE_WRITE_CONFIG && pendingAddUs >= 0)
+        {
+            maxConfigUs = std::max(maxConfigUs, entry.time_us - pendingAddUs);
+            pendingAddUs = -1;
+        }
+    }
+    fprintf(stderr, "trace: %zu events over %.3f s, max notify gap %.1f ms, max config round trip %.1f ms\n",
+        entries.size(), entries.empty() ? 0.0 : (entries.back().time_us - entries.front().time_us) / 1e6,
+        maxNotifyGapUs / 1e3, maxConfigUs / 1e3);
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: monitor_replay [-n repeat] trace.txt\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned repeat = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        if (opt == 'n' && atoi(optarg) > 0)
+        {
+            repeat = atoi(optarg);
+        }
+        else
+        {
+            usage();
+        }
+    }
+    if (optind + 1 != argc)
+    {
+        usage();
+    }
+
+    std::vector<TraceEntry> entries = readTrace(argv[optind]);
+    std::vector<std::string> equations = recoverEquations(entries);
+    printTiming(entries);
+    fprintf(stderr, "equations: %zu\n", equations.size());
+    for (size_t i = 0; i < equations.size(); i++)
+    {
+        fprintf(stderr, "  %zu: %s\n", i, equations[i].c_str());
+    }
+
+    // Passes follow each other a second apart in virtual time
+    int64_t startUs = entries.empty() ? 0 : entries.front().time_us;
+    int64_t passUs = entries.empty() ? 0 : entries.back().time_us - startUs + 1000000;
+    host_clock::use_virtual_time(startUs);
+
+    Replay replay;
+    host_ble::set_indication_listener(onIndication, &replay);
+    BLEDevice::init("replay");
+    BLEServer* server = BLEDevice::createServer();
+    ESP32RaceChrono::Monitor mon(server);
+    for (const std::string& equation : equations)
+    {
+        mon.add(equation);
+    }
+    mon.add_value_callback(onValue, &replay);
+    BLECharacteristic* configCh = host_ble::find_characteristic(server, CONFIG_UUID);
+    BLECharacteristic* notifyCh = host_ble::find_characteristic(server, NOTIFY_UUID);
+
+    // Play back the app's side, the first pass is the one compared
+    std::vector<std::string> recorded;
+    size_t notifications = 0;
+    size_t values = 0;
+    std::chrono::nanoseconds notifyTime(0);
+    size_t comparedSent = 0;
+    for (unsigned pass = 0; pass < repeat; pass++)
+    {
+        host_ble::connect(server);
+        for (const TraceEntry& entry : entries)
+        {
+            host_clock::advance_to_us(entry.time_us + pass * passUs);
+            switch (entry.event)
+            {
+            case ESP32RaceChrono::TRACE_INDICATE_CONFIG:
+                if (pass == 0)
+                {
+                    recorded.push_back(std::string((const char*)entry.data, entry.len));
+                }
+                break;
+            case ESP32RaceChrono::TRACE_WRITE_CONFIG:
+                host_ble::write(configCh, entry.data, entry.len);
+                break;
+            case ESP32RaceChrono::TRACE_WRITE_NOTIFY:
+            {
+                auto start = std::chrono::steady_clock::now();
+                host_ble::write(notifyCh, entry.data, entry.len);
+                notifyTime += std::chrono::steady_clock::now() - start;
+                notifications++;
+                values += entry.len / 5;
+                break;
+            }
+            case ESP32RaceChrono::TRACE_SUBSCRIBE:
+                if (server->getConnectedCount() == 0)
+                {
+                    host_ble::connect(server);
+                }
+                host_ble::subscribe(configCh);
+                break;
+            case ESP32RaceChrono::TRACE_DISCONNECT:
+                host_ble::disconnect(server);
+                break;
+            default:
+                break;
+            }
+        }
+        if (server->getConnectedCount() > 0)
+        {
+            host_ble::disconnect(server);
+        }
+        if (pass == 0)
+        {
+            comparedSent = replay.sent.size();
+        }
+    }
+    host_ble::set_indication_listener(nullptr, nullptr);
+
+    // The connect at the start sends nothing until the app subscribes, so
+    // both sequences line up from their first message
+    size_t matching = 0;
+    while (matching < recorded.size() && matching < comparedSent &&
+        recorded[matching] == replay.sent[matching])
+    {
+        matching++;
+    }
+    printf("config messages: recorded %zu, replayed %zu, first %zu identical\n",
+        recorded.size(), comparedSent, matching);
+    if (matching < recorded.size() || matching < comparedSent)
+    {
+        printf("first difference at message %zu\n", matching);
+    }
+    printf("notifications: %zu (%zu values, %zu changes), %.1f ns per notification, %.1f ns per value\n",
+        notifications, values, replay.changes,
+        notifications ? (double)notifyTime.count() / notifications : 0.0,
+        values ? (double)notifyTime.count() / values : 0.0);
+    printf("reconnect: %u ms\n", mon.last_reconnect_ms());
+    return matching == recorded.size() && matching == comparedSent ? 0 : 1;
+}
@@ -0,0 +1,416 @@
+// Decode session logs written by the GPS device's SessionLogger.
+//
+// The log is memory mapped and decoded in batches of blocks, each batch split
+// across threads that format into their own buffers, which are then written
+// in order. Blocks failing their checksum are skipped and counted.
+//
+// Usage: session_log_decode [-f candump|csv|columns] [-j threads] [-o out] log.rcl
+//
+//   candump  candump -L lines, GPS fixes are left out (default)
+//   csv      time_us,type,id,len,data with data in hex
+//   columns  directory of little-endian arrays, one file per column:
+//            can_time_us.u64 can_id.u32 can_len.u8 can_data.u8x8
+//            gps_time_us.u64 gps_data.u8x20
+//
+// Build: g++ -O2 -pthread -o session_log_decode tools/session_log_decode.cpp
+//            examples/canbus-gps-device/main/SessionLogFormat.cpp
+
+#include <chrono>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "../examples/canbus-gps-device/main/SessionLogFormat.h"
+
+enum Format
+{
+    FORMAT_CANDUMP,
+    FORMAT_CSV,
+    FORMAT_COLUMNS
+};
+
+static const size_t BATCH_BLOCKS = 4096;
+static const uint8_t CAN_COLUMN_DATA = 8;
+static const uint8_t GPS_COLUMN_DATA = 20;
+
+// Output of one thread for its share of a batch
+struct Chunk
+{
+    std::string text;
+    std::vector<uint64_t> canTimes;
+    std::vector<uint32_t> canIds;
+    std::vector<uint8_t> canLens;
+    std::vector<uint8_t> canData;
+    std::vector<uint64_t> gpsTimes;
+    std::vector<uint8_t> gpsData;
+    uint64_t records = 0;
+    uint64_t rawBytes = 0;
+    uint64_t invalidBlocks = 0;
+};
+
+struct Columns
+{
+    FILE* canTimes;
+    FILE* canIds;
+    FILE* canLens;
+    FILE* canData;
+    FILE* gpsTimes;
+    FILE* gpsData;
+};
+
+static const char HEX[] = "0123456789ABCDEF";
+
+static void appendHex(std::string& out, uint32_t value, int digits)
+{
+    char buffer[8];
+    for (int i = digits - 1; i >= 0; i--)
+    {
+        buffer[i] = HEX[value & 0xF];
+        value >>= 4;
+    }
+    out.append(buffer, digits);
+}
+
+static void appendBytes(std::string& out, const uint8_t* data, uint8_t len)
+{
+    for (uint8_t i = 0; i < len; i++)
+    {
+        out += HEX[data[i] >> 4];
+        out += HEX[data[i] & 0xF];
+    }
+}
+
+static void appendUnsigned(std::string& out, uint64_t value, int minDigits = 1)
+{
+    char buffer[24];
+    int pos = sizeof(buffer);
+    do
+    {
+        buffer[--pos] = '0' + value % 10;
+        value /= 10;
+        minDigits--;
+    } while (value > 0 || minDigits > 0);
+    out.append(buffer + pos, sizeof(buffer) - pos);
+}
+
+// Append one record in the text formats
+static void appendText(std::string& out, Format format, const SessionLogRecord& record, uint64_t timeUs)
+{
+    bool extended = record.packetId > 0x7FF;
+    if (format == FORMAT_CANDUMP)
+    {
+        if (record.type == LOG_RECORD_GPS)
+        {
+            return;
+        }
+        out += '(';
+        appendUnsigned(out, timeUs / 1000000);
+        out += '.';
+        appendUnsigned(out, timeUs % 1000000, 6);
+        out += ") can0 ";
+        appendHex(out, record.packetId, extended ? 8 : 3);
+        out += '#';
+        appendBytes(out, record.data, record.len);
+        out += '\n';
+        return;
+    }
+    appendUnsigned(out, timeUs);
+    if (record.type == LOG_RECORD_GPS)
+    {
+        out += ",gps,,";
+    }
+    else
+    {
+        out += ",can,";
+        appendHex(out, record.packetId, extended ? 8 : 3);
+        out += ',';
+    }
+    appendUnsigned(out, record.len);
+    out += ',';
+    appendBytes(out, record.data, record.len);
+    out += '\n';
+}
+
+// Append one record to the column arrays, payloads padded to a fixed width
+static void appendColumns(Chunk& chunk, const SessionLogRecord& record, uint64_t timeUs)
+{
+    if (record.type == LOG_RECORD_GPS)
+    {
+        chunk.gpsTimes.push_back(timeUs);
+        size_t pos = chunk.gpsData.size();
+        chunk.gpsData.resize(pos + GPS_COLUMN_DATA);
+        memcpy(&chunk.gpsData[pos], record.data, record.len < GPS_COLUMN_DATA ? record.len : GPS_COLUMN_DATA);
+        return;
+    }
+    chunk.canTimes.push_back(timeUs);
+    chunk.canIds.push_back(record.packetId);
+    chunk.canLens.push_back(record.len);
+    size_t pos = chunk.canData.size();
+    chunk.canData.resize(pos + CAN_COLUMN_DATA);
+    memcpy(&chunk.canData[pos], record.data, record.len < CAN_COLUMN_DATA ? record.len : CAN_COLUMN_DATA);
+}
+
+// Decode a range of blocks, the base times are already unwrapped to 64 bits
+static void decodeBlocks(const uint8_t* log, const uint64_t* baseTimes, size_t first, size_t last,
+    Format format, Chunk& chunk)
+{
+    SessionLogDecoder decoder;
+    for (size_t block = first; block < last; block++)
+    {
+        if (!decoder.begin(log + block * LOG_BLOCK_SIZE, LOG_BLOCK_SIZE))
+        {
+            chunk.invalidBlocks++;
+            continue;
+        }
+        uint32_t baseUs = (uint32_t)baseTimes[block];
+        SessionLogRecord record;
+        while (decoder.next(record))
+        {
+            // Within a block times only wrap once at most
+            uint64_t timeUs = baseTimes[block] + (uint32_t)(record.timeUs - baseUs);
+            chunk.records++;
+            chunk.rawBytes += 9 + record.len;
+            if (format == FORMAT_COLUMNS)
+            {
+                appendColumns(chunk, record, timeUs);
+            }
+            else
+            {
+                appendText(chunk.text, format, record, timeUs);
+            }
+        }
+    }
+}
+
+// Get 64-bit first record times of all blocks, assuming less than 71 minutes between blocks
+static std::vector<uint64_t> unwrapBaseTimes(const uint8_t* log, size_t blockCount)
+{
+    std::vector<uint64_t> baseTimes(blockCount);
+    uint64_t offset = 0;
+    uint32_t previous = 0;
+    bool hasPrevious = false;
+    for (size_t block = 0; block < blockCount; block++)
+    {
+        const uint8_t* header = log + block * LOG_BLOCK_SIZE;
+        uint32_t baseUs = header[8] | (header[9] << 8) | (header[10] << 16) | ((uint32_t)header[11] << 24);
+        if (memcmp(header, "RCL1", 4) != 0)
+        {
+            baseTimes[block] = offset + previous;
+            continue;
+        }
+        if (hasPrevious && baseUs < previous)
+        {
+            offset += 1ull << 32;
+        }
+        previous = baseUs;
+        hasPrevious = true;
+        baseTimes[block] = offset + baseUs;
+    }
+    return baseTimes;
+}
+
+static FILE* openColumn(const std::string& dir, const char* name)
+{
+    std::string path = dir + "/" + name;
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        perror(path.c_str());
+        exit(1);
+    }
+    return file;
+}
+
+template <typename T>
+static void writeColumn(FILE* file, const std::vector<T>& values)
+{
+    if (!values.empty())
+    {
+        fwrite(values.data(), sizeof(T), values.size(), file);
+    }
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: session_log_decode [-f candump|csv|columns] [-j threads] [-o out] log.rcl\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    Format format = FORMAT_CANDUMP;
+    unsigned threads = std::thread::hardware_concurrency();
+    const char* outPath = nullptr;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:j:o:")) != -1)
+    {
+        if (opt == 'f' && strcmp(optarg, "candump") == 0)
+        {
+            format = FORMAT_CANDUMP;
+        }
+        else if (opt == 'f' && strcmp(optarg, "csv") == 0)
+        {
+            format = FORMAT_CSV;
+        }
+        else if (opt == 'f' && strcmp(optarg, "columns") == 0)
+        {
+            format = FORMAT_COLUMNS;
+        }
+        else if (opt == 'j' && atoi(optarg) > 0)
+        {
+            threads = atoi(optarg);
+        }
+        else if (opt == 'o')
+        {
+            outPath = optarg;
+        }
+        else
+        {
+            usage();
+        }
+    }
+    if (optind + 1 != argc || (format == FORMAT_COLUMNS && !outPath))
+    {
+        usage();
+    }
+    threads = threads > 0 ? threads : 1;
+
+    // Map the log, a partially written last block is ignored
+    int fd = open(argv[optind], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    size_t blockCount = st.st_size / LOG_BLOCK_SIZE;
+    if (st.st_size % LOG_BLOCK_SIZE != 0)
+    {
+        fprintf(stderr, "ignoring %lu trailing bytes\n", (unsigned long)(st.st_size % LOG_BLOCK_SIZE));
+    }
+    const uint8_t* log = nullptr;
+    if (blockCount > 0)
+    {
+        void* mapped = mmap(nullptr, blockCount * LOG_BLOCK_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            perror("mmap");
+            return 1;
+        }
+        madvise(mapped, blockCount * LOG_BLOCK_SIZE, MADV_SEQUENTIAL);
+        log = (const uint8_t*)mapped;
+    }
+
+    FILE* text = nullptr;
+    Columns columns = {};
+    if (format == FORMAT_COLUMNS)
+    {
+        mkdir(outPath, 0777);
+        columns.canTimes = openColumn(outPath, "can_time_us.u64");
+        columns.canIds = openColumn(outPath, "can_id.u32");
+        columns.canLens = openColumn(outPath, "can_len.u8");
+        columns.canData = openColumn(outPath, "can_data.u8x8");
+        columns.gpsTimes = openColumn(outPath, "gps_time_us.u64");
+        columns.gpsData = openColumn(outPath, "gps_data.u8x20");
+    }
+    else
+    {
+        text = outPath ? fopen(outPath, "wb") : stdout;
+        if (!text)
+        {
+            perror(outPath);
+            return 1;
+        }
+        if (format == FORMAT_CSV)
+        {
+            fputs("time_us,type,id,len,data\n", text);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint64_t> baseTimes = unwrapBaseTimes(log, blockCount);
+    std::vector<Chunk> chunks(threads);
+    uint64_t records = 0;
+    uint64_t rawBytes = 0;
+    uint64_t invalidBlocks = 0;
+    for (size_t batch = 0; batch < blockCount; batch += BATCH_BLOCKS)
+    {
+        // Decode the batch in parallel, then write the chunks in block order
+        size_t batchEnd = batch + BATCH_BLOCKS < blockCount ? batch + BATCH_BLOCKS : blockCount;
+        size_t perThread = (batchEnd - batch + threads - 1) / threads;
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; t++)
+        {
+            size_t first = batch + t * perThread;
+            size_t last = first + perThread < batchEnd ? first + perThread : batchEnd;
+            chunks[t] = Chunk();
+            if (first < last)
+            {
+                workers.emplace_back(decodeBlocks, log, baseTimes.data(), first, last, format, std::ref(chunks[t]));
+            }
+        }
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+        for (Chunk& chunk : chunks)
+        {
+            if (format == FORMAT_COLUMNS)
+            {
+                writeColumn(columns.canTimes, chunk.canTimes);
+                writeColumn(columns.canIds, chunk.canIds);
+                writeColumn(columns.canLens, chunk.canLens);
+                writeColumn(columns.canData, chunk.canData);
+                writeColumn(columns.gpsTimes, chunk.gpsTimes);
+                writeColumn(columns.gpsData, chunk.gpsData);
+            }
+            else
+            {
+                fwrite(chunk.text.data(), 1, chunk.text.size(), text);
+            }
+            records += chunk.records;
+            rawBytes += chunk.rawBytes;
+            invalidBlocks += chunk.invalidBlocks;
+        }
+    }
+
+    if (format == FORMAT_COLUMNS)
+    {
+        for (FILE* file : { columns.canTimes, columns.canIds, columns.canLens, columns.canData,
+            columns.gpsTimes, columns.gpsData })
+        {
+            fclose(file);
+        }
+    }
+    else if (text != stdout)
+    {
+        fclose(text);
+    }
+    else
+    {
+        fflush(text);
+    }
+
+    // Statistics go to stderr so they never mix with stdout output
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t logBytes = (uint64_t)blockCount * LOG_BLOCK_SIZE;
+    fprintf(stderr, "%lu blocks, %lu invalid, %lu records, %.1f MB in %.3f s (%.0f MB/s)\n",
+        (unsigned long)blockCount, (unsigned long)invalidBlocks, (unsigned long)records,
+        logBytes / 1e6, seconds, seconds > 0 ? logBytes / 1e6 / seconds : 0.0);
+    if (rawBytes > 0)
+    {
+        fprintf(stderr, "log size %.1f%% of uncompressed\n", 100.0 * logBytes / rawBytes);
+    }
+    if (log)
+    {
+        munmap((void*)log, logBytes);
+    }
+    close(fd);
+    return 0;
+}